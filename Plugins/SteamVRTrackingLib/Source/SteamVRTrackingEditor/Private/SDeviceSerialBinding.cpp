@@ -18,6 +18,7 @@
 // Runtime Module
 #include "SteamVRTrackingSetup.h"
 #include "SteamVRFunctionLibrary.h"
+#include "SteamVRTrackingLib.h"
 
 #define LOCTEXT_NAMESPACE "DeviceSerialNumberBinding"
 
@@ -42,13 +43,93 @@ void SDeviceSerialBinding::Construct(const FArguments& InArgs)
 	{
 		ConstructWidget();
 
-		if (TrackedDeviceData->Id == INDEX_NONE) bTrackingStatus = false;
+		if (TrackedDeviceData->Id == INDEX_NONE)
+		{
+			bTrackingStatus = false;
+		}
+		else
+		{
+			StartStatusTimer();
+		}
+
+		// device ID only changes when devices are connected or disconnected
+		TopologyChangedHandle = FSteamVRTrackingLibModule::Get().OnDeviceTopologyChanged().AddSP(this, &SDeviceSerialBinding::OnDeviceTopologyChanged);
+	}
+}
+
+SDeviceSerialBinding::~SDeviceSerialBinding()
+{
+	if (TopologyChangedHandle.IsValid())
+	{
+		if (FSteamVRTrackingLibModule* TrackingLibModule = FModuleManager::GetModulePtr<FSteamVRTrackingLibModule>(TEXT("SteamVRTrackingLib")))
+		{
+			TrackingLibModule->OnDeviceTopologyChanged().Remove(TopologyChangedHandle);
+		}
+	}
+}
 
-		TSharedRef<FActiveTimerHandle> h = RegisterActiveTimer(
+void SDeviceSerialBinding::StartStatusTimer()
+{
+	if (!ActivePlayingTimer.IsValid())
+	{
+		ActivePlayingTimer = RegisterActiveTimer(
 			1.f,
 			FWidgetActiveTimerDelegate::CreateSP(this, &SDeviceSerialBinding::TimerUpdateWidget));
+	}
+}
+
+void SDeviceSerialBinding::OnDeviceTopologyChanged(const TArray<FSteamVRDeviceTopologyChange>& Changes)
+{
+	if (!TrackingSetupObject || !TrackedDeviceData)
+	{
+		return;
+	}
+
+	const int32 OldId = TrackedDeviceData->Id;
+	for (const FSteamVRDeviceTopologyChange& Change : Changes)
+	{
+		if (Change.Change == ESteamVRDeviceChange::Deactivated && Change.DeviceId == TrackedDeviceData->Id)
+		{
+			TrackedDeviceData->Id = INDEX_NONE;
+		}
+		else if (Change.Change == ESteamVRDeviceChange::Activated
+			&& USteamVRTrackingLibBPLibrary::IsTrackedDeviceSerialNumber(Change.DeviceId, TrackedDeviceData->SerialNumber))
+		{
+			TrackedDeviceData->Id = Change.DeviceId;
+		}
+	}
+
+	if (TrackedDeviceData->Id != OldId)
+	{
+		// disconnected devices don't need tracking status updates
+		if (TrackedDeviceData->Id == INDEX_NONE)
+		{
+			if (ActivePlayingTimer.IsValid())
+			{
+				UnRegisterActiveTimer(ActivePlayingTimer.ToSharedRef());
+				ActivePlayingTimer.Reset();
+			}
+			SetTrackingStatus(false);
+		}
+		else
+		{
+			StartStatusTimer();
+		}
+	}
+}
+
+void SDeviceSerialBinding::SetTrackingStatus(bool bNewTrackingStatus)
+{
+	if (bNewTrackingStatus != bTrackingStatus && TrackedDeviceData && TrackingStatusImage.IsValid())
+	{
+		bTrackingStatus = bNewTrackingStatus;
 
-		ActivePlayingTimer = h;
+		FString BrushName = (TrackedDeviceData->Type == ESteamVRTrackedDeviceType::Controller)
+			? TEXT("SteamVRTrackingLib.Device.MotionController")
+			: TEXT("SteamVRTrackingLib.Device.ViveTracker");
+		BrushName.Append(bTrackingStatus ? TEXT("On") : TEXT("Off"));
+
+		TrackingStatusImage->SetImage(FSteamVRTrackingStyle::Get()->GetBrush(FName(*BrushName)));
 	}
 }
 
@@ -296,29 +377,8 @@ EActiveTimerReturnType SDeviceSerialBinding::TimerUpdateWidget(double InCurrentT
 	{
 		if (TrackedDeviceData->Id > 0)
 		{
-			TArray<int32> ExistingIds;
-			USteamVRFunctionLibrary::GetValidTrackedDeviceIds(TrackedDeviceData->Type, ExistingIds);
-
-			bool bIsTracked = ExistingIds.Contains(TrackedDeviceData->Id);
-			if (bIsTracked)
-			{
-				FVector Loc;
-				FRotator Rot;
-				USteamVRFunctionLibrary::GetTrackedDevicePositionAndOrientation(TrackedDeviceData->Id, Loc, Rot);
-				if (Loc.IsZero()) bIsTracked = false;
-			}
-
-			if (bIsTracked != bTrackingStatus)
-			{
-				bTrackingStatus = bIsTracked;
-
-				FString BrushName = (TrackedDeviceData->Type == ESteamVRTrackedDeviceType::Controller)
-					? TEXT("SteamVRTrackingLib.Device.MotionController")
-					: TEXT("SteamVRTrackingLib.Device.ViveTracker");
-				BrushName.Append(bTrackingStatus ? TEXT("On") : TEXT("Off"));
-
-				TrackingStatusImage->SetImage(FSteamVRTrackingStyle::Get()->GetBrush(FName(*BrushName)));
-			}
+			const FSteamVRDevicePose* Pose = FSteamVRTrackingLibModule::Get().GetPoseCache().GetDevicePose(TrackedDeviceData->Id);
+			SetTrackingStatus(Pose && Pose->bConnected && Pose->bPoseValid && !Pose->Position.IsZero());
 		}
 
 		return EActiveTimerReturnType::Continue;
@@ -328,6 +388,7 @@ EActiveTimerReturnType SDeviceSerialBinding::TimerUpdateWidget(double InCurrentT
 		if (ActivePlayingTimer.IsValid())
 		{
 			UnRegisterActiveTimer(ActivePlayingTimer.ToSharedRef());
+			ActivePlayingTimer.Reset();
 		}
 		return EActiveTimerReturnType::Stop;
 	}
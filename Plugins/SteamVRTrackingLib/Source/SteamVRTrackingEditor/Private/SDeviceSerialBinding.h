@@ -6,6 +6,7 @@
 #include "Widgets/DeclarativeSyntaxSupport.h"
 #include "Widgets/SCompoundWidget.h"
 #include "SteamVRTrackingSetup.h"
+#include "SteamVRTrackingLib.h"
 
 class SEditableTextBox;
 class SImage;
@@ -34,6 +35,7 @@ public:
 	SLATE_END_ARGS()
 
 	void Construct(const FArguments& InArgs);
+	virtual ~SDeviceSerialBinding();
 	void ConstructWidget();
 
 	// General external functions
@@ -79,6 +81,12 @@ protected:
 
 	FText NameToText(const FName& NameData);
 
+	/* Tracking status is only polled while device is connected */
+	void StartStatusTimer();
+	void SetTrackingStatus(bool bNewTrackingStatus);
+	void OnDeviceTopologyChanged(const TArray<FSteamVRDeviceTopologyChange>& Changes);
+	FDelegateHandle TopologyChangedHandle;
+
 	TSharedPtr<class FActiveTimerHandle> ActivePlayingTimer;
 	// child widgets
 	TSharedPtr<SBorder> ExternalBox;
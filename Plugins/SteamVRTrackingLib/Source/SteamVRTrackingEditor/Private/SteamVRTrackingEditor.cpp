@@ -17,6 +17,9 @@
 #include "SteamVRTrackingSetup.h"
 #include "SteamVRTrackingStyle.h"
 #include "SteamVRTrackingLibBPLibrary.h"
+#include "ViveMocapTakeImport.h"
+#include "Animation/Skeleton.h"
+#include "Misc/Paths.h"
 
 #define LOCTEXT_NAMESPACE "FSteamVRTrackingEditor"
 
@@ -66,6 +69,22 @@ void FSteamVRTrackingEditor::StartupModule()
 			}));
 		}
 
+		if (SelectedAssets.ContainsByPredicate([](const FAssetData& AssetData) { return AssetData.GetClass() == USkeleton::StaticClass(); }))
+		{
+			Extender->AddMenuExtension(
+				"CommonAssetActions",
+				EExtensionHook::After,
+				CommandList,
+				FMenuExtensionDelegate::CreateLambda([this, SelectedAssets](FMenuBuilder& MenuBuilder)
+			{
+				MenuBuilder.AddMenuEntry(
+					LOCTEXT("STR_ImportMocapTake", "Import Vive Mocap Take..."),
+					LOCTEXT("STR_ImportMocapTakeToolTip", "Create animation sequence from mocap take recorded by EditorViveMocapController"),
+					FSlateIcon(),
+					FUIAction(FExecuteAction::CreateRaw(this, &FSteamVRTrackingEditor::ImportMocapTake, SelectedAssets)));
+			}));
+		}
+
 		return Extender;
 	}));
 	ContentBrowserMenuExtenderHandle = ContentBrowserModule.GetAllAssetViewContextMenuExtenders().Last().GetHandle();
@@ -160,6 +179,39 @@ void FSteamVRTrackingEditor::ImportTrackingSetupFromJson(TArray<FAssetData> Sele
 	}
 }
 
+void FSteamVRTrackingEditor::ImportMocapTake(TArray<FAssetData> SelectedAssets)
+{
+	IDesktopPlatform* const DesktopPlatform = FDesktopPlatformModule::Get();
+
+	const void* ParentWindowWindowHandle = FSlateApplication::Get().FindBestParentWindowHandleForDialogs(nullptr);
+
+	for (const auto& Asset : SelectedAssets)
+	{
+		if (Asset.GetClass() == USkeleton::StaticClass())
+		{
+			const FString DefaultPath = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("MocapTakes"));
+
+			TArray<FString> OutFiles;
+			if (DesktopPlatform->OpenFileDialog(
+				ParentWindowWindowHandle,
+				LOCTEXT("ImportMocapTakeTitle", "Choose mocap takes to import...").ToString(),
+				DefaultPath,
+				TEXT(""),
+				TEXT("Vive Mocap Take (*.vmrec)|*.vmrec"),
+				EFileDialogFlags::Multiple,
+				OutFiles
+			))
+			{
+				USkeleton* Skeleton = Cast<USkeleton>(Asset.GetAsset());
+				for (const FString& TakeFile : OutFiles)
+				{
+					FViveMocapTakeImport::ImportTake(TakeFile, Skeleton);
+				}
+			}
+		}
+	}
+}
+
 
 #undef LOCTEXT_NAMESPACE
 
@@ -0,0 +1,119 @@
+// (c) YuriNK (ykasczc@gmail.com), 2020. You're free to use it whatever way you want.
+
+#include "ViveMocapTakeImport.h"
+#include "Animation/AnimSequence.h"
+#include "Animation/AnimData/AnimDataModel.h"
+#include "Animation/AnimData/IAnimationDataController.h"
+#include "Animation/Skeleton.h"
+#include "AssetRegistry/AssetRegistryModule.h"
+#include "AssetToolsModule.h"
+#include "Misc/PackageName.h"
+#include "Misc/Paths.h"
+#include "ViveMocapRecording.h"
+
+#define LOCTEXT_NAMESPACE "FSteamVRTrackingEditor"
+
+UAnimSequence* FViveMocapTakeImport::ImportTake(const FString& FileName, USkeleton* Skeleton, int32 FrameRate)
+{
+	if (!Skeleton || FrameRate <= 0)
+	{
+		return nullptr;
+	}
+
+	FViveMocapTakeReader Reader;
+	if (!Reader.Open(FileName))
+	{
+		return nullptr;
+	}
+
+	const TArray<FName>& BoneNames = Reader.GetBoneNames();
+	const int32 NumBones = BoneNames.Num();
+
+	struct FTrackKeys
+	{
+		TArray<FVector3f> Positions;
+		TArray<FQuat4f> Rotations;
+		TArray<FVector3f> Scales;
+	};
+	TArray<FTrackKeys> Tracks;
+	Tracks.SetNum(NumBones);
+
+	// take frames have arbitrary timing, so keys are interpolated between two closest frames
+	const double KeyInterval = 1.0 / FrameRate;
+	TArray<FTransform> PreviousPose;
+	PreviousPose.SetNumUninitialized(NumBones);
+	double PreviousTime = -1.0;
+	int32 NumKeys = 0;
+
+	const bool bSuccess = Reader.ReadFrames([&](double Time, TArrayView<const FTransform> Pose)
+	{
+		if (PreviousTime < 0.0)
+		{
+			FMemory::Memcpy(PreviousPose.GetData(), Pose.GetData(), NumBones * sizeof(FTransform));
+			PreviousTime = Time;
+		}
+
+		for (double KeyTime = NumKeys * KeyInterval; KeyTime <= Time; KeyTime = ++NumKeys * KeyInterval)
+		{
+			const float Alpha = Time > PreviousTime ? (float)((KeyTime - PreviousTime) / (Time - PreviousTime)) : 1.f;
+			for (int32 Bone = 0; Bone < NumBones; Bone++)
+			{
+				FTransform Key;
+				Key.Blend(PreviousPose[Bone], Pose[Bone], FMath::Clamp(Alpha, 0.f, 1.f));
+
+				FTrackKeys& Track = Tracks[Bone];
+				Track.Positions.Add(FVector3f(Key.GetTranslation()));
+				Track.Rotations.Add(FQuat4f(Key.GetRotation()));
+				Track.Scales.Add(FVector3f(Key.GetScale3D()));
+			}
+		}
+
+		FMemory::Memcpy(PreviousPose.GetData(), Pose.GetData(), NumBones * sizeof(FTransform));
+		PreviousTime = Time;
+	});
+
+	if (!bSuccess || NumKeys < 2)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("ViveMocapTakeImport: take %s %s"), *FileName, bSuccess ? TEXT("is too short") : TEXT("is corrupted"));
+		return nullptr;
+	}
+
+	// new asset next to skeleton
+	FString PackageName, AssetName;
+	const FString BasePackageName = FPaths::Combine(FPackageName::GetLongPackagePath(Skeleton->GetOutermost()->GetName()), FPaths::GetBaseFilename(FileName));
+	FAssetToolsModule::GetModule().Get().CreateUniqueAssetName(BasePackageName, TEXT(""), PackageName, AssetName);
+
+	UPackage* Package = CreatePackage(*PackageName);
+	UAnimSequence* AnimSequence = NewObject<UAnimSequence>(Package, *AssetName, RF_Public | RF_Standalone);
+	AnimSequence->SetSkeleton(Skeleton);
+
+	const FReferenceSkeleton& RefSkeleton = Skeleton->GetReferenceSkeleton();
+	IAnimationDataController& Controller = AnimSequence->GetController();
+	Controller.OpenBracket(LOCTEXT("ImportMocapTake", "Import Vive Mocap Take"), false);
+	Controller.ResetModel(false);
+	Controller.SetFrameRate(FFrameRate(FrameRate, 1), false);
+	Controller.SetPlayLength((NumKeys - 1) * KeyInterval, false);
+
+	int32 NumTracks = 0;
+	for (int32 Bone = 0; Bone < NumBones; Bone++)
+	{
+		if (RefSkeleton.FindBoneIndex(BoneNames[Bone]) == INDEX_NONE)
+		{
+			continue;
+		}
+		const FTrackKeys& Track = Tracks[Bone];
+		Controller.AddBoneTrack(BoneNames[Bone], false);
+		Controller.SetBoneTrackKeys(BoneNames[Bone], Track.Positions, Track.Rotations, Track.Scales, false);
+		NumTracks++;
+	}
+	Controller.NotifyPopulated();
+	Controller.CloseBracket(false);
+
+	AnimSequence->MarkPackageDirty();
+	FAssetRegistryModule::AssetCreated(AnimSequence);
+
+	UE_LOG(LogTemp, Log, TEXT("ViveMocapTakeImport: %s imported to %s (%d keys, %d of %d bones)"), *FileName, *PackageName, NumKeys, NumTracks, NumBones);
+	return AnimSequence;
+}
+
+#undef LOCTEXT_NAMESPACE
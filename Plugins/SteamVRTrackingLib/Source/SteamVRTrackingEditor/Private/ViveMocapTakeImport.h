@@ -0,0 +1,17 @@
+// (c) YuriNK (ykasczc@gmail.com), 2020. You're free to use it whatever way you want.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UAnimSequence;
+class USkeleton;
+
+/** Creates animation sequence assets from mocap takes recorded by AEditorViveMocapController */
+struct FViveMocapTakeImport
+{
+	static constexpr int32 DefaultFrameRate = 60;
+
+	/** Resample take to FrameRate and save it as new animation sequence next to Skeleton. Bones missing in Skeleton are skipped. */
+	static UAnimSequence* ImportTake(const FString& FileName, USkeleton* Skeleton, int32 FrameRate = DefaultFrameRate);
+};
@@ -15,6 +15,7 @@ public:
 
 	void ExportTrackingSetupToJson(TArray<FAssetData> SelectedAssets);
 	void ImportTrackingSetupFromJson(TArray<FAssetData> SelectedAssets);
+	void ImportMocapTake(TArray<FAssetData> SelectedAssets);
 
 private:
 	TSharedPtr<FUICommandList> CommandList;
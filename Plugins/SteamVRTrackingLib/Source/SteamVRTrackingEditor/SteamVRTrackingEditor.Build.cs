@@ -23,7 +23,8 @@ namespace UnrealBuildTool.Rules
                     //"ContentBrowser",
                     "SlateCore",
                     "Slate",
-                    //"AssetRegistry",
+                    "AssetRegistry",
+                    "AssetTools",
                     "DesktopPlatform",
                     "Projects",
                     "SteamVR",
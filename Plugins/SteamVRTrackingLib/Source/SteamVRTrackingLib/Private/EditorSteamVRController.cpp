@@ -6,6 +6,8 @@
 #include "SteamVRTrackingSetup.h"
 #include "SteamVRFunctionLibrary.h"
 #include "SteamVRTrackingLibBPLibrary.h"
+#include "SteamVRTrackingLib.h"
+#include "SteamVRTrackingStats.h"
 
 AEditorSteamVRController::AEditorSteamVRController()
 {
@@ -13,6 +15,7 @@ AEditorSteamVRController::AEditorSteamVRController()
 	PrimaryActorTick.bStartWithTickEnabled = true;
 
 	RootComponent = CreateDefaultSubobject<USceneComponent>(TEXT("RootComponent"));
+	ObjectsTopologyVersion = MAX_uint32;
 }
 
 bool AEditorSteamVRController::EnsureUpdated()
@@ -50,22 +53,32 @@ void AEditorSteamVRController::Tick(float DeltaTime)
 	{
 		EnsureUpdated();
 
+		FSteamVRTrackingLibModule& TrackingLibModule = FSteamVRTrackingLibModule::Get();
+
+		// devices were connected or disconnected
+		const uint32 TopologyVersion = TrackingLibModule.GetDeviceTopologyVersion();
+		if (TopologyVersion != ObjectsTopologyVersion)
+		{
+			ObjectsTopologyVersion = TopologyVersion;
+			for (auto& Object : ObjectsToUpdate)
+			{
+				Object.DeviceId = USteamVRTrackingLibBPLibrary::GetDeviceIdByMotionSource(Object.MotionSource, true, ESteamVRTrackedDeviceType::Other);
+			}
+		}
+
+		FSteamVRDevicePoseCache& PoseCache = TrackingLibModule.GetPoseCache();
 		FVector loc;
 		FRotator rot;
 		for (auto& Object : ObjectsToUpdate)
 		{
 			if (Object.DeviceId == INDEX_NONE)
 			{
-				Object.DeviceId = USteamVRTrackingLibBPLibrary::GetDeviceIdByMotionSource(Object.MotionSource, true, ESteamVRTrackedDeviceType::Other);
-				if (Object.DeviceId == INDEX_NONE)
-				{
-					continue;
-				}
+				continue;
 			}
 
-			if (Object.AttachedComponent)
+			STEAMVR_TRACKING_COUNT(PosePolls, 1);
+			if (Object.AttachedComponent && PoseCache.GetDevicePositionAndOrientation(Object.DeviceId, loc, rot))
 			{
-				USteamVRFunctionLibrary::GetTrackedDevicePositionAndOrientation(Object.DeviceId, loc, rot);
 				Object.AttachedComponent->SetRelativeLocationAndRotation(loc, rot);
 			}
 		}
@@ -79,7 +92,7 @@ void AEditorSteamVRController::UpdateObjectsList()
 		USteamVRTrackingLibBPLibrary::SetSteamVRTrackingSetup(SteamVRTrackingSetup);
 	}
 
-	ObjectsToUpdate.Empty();
+	ObjectsToUpdate.Reset();
 
 	for (const auto& ObjectDesc : TrackedObjects)
 	{
@@ -88,13 +101,12 @@ void AEditorSteamVRController::UpdateObjectsList()
 			// get target component
 			USceneComponent* NewTarget = nullptr;
 
-			TArray<UActorComponent*> Components;
-			ObjectDesc.Value.Actor->GetComponents(Components);
-			for (const auto& Comp : Components)
+			TInlineComponentArray<USceneComponent*> Components(ObjectDesc.Value.Actor);
+			for (USceneComponent* Comp : Components)
 			{
 				if (Comp->GetFName().IsEqual(ObjectDesc.Value.ComponentName))
 				{
-					NewTarget = Cast<USceneComponent>(Comp);
+					NewTarget = Comp;
 					break;
 				}
 			}
@@ -112,6 +124,8 @@ void AEditorSteamVRController::UpdateObjectsList()
 			}
 		}
 	}
+
+	ObjectsTopologyVersion = FSteamVRTrackingLibModule::Get().GetDeviceTopologyVersion();
 }
 
 void AEditorSteamVRController::GetUpdatedObjects(TArray<FSteamVRTrackingBinding>& Objects) const
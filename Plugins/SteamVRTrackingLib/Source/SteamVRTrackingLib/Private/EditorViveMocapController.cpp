@@ -9,30 +9,66 @@
 #include "Components/PoseableMeshComponent.h"
 #include "Components/StaticMeshComponent.h"
 #include "Components/SkeletalMeshComponent.h"
+#include "Engine/SkeletalMesh.h"
 #include "Math/RotationMatrix.h"
 #include "Engine/Engine.h"
 #include "Kismet/GameplayStatics.h"
 #include "SessionCalibrationSave.h"
 #include "CaptureDevice.h"
 #include "DrawDebugHelpers.h"
+#include "SteamVRTrackingStats.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "Engine/Level.h"
+#include "Misc/Paths.h"
 
 #define RotatorDirection(Rotator, Axis) FRotationMatrix(Rotator).GetScaledAxis(Axis)
 #define ComponentForwardVector FRotationMatrix(FRotator::ZeroRotator).GetScaledAxis(ComponentSpaceSetup.ForwardAxis) * ComponentSpaceSetup.ForwardDirection
 #define ComponentRightVector FRotationMatrix(FRotator::ZeroRotator).GetScaledAxis(ComponentSpaceSetup.HorizontalAxis) * ComponentSpaceSetup.RightDirection
 #define ComponentUpVector FRotationMatrix(FRotator::ZeroRotator).GetScaledAxis(ComponentSpaceSetup.VerticalAxis) * ComponentSpaceSetup.UpDirection
 
+void FEditorViveMocapJoinTickFunction::ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
+{
+	if (Target)
+	{
+		Target->FinishAsyncCapture();
+	}
+}
+
+FString FEditorViveMocapJoinTickFunction::DiagnosticMessage()
+{
+	return TEXT("FEditorViveMocapJoinTickFunction");
+}
+
+//=============================================================================
+
 AEditorViveMocapController::AEditorViveMocapController()
 	: DefaultSkeletalMeshRotation(FRotator(0.f, -90.f, 0.f))
 	, CaptureType(EEditorCaptureType::CCT_PoseableMesh)
 	, bScaledCapture(true)
+	, bAsyncCapture(false)
 	, bDebug(false)
+	, TakeRotationTolerance(0.05f)
+	, TakeTranslationTolerance(0.01f)
 	, bEnabled(false)
 	, bInitialized(false)
 	, InputCompsNum(0)
+	, RightInputId(255)
+	, LeftInputId(255)
+	, bProxyInput(false)
+	, bAsyncSolveSkeletalMesh(false)
+	, PoseBufferLayoutVersion(0)
+	, PoseTargetLayoutVersion(MAX_uint32)
+	, TakeLayoutVersion(0)
 {
 	PrimaryActorTick.bCanEverTick = true;
 	PrimaryActorTick.bStartWithTickEnabled = true;
 
+	// capture meshes aren't simulated, so they can wait for the solve until physics is done
+	JoinTickFunction.bCanEverTick = true;
+	JoinTickFunction.bStartWithTickEnabled = true;
+	JoinTickFunction.bTickEvenWhenPaused = true;
+	JoinTickFunction.TickGroup = TG_PostPhysics;
+
 	RootComp = CreateDefaultSubobject<USceneComponent>(TEXT("RootComponent"));
 	RootComponent = RootComp;
 
@@ -53,36 +89,81 @@ void AEditorViveMocapController::BeginPlay()
 	Super::BeginPlay();
 }
 
+void AEditorViveMocapController::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	WaitForAsyncCapture();
+	StopTakeRecording();
+	Super::EndPlay(EndPlayReason);
+}
+
+void AEditorViveMocapController::BeginDestroy()
+{
+	WaitForAsyncCapture();
+	StopTakeRecording();
+	Super::BeginDestroy();
+}
+
+void AEditorViveMocapController::RegisterActorTickFunctions(bool bRegister)
+{
+	Super::RegisterActorTickFunctions(bRegister);
+
+	if (bRegister)
+	{
+		if (!JoinTickFunction.IsTickFunctionRegistered())
+		{
+			// capture meshes are moved to post physics group by this prerequisite
+			JoinTickFunction.Target = this;
+			JoinTickFunction.RegisterTickFunction(GetLevel());
+			JoinTickFunction.AddPrerequisite(this, PrimaryActorTick);
+			BodyMesh->PrimaryComponentTick.AddPrerequisite(this, JoinTickFunction);
+			SkeletalBodyMesh->PrimaryComponentTick.AddPrerequisite(this, JoinTickFunction);
+		}
+	}
+	else if (JoinTickFunction.IsTickFunctionRegistered())
+	{
+		WaitForAsyncCapture();
+		JoinTickFunction.UnRegisterTickFunction();
+	}
+}
+
 void AEditorViveMocapController::Tick(float DeltaTime)
 {
+	STEAMVR_TRACKING_SCOPE(STAT_SteamVRTracking_MocapTick);
 	Super::Tick(DeltaTime);
 
 	// Capture animation?
 	if (bEnabled)
 	{
-		CaptureDevice->TickComponent(DeltaTime, ELevelTick::LEVELTICK_TimeOnly, nullptr);
+		// normally joined by JoinTickFunction
+		FinishAsyncCapture();
 
-		if (CaptureType == EEditorCaptureType::CCT_SkeletalMesh && CaptureDevice->IsInitialized())
+		if (bProxyInput != bAsyncCapture)
 		{
-			CaptureDevice->GetSkeletalMeshPose(MeshPoseSnapshot, bScaledCapture);
-			SkeletalBodyMesh->SetWorldTransform(BodyMesh->GetComponentTransform());
+			InitializeCaptureInput(TrackerComponents, RightInputId, LeftInputId);
+		}
 
-			// update skeletal mesh
-			UAnimInstance* SkelAnimInstahce = SkeletalBodyMesh->GetAnimInstance();
-			if (SkelAnimInstahce)
-			{
-				if (UCaptureAnimBlueprint* CaptureAnimInst = Cast<UCaptureAnimBlueprint>(SkelAnimInstahce))
-				{
-					CaptureAnimInst->CaptureDevice = CaptureDevice;
-					CaptureAnimInst->bIsCaptureActive = true;
-					CaptureAnimInst->CurrentPose = MeshPoseSnapshot;
-				}
-			}
+		if (bAsyncCapture)
+		{
+			CopyTrackersToProxies();
+			StartAsyncCapture(DeltaTime);
 		}
 		else
 		{
-			CaptureDevice->UpdatePoseableMesh(bScaledCapture, BodyMesh);
-			CaptureDevice->GetLastPoseSnapshot(MeshPoseSnapshot);
+			CaptureDevice->TickComponent(DeltaTime, ELevelTick::LEVELTICK_TimeOnly, nullptr);
+
+			if (CaptureType == EEditorCaptureType::CCT_SkeletalMesh && CaptureDevice->IsInitialized())
+			{
+				CaptureDevice->GetSkeletalMeshPose(SolvedPose, bScaledCapture);
+				PoseBuffer.Submit(SolvedPose);
+				UpdateSkeletalBodyMesh();
+			}
+			else
+			{
+				CaptureDevice->UpdatePoseableMesh(bScaledCapture, BodyMesh);
+				CaptureDevice->GetLastPoseSnapshot(SolvedPose);
+				PoseBuffer.Submit(SolvedPose);
+			}
+			RecordCapturedPose();
 		}
 	}
 
@@ -99,9 +180,11 @@ void AEditorViveMocapController::Tick(float DeltaTime)
 
 	if (bDebug)
 	{
+		// capture device can be solving now, so its inputs are taken from the actor
+		const TArray<USceneComponent*>& Inputs = bProxyInput ? InputProxies : TrackerComponents;
 		for (int32 Index = 0; Index < InputCompsNum; Index++)
 		{
-			const USceneComponent* Comp = CaptureDevice->GetInputComponent(Index);
+			const USceneComponent* Comp = Inputs.IsValidIndex(Index) ? Inputs[Index] : nullptr;
 			if (Comp)
 			{
 				DrawDebugSphere(GetWorld(), Comp->GetComponentLocation(), 5, 3, FColor::Red, false, 0.05f, 0, 0.5f);
@@ -114,14 +197,267 @@ void AEditorViveMocapController::Tick(float DeltaTime)
 	}
 }
 
+void AEditorViveMocapController::InitializeCaptureInput(const TArray<USceneComponent*>& Trackers, uint8 RightId, uint8 LeftId)
+{
+	if (&Trackers != &TrackerComponents)
+	{
+		TrackerComponents = Trackers;
+	}
+	RightInputId = RightId;
+	LeftInputId = LeftId;
+	InputCompsNum = TrackerComponents.Num();
+	bProxyInput = bAsyncCapture;
+
+	if (!bProxyInput)
+	{
+		CaptureDevice->InitializeInputFromComponents(TrackerComponents, RightId, LeftId);
+		return;
+	}
+
+	// proxies aren't registered or attached, they only hold world transform of trackers
+	InputProxies.SetNum(TrackerComponents.Num());
+	for (int32 Index = 0; Index < TrackerComponents.Num(); Index++)
+	{
+		if (!TrackerComponents[Index])
+		{
+			InputProxies[Index] = nullptr;
+		}
+		else if (!InputProxies[Index])
+		{
+			InputProxies[Index] = NewObject<USceneComponent>(this, NAME_None, RF_Transient);
+			InputProxies[Index]->SetMobility(EComponentMobility::Movable);
+		}
+	}
+	CopyTrackersToProxies();
+	CaptureDevice->InitializeInputFromComponents(InputProxies, RightId, LeftId);
+}
+
+void AEditorViveMocapController::CopyTrackersToProxies()
+{
+	for (int32 Index = 0; Index < InputProxies.Num(); Index++)
+	{
+		if (InputProxies[Index] && IsValid(TrackerComponents[Index]))
+		{
+			InputProxies[Index]->SetWorldTransform(TrackerComponents[Index]->GetComponentTransform());
+		}
+	}
+}
+
+void AEditorViveMocapController::StartAsyncCapture(float DeltaTime)
+{
+	check(!SolveTask.IsValid());
+
+	bAsyncSolveSkeletalMesh = CaptureType == EEditorCaptureType::CCT_SkeletalMesh;
+	const bool bScaled = bScaledCapture;
+
+	// capture device only reads proxies, poseable mesh is updated on game thread when the task is joined
+	SolveTask = FFunctionGraphTask::CreateAndDispatchWhenReady([this, DeltaTime, bScaled]()
+	{
+		STEAMVR_TRACKING_SCOPE(STAT_SteamVRTracking_MocapSolve);
+		CaptureDevice->TickComponent(DeltaTime, ELevelTick::LEVELTICK_TimeOnly, nullptr);
+		if (CaptureDevice->IsInitialized())
+		{
+			CaptureDevice->GetSkeletalMeshPose(SolvedPose, bScaled);
+		}
+		else
+		{
+			SolvedPose.bIsValid = false;
+		}
+	}, TStatId(), nullptr, ENamedThreads::AnyHiPriThreadHiPriTask);
+}
+
+bool AEditorViveMocapController::WaitForAsyncCapture()
+{
+	if (!SolveTask.IsValid())
+	{
+		return false;
+	}
+
+	STEAMVR_TRACKING_SCOPE(STAT_SteamVRTracking_MocapSolveWait);
+	FTaskGraphInterface::Get().WaitUntilTaskCompletes(SolveTask, ENamedThreads::GameThread);
+	SolveTask = nullptr;
+	return true;
+}
+
+void AEditorViveMocapController::FinishAsyncCapture()
+{
+	if (!WaitForAsyncCapture() || !SolvedPose.bIsValid)
+	{
+		return;
+	}
+	PoseBuffer.Submit(SolvedPose);
+
+	if (bAsyncSolveSkeletalMesh)
+	{
+		UpdateSkeletalBodyMesh();
+	}
+	else
+	{
+		UpdatePoseableBodyMesh();
+	}
+	RecordCapturedPose();
+}
+
+void AEditorViveMocapController::StartTakeRecording(const FString& FileName)
+{
+	FString FullFileName = FileName.IsEmpty()
+		? FString::Printf(TEXT("%s_%s"), *GetName(), *FDateTime::Now().ToString(TEXT("%Y%m%d_%H%M%S_%s")))
+		: FileName;
+	if (FPaths::IsRelative(FullFileName))
+	{
+		FullFileName = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("MocapTakes"), FullFileName);
+	}
+	if (FPaths::GetExtension(FullFileName).IsEmpty())
+	{
+		FullFileName += TEXT(".vmrec");
+	}
+	if (FileName.IsEmpty())
+	{
+		// generated name shouldn't overwrite previous take
+		const FString BaseFileName = FPaths::GetBaseFilename(FullFileName, false);
+		for (int32 Suffix = 1; FPaths::FileExists(FullFileName); Suffix++)
+		{
+			FullFileName = FString::Printf(TEXT("%s_%d.vmrec"), *BaseFileName, Suffix);
+		}
+	}
+
+	StopTakeRecording();
+	if (!TakeRecorder.IsValid())
+	{
+		TakeRecorder = MakeUnique<FViveMocapRecorder>();
+	}
+	// bone layout is only known when pose is captured
+	PendingTakeFileName = FullFileName;
+}
+
+void AEditorViveMocapController::StopTakeRecording()
+{
+	PendingTakeFileName.Empty();
+	if (TakeRecorder.IsValid())
+	{
+		TakeRecorder->StopRecording();
+	}
+}
+
+bool AEditorViveMocapController::IsRecordingTake() const
+{
+	return !PendingTakeFileName.IsEmpty() || (TakeRecorder.IsValid() && TakeRecorder->IsRecording());
+}
+
+void AEditorViveMocapController::RecordCapturedPose()
+{
+	// recorder thread has already logged the error and stopped writing, so just join it
+	if (TakeRecorder.IsValid() && TakeRecorder->HasWriteError() && PendingTakeFileName.IsEmpty())
+	{
+		TakeRecorder->StopRecording();
+	}
+
+	if (!IsRecordingTake())
+	{
+		return;
+	}
+
+	if (!PoseBuffer.IsValid())
+	{
+		return;
+	}
+
+	if (!PendingTakeFileName.IsEmpty())
+	{
+		if (!TakeRecorder->StartRecording(PendingTakeFileName, PoseBuffer.GetBoneNames(), TakeRotationTolerance, TakeTranslationTolerance))
+		{
+			PendingTakeFileName.Empty();
+			return;
+		}
+		UE_LOG(LogTemp, Log, TEXT("AEditorViveMocapController: recording take %s"), *PendingTakeFileName);
+		PendingTakeFileName.Empty();
+		TakeLayoutVersion = PoseBuffer.GetLayoutVersion();
+	}
+	else if (TakeLayoutVersion != PoseBuffer.GetLayoutVersion())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("AEditorViveMocapController: skeleton of captured pose was changed, take recording is stopped"));
+		StopTakeRecording();
+		return;
+	}
+
+	TakeRecorder->PushPose(PoseBuffer.GetPose(), FPlatformTime::Seconds());
+}
+
+void AEditorViveMocapController::UpdateSkeletalBodyMesh()
+{
+	SkeletalBodyMesh->SetWorldTransform(BodyMesh->GetComponentTransform());
+
+	// update skeletal mesh
+	UAnimInstance* SkelAnimInstahce = SkeletalBodyMesh->GetAnimInstance();
+	if (SkelAnimInstahce)
+	{
+		if (UCaptureAnimBlueprint* CaptureAnimInst = Cast<UCaptureAnimBlueprint>(SkelAnimInstahce))
+		{
+			CaptureAnimInst->CaptureDevice = CaptureDevice;
+			CaptureAnimInst->bIsCaptureActive = true;
+			// anim instance keeps its own snapshot, so it gets one copy of transforms
+			if (PoseTargetAnimInstance.Get() != CaptureAnimInst)
+			{
+				PoseTargetAnimInstance = CaptureAnimInst;
+				PoseTargetLayoutVersion = MAX_uint32;
+			}
+			PoseBuffer.CopyToSnapshot(CaptureAnimInst->CurrentPose, PoseTargetLayoutVersion);
+		}
+	}
+}
+
+void AEditorViveMocapController::UpdatePoseableBodyMesh()
+{
+	if (!UpdateBoneIndices())
+	{
+		return;
+	}
+
+	const TArray<FName>& BoneNames = PoseBuffer.GetBoneNames();
+	const TArray<FTransform>& Pose = PoseBuffer.GetPose();
+	const int32 BonesNum = BoneNames.Num();
+	if (PoseBufferLayoutVersion != PoseBuffer.GetLayoutVersion() || PoseBufferBoneIndices.Num() != BonesNum)
+	{
+#if ENGINE_MAJOR_VERSION > 4 || ENGINE_MINOR_VERSION > 26
+		const FReferenceSkeleton& RefSkeleton = BodyMesh->SkeletalMesh->GetRefSkeleton();
+#else
+		const FReferenceSkeleton& RefSkeleton = BodyMesh->SkeletalMesh->RefSkeleton;
+#endif
+		PoseBufferBoneIndices.SetNumUninitialized(BonesNum);
+		for (int32 Index = 0; Index < BonesNum; Index++)
+		{
+			PoseBufferBoneIndices[Index] = RefSkeleton.FindBoneIndex(BoneNames[Index]);
+		}
+		PoseBufferLayoutVersion = PoseBuffer.GetLayoutVersion();
+	}
+
+	TArray<FTransform>& BoneSpaceTransforms = BodyMesh->BoneSpaceTransforms;
+	for (int32 Index = 0; Index < BonesNum; Index++)
+	{
+		const int32 BoneIndex = PoseBufferBoneIndices[Index];
+		if (BoneSpaceTransforms.IsValidIndex(BoneIndex))
+		{
+			BoneSpaceTransforms[BoneIndex] = Pose[Index];
+		}
+	}
+	BodyMesh->MarkRefreshTransformDirty();
+}
+
 void AEditorViveMocapController::InitializeDevice()
 {
+	WaitForAsyncCapture();
+
 	if (!IsValid(InputController))
 	{
 		UE_LOG(LogTemp, Warning, TEXT("AEditorViveMocapController. Invalid InputController Reference."));
 		return;
 	}
+	// capture device reads input components, so they should be moved first
+	AddTickPrerequisiteActor(InputController);
 
+	// bones map could be changed since last initialization
+	InvalidateBoneIndices();
+	PoseBuffer.Reset();
 	if (!BuildTPose())
 	{
 		UE_LOG(LogTemp, Warning, TEXT("AEditorViveMocapController. Can't build T-pose for mesh, check BodyMesh settings CaptureDevice bones map."));
@@ -157,8 +493,7 @@ void AEditorViveMocapController::InitializeDevice()
 
 	if (TrackerComps.Num() > 3)
 	{
-		CaptureDevice->InitializeInputFromComponents(TrackerComps, RightId, LeftId);
-		InputCompsNum = TrackerComps.Num();
+		InitializeCaptureInput(TrackerComps, RightId, LeftId);
 
 		bInitialized = CaptureDevice->IsInitialized();
 		UE_LOG(LogTemp, Log, TEXT("InitializeDevice. Result = %d"), (int32)bInitialized);
@@ -213,6 +548,8 @@ void AEditorViveMocapController::GetInputComponents(TArray<USceneComponent*>& In
 
 void AEditorViveMocapController::StartMocap()
 {
+	WaitForAsyncCapture();
+
 	if (!bInitialized)
 	{
 		UE_LOG(LogTemp, Warning, TEXT("AEditorViveMocapController: Actor wasn't initialized. Check InputController."));
@@ -250,8 +587,7 @@ void AEditorViveMocapController::StartMocap()
 		GetInputComponents(TrackerComps, RightId, LeftId);
 		if (TrackerComps.Num() == CaptureDevice->TrackersData.Num())
 		{
-			CaptureDevice->InitializeInputFromComponents(TrackerComps, RightId, LeftId);
-			InputCompsNum = TrackerComps.Num();
+			InitializeCaptureInput(TrackerComps, RightId, LeftId);
 		}
 		else
 		{
@@ -266,8 +602,32 @@ void AEditorViveMocapController::StartMocap()
 
 void AEditorViveMocapController::StopMocap()
 {
+	WaitForAsyncCapture();
+	StopTakeRecording();
 	CaptureDevice->ToggleCapture(false);
 	bEnabled = false;
+	PoseBuffer.Reset();
+}
+
+void AEditorViveMocapController::GetCapturedPose(FPoseSnapshot& OutPose) const
+{
+	PoseBuffer.CopyToSnapshot(OutPose);
+}
+
+FPoseSnapshot AEditorViveMocapController::GetMeshPoseSnapshot() const
+{
+	if (!PoseBuffer.IsValid())
+	{
+		return MeshPoseSnapshot;
+	}
+	FPoseSnapshot Pose;
+	PoseBuffer.CopyToSnapshot(Pose);
+	return Pose;
+}
+
+void AEditorViveMocapController::SetMeshPoseSnapshot(const FPoseSnapshot& Pose)
+{
+	MeshPoseSnapshot = Pose;
 }
 
 void AEditorViveMocapController::GetBodyCalibration(FBodyCalibrationData& OutCalibration)
@@ -284,10 +644,86 @@ void AEditorViveMocapController::GetBodyCalibration(FBodyCalibrationData& OutCal
 	}
 }
 
+int32 AEditorViveMocapController::GetHumanoidBoneIndex(EHumanoidBone Bone)
+{
+	if (!UpdateBoneIndices())
+	{
+		return INDEX_NONE;
+	}
+	const int32 Key = (int32)Bone;
+	return HumanoidBoneIndices.IsValidIndex(Key) ? HumanoidBoneIndices[Key] : INDEX_NONE;
+}
+
+bool AEditorViveMocapController::UpdateBoneIndices()
+{
+	USkeletalMesh* SkeletalMesh = BodyMesh->SkeletalMesh;
+	if (!SkeletalMesh)
+	{
+		InvalidateBoneIndices();
+		return false;
+	}
+	if (BoneIndicesMesh.Get() == SkeletalMesh)
+	{
+		return true;
+	}
+
+#if ENGINE_MAJOR_VERSION > 4 || ENGINE_MINOR_VERSION > 26
+	const FReferenceSkeleton& RefSkeleton = SkeletalMesh->GetRefSkeleton();
+#else
+	const FReferenceSkeleton& RefSkeleton = SkeletalMesh->RefSkeleton;
+#endif
+
+	HumanoidBoneIndices.Reset();
+	PoseBufferBoneIndices.Reset();
+	for (const auto& BoneMapping : CaptureDevice->SkeletonBonesMap)
+	{
+		const int32 Key = (int32)BoneMapping.Key;
+		// map isn't sorted by bone, so grow array keeping indices of bones which are already mapped
+		while (Key >= HumanoidBoneIndices.Num())
+		{
+			HumanoidBoneIndices.Add(INDEX_NONE);
+		}
+		HumanoidBoneIndices[Key] = RefSkeleton.FindBoneIndex(BoneMapping.Value);
+	}
+	BoneIndicesMesh = SkeletalMesh;
+	return true;
+}
+
+void AEditorViveMocapController::InvalidateBoneIndices()
+{
+	HumanoidBoneIndices.Reset();
+	PoseBufferBoneIndices.Reset();
+	BoneIndicesMesh.Reset();
+}
+
+void AEditorViveMocapController::SetBoneRotationCS(TArray<FTransform>& PoseCS, int32 BoneIndex, const FRotator& Rotation)
+{
+#if ENGINE_MAJOR_VERSION > 4 || ENGINE_MINOR_VERSION > 26
+	const FReferenceSkeleton& RefSkeleton = BodyMesh->SkeletalMesh->GetRefSkeleton();
+#else
+	const FReferenceSkeleton& RefSkeleton = BodyMesh->SkeletalMesh->RefSkeleton;
+#endif
+	PoseCS[BoneIndex].SetRotation(Rotation.Quaternion());
+
+	const int32 ParentIndex = RefSkeleton.GetParentIndex(BoneIndex);
+	BodyMesh->BoneSpaceTransforms[BoneIndex] = ParentIndex == INDEX_NONE ? PoseCS[BoneIndex] : PoseCS[BoneIndex].GetRelativeTransform(PoseCS[ParentIndex]);
+
+	// bones are sorted parent-first, so children of the bone are refreshed in one pass
+	for (int32 Index = BoneIndex + 1; Index < PoseCS.Num(); Index++)
+	{
+		const int32 Parent = RefSkeleton.GetParentIndex(Index);
+		if (Parent >= BoneIndex)
+		{
+			PoseCS[Index] = BodyMesh->BoneSpaceTransforms[Index] * PoseCS[Parent];
+		}
+	}
+	BodyMesh->MarkRefreshTransformDirty();
+}
+
 bool AEditorViveMocapController::BuildTPose()
 {
 	// can't update mesh?
-	if (!BodyMesh->SkeletalMesh)
+	if (!UpdateBoneIndices())
 	{
 		return false;
 	}
@@ -299,26 +735,39 @@ bool AEditorViveMocapController::BuildTPose()
 #else
 	const FReferenceSkeleton& RefSkeleton = BodyMesh->SkeletalMesh->RefSkeleton;
 #endif
-	const int32 BonesNum = RefSkeleton.GetRefBonePose().Num();
-
+	const TArray<FTransform>& RefBonePose = RefSkeleton.GetRefBonePose();
+	const int32 BonesNum = RefBonePose.Num();
+
+	// reference skeleton is sorted parent-first, so component space pose is built in a single pass
+	// and written to poseable mesh at once
+	TArray<FTransform> RefPoseCS;
+	RefPoseCS.SetNumUninitialized(BonesNum);
+	BodyMesh->BoneSpaceTransforms.SetNumUninitialized(BonesNum);
 	for (int32 BoneIndex = 0; BoneIndex < BonesNum; BoneIndex++)
 	{
-		const FName BoneName = RefSkeleton.GetBoneName(BoneIndex);
-		BodyMesh->SetBoneTransformByName(BoneName, RestoreRefBonePose_WS(BoneName), EBoneSpaces::WorldSpace);
+		FTransform BoneTransform = RefBonePose[BoneIndex];
+		BoneTransform.NormalizeRotation();
+		BodyMesh->BoneSpaceTransforms[BoneIndex] = BoneTransform;
+
+		const int32 ParentIndex = RefSkeleton.GetParentIndex(BoneIndex);
+		RefPoseCS[BoneIndex] = ParentIndex == INDEX_NONE ? BoneTransform : BoneTransform * RefPoseCS[ParentIndex];
 	}
+	BodyMesh->MarkRefreshTransformDirty();
 
-	const FName* UpperarmRight = CaptureDevice->SkeletonBonesMap.Find(EHumanoidBone::UpperarmRight);
-	const FName* LowerarmRight = CaptureDevice->SkeletonBonesMap.Find(EHumanoidBone::ForearmRight);
-	const FName* HandRight = CaptureDevice->SkeletonBonesMap.Find(EHumanoidBone::PalmRight);
-	const FName* UpperarmLeft = CaptureDevice->SkeletonBonesMap.Find(EHumanoidBone::UpperarmLeft);
-	const FName* LowerarmLeft = CaptureDevice->SkeletonBonesMap.Find(EHumanoidBone::ForearmLeft);
-	const FName* HandLeft = CaptureDevice->SkeletonBonesMap.Find(EHumanoidBone::PalmLeft);
+	const int32 UpperarmRight = GetHumanoidBoneIndex(EHumanoidBone::UpperarmRight);
+	const int32 LowerarmRight = GetHumanoidBoneIndex(EHumanoidBone::ForearmRight);
+	const int32 HandRight = GetHumanoidBoneIndex(EHumanoidBone::PalmRight);
+	const int32 UpperarmLeft = GetHumanoidBoneIndex(EHumanoidBone::UpperarmLeft);
+	const int32 LowerarmLeft = GetHumanoidBoneIndex(EHumanoidBone::ForearmLeft);
+	const int32 HandLeft = GetHumanoidBoneIndex(EHumanoidBone::PalmLeft);
 
-	if (UpperarmRight && LowerarmRight && HandRight && UpperarmLeft && LowerarmLeft && HandLeft)
+	if (UpperarmRight != INDEX_NONE && LowerarmRight != INDEX_NONE && HandRight != INDEX_NONE
+		&& UpperarmLeft != INDEX_NONE && LowerarmLeft != INDEX_NONE && HandLeft != INDEX_NONE)
 	{
 		// Find component forward axis (Y usually)
-		FTransform HandRTr = BodyMesh->GetBoneTransformByName(*HandRight, EBoneSpaces::WorldSpace);
-		FTransform HandLTr = BodyMesh->GetBoneTransformByName(*HandLeft, EBoneSpaces::WorldSpace);
+		const FTransform& ComponentTransform = BodyMesh->GetComponentTransform();
+		FTransform HandRTr = RefPoseCS[HandRight] * ComponentTransform;
+		FTransform HandLTr = RefPoseCS[HandLeft] * ComponentTransform;
 
 		// body forward in world space
 		const FVector SkMRight = (HandRTr.GetTranslation() - HandLTr.GetTranslation()).GetSafeNormal2D();
@@ -329,9 +778,9 @@ bool AEditorViveMocapController::BuildTPose()
 		ComponentSpaceSetup.VerticalAxis = FindCoDirection(BodyMesh->GetComponentRotation(), BodyMesh->GetUpVector(), ComponentSpaceSetup.UpDirection);
 
 		// Hands orientation
-		HandRTr = BodyMesh->GetBoneTransformByName(*HandRight, EBoneSpaces::ComponentSpace);
-		HandLTr = BodyMesh->GetBoneTransformByName(*HandLeft, EBoneSpaces::ComponentSpace);
-		FTransform UpperarmTr = BodyMesh->GetBoneTransformByName(*UpperarmRight, EBoneSpaces::ComponentSpace);
+		HandRTr = RefPoseCS[HandRight];
+		HandLTr = RefPoseCS[HandLeft];
+		FTransform UpperarmTr = RefPoseCS[UpperarmRight];
 
 		FVector HandForwardDirection = (HandRTr.GetTranslation() - UpperarmTr.GetTranslation()).GetSafeNormal();
 		if (FMath::Abs(FVector::DotProduct(FVector::UpVector, HandForwardDirection)) < 0.2f)
@@ -355,11 +804,11 @@ bool AEditorViveMocapController::BuildTPose()
 				RightHandSetup.ForwardAxis, ComponentRightVector * RightHandSetup.ForwardDirection,
 				RightHandSetup.HorizontalAxis, ComponentForwardVector * -1.f * RightHandSetup.RightDirection);
 
-			BodyMesh->SetBoneRotationByName(*UpperarmRight, HandRotFinalR, EBoneSpaces::ComponentSpace);
-			BodyMesh->SetBoneRotationByName(*LowerarmRight, HandRotFinalR, EBoneSpaces::ComponentSpace);
+			SetBoneRotationCS(RefPoseCS, UpperarmRight, HandRotFinalR);
+			SetBoneRotationCS(RefPoseCS, LowerarmRight, HandRotFinalR);
 
-			// left hand
-			UpperarmTr = BodyMesh->GetBoneTransformByName(*UpperarmLeft, EBoneSpaces::ComponentSpace);
+			// left hand, not affected by rotation of the right one
+			UpperarmTr = RefPoseCS[UpperarmLeft];
 			HandForwardDirection = (HandLTr.GetTranslation() - UpperarmTr.GetTranslation()).GetSafeNormal();
 
 			LeftHandSetup.ForwardAxis = FindCoDirection(UpperarmTr.Rotator(), HandForwardDirection, LeftHandSetup.ForwardDirection);
@@ -369,8 +818,8 @@ bool AEditorViveMocapController::BuildTPose()
 				LeftHandSetup.ForwardAxis, ComponentRightVector * -1.f * LeftHandSetup.ForwardDirection,
 				LeftHandSetup.HorizontalAxis, ComponentForwardVector * LeftHandSetup.RightDirection);
 
-			BodyMesh->SetBoneRotationByName(*UpperarmLeft, HandRotFinalL, EBoneSpaces::ComponentSpace);
-			BodyMesh->SetBoneRotationByName(*LowerarmLeft, HandRotFinalL, EBoneSpaces::ComponentSpace);
+			SetBoneRotationCS(RefPoseCS, UpperarmLeft, HandRotFinalL);
+			SetBoneRotationCS(RefPoseCS, LowerarmLeft, HandRotFinalL);
 		}
 	}
 	else
@@ -381,41 +830,6 @@ bool AEditorViveMocapController::BuildTPose()
 	return true;
 }
 
-FTransform AEditorViveMocapController::RestoreRefBonePose_WS(const FName& BoneName) const
-{
-#if ENGINE_MAJOR_VERSION > 4 || ENGINE_MINOR_VERSION > 26
-	const FReferenceSkeleton& RefSkeleton = BodyMesh->SkeletalMesh->GetRefSkeleton();
-#else
-	const FReferenceSkeleton& RefSkeleton = BodyMesh->SkeletalMesh->RefSkeleton;
-#endif
-	const TArray<FTransform>& RefPoseSpaceBaseTMs = RefSkeleton.GetRefBonePose();
-
-	// calculate world transform transform
-	int32 TransformIndex = RefSkeleton.FindBoneIndex(BoneName);
-	int32 ParentIndex = RefSkeleton.GetParentIndex(TransformIndex);
-	FTransform tr_bone = RefPoseSpaceBaseTMs[TransformIndex];
-	FTransform tr_par;
-
-	// stop on root
-	while (ParentIndex != INDEX_NONE)
-	{
-		TransformIndex = ParentIndex;
-
-		tr_par = RefPoseSpaceBaseTMs[TransformIndex];
-		tr_par.NormalizeRotation();
-
-		tr_bone.NormalizeRotation();
-		tr_bone = tr_bone * tr_par;
-
-		ParentIndex = RefSkeleton.GetParentIndex(TransformIndex);
-	}
-	// add component transform
-	tr_bone.NormalizeRotation();
-	tr_bone = tr_bone * BodyMesh->GetComponentTransform();
-
-	return tr_bone;
-}
-
 /* Helper for rig building. Find axis of rotator the closest to being parallel to the specified vectors. Returns +1.f in Multiplier if co-directed and -1.f otherwise */
 EAxis::Type AEditorViveMocapController::FindCoDirection(const FRotator& BoneRotator, const FVector& Direction, float& ResultMultiplier)
 {
@@ -0,0 +1,312 @@
+// (c) YuriNK (ykasczc@gmail.com), 2020. You're free to use it whatever way you want.
+
+#include "SteamVRDevicePoseCache.h"
+#include "SteamVRDeviceSource.h"
+#include "SteamVRTrackingStats.h"
+#include "Engine/Engine.h"
+#include "IXRTrackingSystem.h"
+#include "RenderingThread.h"
+
+void FSteamVRDevicePose::Predict(float Seconds, FVector& OutPosition, FQuat& OutOrientation) const
+{
+	OutPosition = Position + LinearVelocity * Seconds;
+
+	// angular velocity is in tracking space, so delta rotation is applied on the left
+	const float AngularSpeed = AngularVelocity.Size();
+	if (AngularSpeed > KINDA_SMALL_NUMBER)
+	{
+		OutOrientation = FQuat(AngularVelocity / AngularSpeed, AngularSpeed * Seconds) * Orientation;
+		OutOrientation.Normalize();
+	}
+	else
+	{
+		OutOrientation = Orientation;
+	}
+}
+
+FSteamVRDevicePoseCache::FSteamVRDevicePoseCache()
+	: FrameDuration(0.f)
+	, VsyncToPhotons(0.f)
+	, bDisplayTimingValid(false)
+{
+	BaseTransform.Write(FBaseTransform{ FQuat::Identity, FVector::ZeroVector });
+}
+
+const FSteamVRDevicePose* FSteamVRDevicePoseCache::GetDevicePose(int32 DeviceId, ESteamVRPoseSnapshot Snapshot)
+{
+	if (DeviceId < 0 || DeviceId >= MaxDevices)
+	{
+		return nullptr;
+	}
+	return &GetUpdatedSnapshot(Snapshot).Poses[DeviceId];
+}
+
+bool FSteamVRDevicePoseCache::GetDevicePositionAndOrientation(int32 DeviceId, FVector& OutPosition, FRotator& OutOrientation, float WorldToMetersScale, ESteamVRPoseSnapshot Snapshot, float PredictionSeconds)
+{
+	const FSteamVRDevicePose* Pose = GetDevicePose(DeviceId, Snapshot);
+	if (!Pose || !Pose->bPoseValid)
+	{
+		return false;
+	}
+
+	if (PredictionSeconds != 0.f)
+	{
+		FVector Position;
+		FQuat Orientation;
+		Pose->Predict(FMath::Clamp(PredictionSeconds, -MaxPredictionSeconds, MaxPredictionSeconds), Position, Orientation);
+		OutPosition = Position * WorldToMetersScale;
+		OutOrientation = Orientation.Rotator();
+	}
+	else
+	{
+		OutPosition = Pose->Position * WorldToMetersScale;
+		OutOrientation = Pose->Orientation.Rotator();
+	}
+	return true;
+}
+
+void FSteamVRDevicePoseCache::SetDeviceFilter(int32 DeviceId, const FSteamVRPoseFilterSettings& Settings)
+{
+	check(IsInGameThread());
+	GameThreadSnapshot.Filter.SetDeviceFilter(DeviceId, Settings);
+
+	ENQUEUE_RENDER_COMMAND(SetSteamVRLateUpdateFilter)(
+		[this, DeviceId, Settings](FRHICommandListImmediate& RHICmdList)
+	{
+		LateUpdateSnapshot.Filter.SetDeviceFilter(DeviceId, Settings);
+	});
+}
+
+void FSteamVRDevicePoseCache::ClearDeviceFilters()
+{
+	check(IsInGameThread());
+	GameThreadSnapshot.Filter.ClearDeviceFilters();
+
+	ENQUEUE_RENDER_COMMAND(ClearSteamVRLateUpdateFilters)(
+		[this](FRHICommandListImmediate& RHICmdList)
+	{
+		LateUpdateSnapshot.Filter.ClearDeviceFilters();
+	});
+}
+
+float FSteamVRDevicePoseCache::GetSecondsToPhotons(ESteamVRPoseSnapshot Snapshot)
+{
+	return GetUpdatedSnapshot(Snapshot).SecondsToPhotons;
+}
+
+uint64 FSteamVRDevicePoseCache::GetConnectedDevicesMask(ESteamVRPoseSnapshot Snapshot)
+{
+	return GetUpdatedSnapshot(Snapshot).ConnectedMask;
+}
+
+uint64 FSteamVRDevicePoseCache::QueryConnectedDevicesMask()
+{
+	check(IsInGameThread());
+
+	if (GameThreadSnapshot.FrameNumber == GFrameCounter)
+	{
+		return GameThreadSnapshot.ConnectedMask;
+	}
+
+	ISteamVRDeviceSource* Source = DeviceSource.Get();
+	if (!Source || !Source->IsAvailable())
+	{
+		return 0;
+	}
+
+	STEAMVR_TRACKING_COUNT(SourceQueries, 1);
+	FQuat BaseOrientation;
+	FVector BaseOffset;
+	GetBaseTransform(BaseOrientation, BaseOffset);
+	return Source->GetDevicePoses(BaseOrientation, BaseOffset, ConnectedQueryPoses);
+}
+
+void FSteamVRDevicePoseCache::GetBaseTransform(FQuat& OutBaseOrientation, FVector& OutBaseOffset) const
+{
+	FBaseTransform Base;
+	BaseTransform.Read(Base);
+	OutBaseOrientation = Base.Orientation;
+	OutBaseOffset = Base.Offset;
+}
+
+FSteamVRDevicePoseCache::FSnapshot& FSteamVRDevicePoseCache::GetUpdatedSnapshot(ESteamVRPoseSnapshot Snapshot)
+{
+	if (Snapshot == ESteamVRPoseSnapshot::LateUpdate)
+	{
+		if (LateUpdateSnapshot.FrameNumber != GFrameNumberRenderThread)
+		{
+			LateUpdateSnapshot.FrameNumber = GFrameNumberRenderThread;
+			Refresh(LateUpdateSnapshot, false);
+		}
+		return LateUpdateSnapshot;
+	}
+	else
+	{
+		if (GameThreadSnapshot.FrameNumber != GFrameCounter)
+		{
+			GameThreadSnapshot.FrameNumber = GFrameCounter;
+
+			// base transform is only safe to read on game thread
+			if (GEngine && GEngine->XRSystem.IsValid() && IsInGameThread())
+			{
+				BaseTransform.Write(FBaseTransform{ GEngine->XRSystem->GetBaseOrientation(), GEngine->XRSystem->GetBaseOffsetInMeters() });
+			}
+			Refresh(GameThreadSnapshot, true);
+
+			if (IsInGameThread())
+			{
+				UpdateTrackingStates(GameThreadSnapshot);
+			}
+		}
+		return GameThreadSnapshot;
+	}
+}
+
+void FSteamVRDevicePoseCache::Refresh(FSnapshot& Snapshot, bool bAddFrameLatency)
+{
+	STEAMVR_TRACKING_SCOPE(STAT_SteamVRTracking_PoseCacheRefresh);
+	STEAMVR_TRACKING_COUNT(SourceQueries, 1);
+
+	Snapshot.ConnectedMask = 0;
+
+	ISteamVRDeviceSource* Source = DeviceSource.Get();
+	if (!Source || !Source->IsAvailable())
+	{
+		for (FSteamVRDevicePose& Pose : Snapshot.Poses)
+		{
+			Pose.bConnected = Pose.bPoseValid = Pose.bOutOfRange = false;
+		}
+		return;
+	}
+
+	FQuat BaseOrientation;
+	FVector BaseOffset;
+	GetBaseTransform(BaseOrientation, BaseOffset);
+	Snapshot.ConnectedMask = Source->GetDevicePoses(BaseOrientation, BaseOffset, Snapshot.Poses);
+
+	const double Timestamp = FPlatformTime::Seconds();
+	Snapshot.Filter.Apply(Snapshot.Poses, (float)(Timestamp - Snapshot.Timestamp));
+	Snapshot.Timestamp = Timestamp;
+
+	// display timing properties are IPC calls, so only read them on game thread when HMD (re)connects
+	const bool bHMDConnected = (Snapshot.ConnectedMask & 1ull) != 0;
+	if (bHMDConnected != bDisplayTimingValid && IsInGameThread())
+	{
+		bDisplayTimingValid = bHMDConnected && Source->GetDisplayTiming(FrameDuration, VsyncToPhotons);
+	}
+
+	Snapshot.SecondsToPhotons = 0.f;
+	float SecondsSinceLastVsync;
+	if (bDisplayTimingValid && Source->GetTimeSinceLastVsync(SecondsSinceLastVsync))
+	{
+		// same estimate as recommended in OpenVR docs for GetDeviceToAbsoluteTrackingPose
+		Snapshot.SecondsToPhotons = FMath::Max(FrameDuration - SecondsSinceLastVsync, 0.f) + VsyncToPhotons;
+		if (bAddFrameLatency)
+		{
+			Snapshot.SecondsToPhotons += FrameDuration;
+		}
+	}
+}
+
+const FSteamVRDeviceTrackingState* FSteamVRDevicePoseCache::GetDeviceTrackingState(int32 DeviceId)
+{
+	check(IsInGameThread());
+
+	if (DeviceId < 0 || DeviceId >= MaxDevices)
+	{
+		return nullptr;
+	}
+	GetUpdatedSnapshot(ESteamVRPoseSnapshot::GameThread);
+	return &TrackingStates[DeviceId];
+}
+
+void FSteamVRDevicePoseCache::ResetDropoutStats()
+{
+	check(IsInGameThread());
+
+	for (FSteamVRDeviceTrackingState& TrackingState : TrackingStates)
+	{
+		TrackingState.NumDropouts = 0;
+		TrackingState.TotalDropoutSeconds = TrackingState.LongestDropoutSeconds = 0.0;
+	}
+}
+
+void FSteamVRDevicePoseCache::UpdateTrackingStates(const FSnapshot& Snapshot)
+{
+	const double Now = Snapshot.Timestamp;
+	for (int32 DeviceId = 0; DeviceId < MaxDevices; DeviceId++)
+	{
+		const FSteamVRDevicePose& Pose = Snapshot.Poses[DeviceId];
+		FSteamVRDeviceTrackingState& TrackingState = TrackingStates[DeviceId];
+
+		ESteamVRTrackingState NewState = ESteamVRTrackingState::Disconnected;
+		if (Pose.bConnected)
+		{
+			NewState = !Pose.bPoseValid ? ESteamVRTrackingState::Lost : (Pose.bOutOfRange ? ESteamVRTrackingState::InertialOnly : ESteamVRTrackingState::Tracked);
+		}
+
+		if (NewState == ESteamVRTrackingState::Tracked)
+		{
+			TrackingState.LastGoodPose = Pose;
+			TrackingState.LastGoodTime = Now;
+		}
+
+		if (NewState == TrackingState.State)
+		{
+			continue;
+		}
+
+		// dropout ends when tracking is regained or device disconnects; switching between inertial and lost continues it
+		const ESteamVRTrackingState OldState = TrackingState.State;
+		const bool bWasInDropout = TrackingState.IsInDropout();
+		TrackingState.State = NewState;
+		if (NewState == ESteamVRTrackingState::Disconnected)
+		{
+			// pose of previous connection can't be held
+			TrackingState.LastGoodPose = FSteamVRDevicePose();
+		}
+
+		if (!bWasInDropout && TrackingState.IsInDropout())
+		{
+			TrackingState.DropoutStartTime = OldState == ESteamVRTrackingState::Tracked ? TrackingState.LastGoodTime : Now;
+		}
+		else if (bWasInDropout && !TrackingState.IsInDropout())
+		{
+			const double DropoutSeconds = Now - TrackingState.DropoutStartTime;
+			TrackingState.NumDropouts++;
+			TrackingState.TotalDropoutSeconds += DropoutSeconds;
+			TrackingState.LongestDropoutSeconds = FMath::Max(TrackingState.LongestDropoutSeconds, DropoutSeconds);
+		}
+		TrackingState.StateStartTime = Now;
+	}
+}
+
+void FSteamVRDevicePoseCache::SetDeviceSource(const TSharedPtr<ISteamVRDeviceSource, ESPMode::ThreadSafe>& InDeviceSource)
+{
+	check(IsInGameThread());
+
+	// late update snapshot is refreshed on render thread
+	FlushRenderingCommands();
+	DeviceSource = InDeviceSource;
+	bDisplayTimingValid = false;
+	GameThreadSnapshot.FrameNumber = MAX_uint64;
+	for (FSteamVRDeviceTrackingState& TrackingState : TrackingStates)
+	{
+		TrackingState = FSteamVRDeviceTrackingState();
+	}
+	ENQUEUE_RENDER_COMMAND(ResetSteamVRLateUpdateSnapshot)(
+		[this](FRHICommandListImmediate& RHICmdList)
+	{
+		LateUpdateSnapshot.FrameNumber = MAX_uint64;
+	});
+}
+
+void FSteamVRDevicePoseCache::ApplyBaseTransform(FSteamVRDevicePose& Pose, const FQuat& BaseOrientation, const FVector& BaseOffset)
+{
+	const FQuat BaseInv = BaseOrientation.Inverse();
+	Pose.Position = BaseInv.RotateVector(Pose.Position - BaseOffset);
+	Pose.Orientation = BaseInv * Pose.Orientation;
+	Pose.Orientation.Normalize();
+	Pose.LinearVelocity = BaseInv.RotateVector(Pose.LinearVelocity);
+	Pose.AngularVelocity = BaseInv.RotateVector(Pose.AngularVelocity);
+}
@@ -0,0 +1,54 @@
+// (c) YuriNK (ykasczc@gmail.com), 2020. You're free to use it whatever way you want.
+
+#include "SteamVRDeviceRegistry.h"
+#include "RenderCommandFence.h"
+
+struct FSteamVRDeviceRegistry::FRetiredSnapshot
+{
+	TUniquePtr<const FSteamVRDeviceRegistrySnapshot> Snapshot;
+	/* Render thread finished all commands enqueued before the snapshot was replaced */
+	FRenderCommandFence Fence;
+	uint64 Frame;
+};
+
+FSteamVRDeviceRegistry::FSteamVRDeviceRegistry()
+	: Current(new FSteamVRDeviceRegistrySnapshot())
+{
+}
+
+FSteamVRDeviceRegistry::~FSteamVRDeviceRegistry()
+{
+	// owner makes sure there are no readers at shutdown
+	Retired.Empty();
+	delete Current.exchange(nullptr);
+}
+
+void FSteamVRDeviceRegistry::Publish(TUniquePtr<FSteamVRDeviceRegistrySnapshot> NewSnapshot)
+{
+	check(IsInGameThread());
+	check(NewSnapshot.IsValid());
+
+	const FSteamVRDeviceRegistrySnapshot* OldSnapshot = Current.exchange(NewSnapshot.Release(), std::memory_order_acq_rel);
+
+	TUniquePtr<FRetiredSnapshot> RetiredSnapshot = MakeUnique<FRetiredSnapshot>();
+	RetiredSnapshot->Snapshot.Reset(OldSnapshot);
+	RetiredSnapshot->Frame = GFrameCounter;
+	RetiredSnapshot->Fence.BeginFence();
+	Retired.Add(MoveTemp(RetiredSnapshot));
+}
+
+void FSteamVRDeviceRegistry::CollectRetired()
+{
+	check(IsInGameThread());
+
+	// snapshots are retired in order
+	int32 NumExpired = 0;
+	while (NumExpired < Retired.Num() && Retired[NumExpired]->Frame < GFrameCounter && Retired[NumExpired]->Fence.IsFenceComplete())
+	{
+		NumExpired++;
+	}
+	if (NumExpired > 0)
+	{
+		Retired.RemoveAt(0, NumExpired, false);
+	}
+}
@@ -0,0 +1,248 @@
+// (c) YuriNK (ykasczc@gmail.com), 2020. You're free to use it whatever way you want.
+
+#include "SteamVRMotionSourceResolver.h"
+#include "SteamVRTrackingLib.h"
+#include "SteamVRTrackingStats.h"
+#include "Features/IModularFeatures.h"
+#include "IMotionController.h"
+#include "Misc/CString.h"
+#include "Misc/StringBuilder.h"
+
+namespace MotionSourceResolverHelpers
+{
+	const float WorldToMetersScale = 100.f;
+	/* Max distance between motion source and SteamVR device, squared */
+	const float MaxDistanceSquared = 5.f * 5.f;
+}
+
+FSteamVRMotionSourceResolver::FSteamVRMotionSourceResolver(FSteamVRTrackingLibModule& InTrackingLibModule)
+	: TrackingLibModule(InTrackingLibModule)
+	, bMotionControllersDirty(true)
+	, VerificationFrame(MAX_uint64)
+	, NumVerifications(0)
+{
+	IModularFeatures::Get().OnModularFeatureRegistered().AddRaw(this, &FSteamVRMotionSourceResolver::OnModularFeatureChanged);
+	IModularFeatures::Get().OnModularFeatureUnregistered().AddRaw(this, &FSteamVRMotionSourceResolver::OnModularFeatureChanged);
+}
+
+FSteamVRMotionSourceResolver::~FSteamVRMotionSourceResolver()
+{
+	IModularFeatures::Get().OnModularFeatureRegistered().RemoveAll(this);
+	IModularFeatures::Get().OnModularFeatureUnregistered().RemoveAll(this);
+}
+
+bool FSteamVRMotionSourceResolver::IsMotionSource(const FName& Name)
+{
+	FCachedMotionSource Entry;
+	ParseMotionSource(Name, Entry);
+	return Entry.Kind != EMotionSourceKind::FriendlyName;
+}
+
+void FSteamVRMotionSourceResolver::Invalidate()
+{
+	Cache.Empty();
+}
+
+int32 FSteamVRMotionSourceResolver::GetDeviceIdByMotionSource(const FName& MotionSource, bool bAnyDeviceType, ESteamVRTrackedDeviceType DeviceType)
+{
+	check(IsInGameThread());
+
+	const TPair<FName, uint8> Key(MotionSource, bAnyDeviceType ? MAX_uint8 : (uint8)DeviceType);
+	FCachedMotionSource* Entry = Cache.Find(Key);
+	if (!Entry)
+	{
+		Entry = &Cache.Add(Key);
+		ParseMotionSource(MotionSource, *Entry);
+		Entry->DeviceId = INDEX_NONE;
+		Entry->TopologyVersion = MAX_uint32;
+		Entry->ResolvedFrame = MAX_uint64;
+		Entry->bResolvedByRole = false;
+	}
+
+	// using friendly name instead?
+	if (Entry->Kind == EMotionSourceKind::FriendlyName)
+	{
+		return TrackingLibModule.GetTrackedDeviceIdByName(MotionSource, false);
+	}
+
+	const uint32 TopologyVersion = TrackingLibModule.GetDeviceTopologyVersion();
+	if (Entry->TopologyVersion == TopologyVersion && (Entry->ResolvedFrame == GFrameCounter || Entry->bResolvedByRole))
+	{
+		return Entry->DeviceId;
+	}
+
+	// connected device keeps its ID, so there is nothing to reacquire while it's in dropout
+	if (Entry->TopologyVersion == TopologyVersion && Entry->DeviceId != INDEX_NONE)
+	{
+		if (VerificationFrame != GFrameCounter)
+		{
+			VerificationFrame = GFrameCounter;
+			NumVerifications = 0;
+		}
+
+		const FSteamVRDeviceTrackingState* TrackingState = TrackingLibModule.GetPoseCache().GetDeviceTrackingState(Entry->DeviceId);
+		if ((TrackingState && TrackingState->IsInDropout()) || NumVerifications >= MaxVerificationsPerFrame)
+		{
+			return Entry->DeviceId;
+		}
+		NumVerifications++;
+	}
+
+	STEAMVR_TRACKING_SCOPE(STAT_SteamVRTracking_MotionSourceResolve);
+	STEAMVR_TRACKING_COUNT(IdCacheMisses, 1);
+
+	const bool bTopologyChanged = (Entry->TopologyVersion != TopologyVersion);
+	Entry->TopologyVersion = TopologyVersion;
+	Entry->ResolvedFrame = GFrameCounter;
+	Entry->bResolvedByRole = false;
+
+	// hand controllers are identified by role, and role changes are tracked by the module
+	if ((Entry->Kind == EMotionSourceKind::Left || Entry->Kind == EMotionSourceKind::Right)
+		&& (bAnyDeviceType || DeviceType == ESteamVRTrackedDeviceType::Controller))
+	{
+		const int32 DeviceId = TrackingLibModule.GetDeviceIdByControllerRole(
+			Entry->Kind == EMotionSourceKind::Left ? ESteamVRControllerRole::LeftHand : ESteamVRControllerRole::RightHand);
+		if (DeviceId != INDEX_NONE)
+		{
+			Entry->DeviceId = DeviceId;
+			Entry->bResolvedByRole = true;
+			return DeviceId;
+		}
+	}
+
+	FVector Location;
+	if (GetMotionSourceLocation(MotionSource, Location))
+	{
+		// cheap check: is the cached device still at the motion source location?
+		if (!bTopologyChanged && Entry->DeviceId != INDEX_NONE)
+		{
+			const FSteamVRDevicePose* Pose = TrackingLibModule.GetPoseCache().GetDevicePose(Entry->DeviceId);
+			if (Pose && Pose->bPoseValid
+				&& FVector::DistSquared(Pose->Position * MotionSourceResolverHelpers::WorldToMetersScale, Location) <= MotionSourceResolverHelpers::MaxDistanceSquared)
+			{
+				return Entry->DeviceId;
+			}
+		}
+
+		Entry->DeviceId = FindNearestDevice(Location, bAnyDeviceType, DeviceType);
+	}
+	else if (Entry->Kind == EMotionSourceKind::Special)
+	{
+		Entry->DeviceId = FindSpecialTracker(Entry->SpecialIndex);
+	}
+	else
+	{
+		Entry->DeviceId = INDEX_NONE;
+	}
+
+	return Entry->DeviceId;
+}
+
+void FSteamVRMotionSourceResolver::ParseMotionSource(const FName& MotionSource, FCachedMotionSource& OutEntry)
+{
+	OutEntry.SpecialIndex = 0;
+
+	if (MotionSource.IsEqual(TEXT("Left")))
+	{
+		OutEntry.Kind = EMotionSourceKind::Left;
+	}
+	else if (MotionSource.IsEqual(TEXT("Right")))
+	{
+		OutEntry.Kind = EMotionSourceKind::Right;
+	}
+	else if (MotionSource.GetComparisonIndex() == FName(TEXT("Special")).GetComparisonIndex() && MotionSource.GetNumber() != NAME_NO_NUMBER_INTERNAL)
+	{
+		// FName keeps N of Special_N as number, so there is no string to parse
+		OutEntry.Kind = EMotionSourceKind::Special;
+		OutEntry.SpecialIndex = NAME_INTERNAL_TO_EXTERNAL(MotionSource.GetNumber());
+	}
+	else
+	{
+		// numbers FName doesn't split (e.g. Special_01) are parsed from inline buffer
+		TStringBuilder<64> szMotionSource;
+		MotionSource.AppendString(szMotionSource);
+		if (FStringView(szMotionSource).StartsWith(TEXT("Special_"), ESearchCase::CaseSensitive))
+		{
+			OutEntry.Kind = EMotionSourceKind::Special;
+			OutEntry.SpecialIndex = FCString::Atoi(szMotionSource.ToString() + 8);
+		}
+		else
+		{
+			OutEntry.Kind = EMotionSourceKind::FriendlyName;
+		}
+	}
+}
+
+bool FSteamVRMotionSourceResolver::GetMotionSourceLocation(const FName& MotionSource, FVector& OutLocation)
+{
+	if (bMotionControllersDirty)
+	{
+		MotionControllers = IModularFeatures::Get().GetModularFeatureImplementations<IMotionController>(IMotionController::GetModularFeatureName());
+		bMotionControllersDirty = false;
+	}
+
+	FRotator Rotation;
+	for (IMotionController* MotionController : MotionControllers)
+	{
+		if (MotionController != nullptr && MotionController->GetControllerOrientationAndPosition(0, MotionSource, Rotation, OutLocation, MotionSourceResolverHelpers::WorldToMetersScale))
+		{
+			return !OutLocation.IsZero();
+		}
+	}
+	return false;
+}
+
+int32 FSteamVRMotionSourceResolver::FindNearestDevice(const FVector& Location, bool bAnyDeviceType, ESteamVRTrackedDeviceType DeviceType)
+{
+	FSteamVRDevicePoseCache& PoseCache = TrackingLibModule.GetPoseCache();
+	float MinDistance = MotionSourceResolverHelpers::MaxDistanceSquared;
+	int32 MinId = INDEX_NONE;
+
+	auto TestDevices = [&PoseCache, &Location, &MinDistance, &MinId](const TArray<int32>& DeviceIds)
+	{
+		for (const int32 DeviceId : DeviceIds)
+		{
+			const FSteamVRDevicePose* Pose = PoseCache.GetDevicePose(DeviceId);
+			if (Pose && Pose->bPoseValid)
+			{
+				const float NewDistance = FVector::DistSquared(Pose->Position * MotionSourceResolverHelpers::WorldToMetersScale, Location);
+				if (NewDistance <= MinDistance)
+				{
+					MinDistance = NewDistance;
+					MinId = DeviceId;
+				}
+			}
+		}
+	};
+
+	if (bAnyDeviceType)
+	{
+		TestDevices(TrackingLibModule.GetConnectedDeviceIds(ESteamVRTrackedDeviceType::Controller));
+		TestDevices(TrackingLibModule.GetConnectedDeviceIds(ESteamVRTrackedDeviceType::Other));
+	}
+	else
+	{
+		TestDevices(TrackingLibModule.GetConnectedDeviceIds(DeviceType));
+	}
+
+	return MinId;
+}
+
+int32 FSteamVRMotionSourceResolver::FindSpecialTracker(int32 SpecialIndex)
+{
+	// trackers are sorted by device ID
+	const TArray<int32>& Trackers = TrackingLibModule.GetConnectedDeviceIds(ESteamVRTrackedDeviceType::Other);
+	if (SpecialIndex > 0 && Trackers.Num() >= SpecialIndex)
+	{
+		return Trackers[SpecialIndex - 1];
+	}
+	return INDEX_NONE;
+}
+
+void FSteamVRMotionSourceResolver::OnModularFeatureChanged(const FName& Type, IModularFeature* ModularFeature)
+{
+	if (Type == IMotionController::GetModularFeatureName())
+	{
+		bMotionControllersDirty = true;
+	}
+}
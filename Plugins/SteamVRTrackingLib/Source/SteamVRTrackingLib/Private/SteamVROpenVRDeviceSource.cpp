@@ -0,0 +1,194 @@
+// (c) YuriNK (ykasczc@gmail.com), 2020. You're free to use it whatever way you want.
+
+#include "SteamVROpenVRDeviceSource.h"
+#include "SteamVRDevicePoseCache.h"
+#include "openvr.h"
+
+namespace SteamVRPoseHelpers
+{
+	/* Same conversion as FSteamVRHMD::PoseToOrientationAndPosition, but in meters */
+	void ConvertPose(const vr::HmdMatrix34_t& InPose, const FQuat& BaseOrientation, const FVector& BaseOffset, FQuat& OutOrientation, FVector& OutPosition)
+	{
+		// rows and columns are swapped between vr::HmdMatrix34_t and FMatrix
+		FMatrix Pose = FMatrix(
+			FPlane(InPose.m[0][0], InPose.m[1][0], InPose.m[2][0], 0.0f),
+			FPlane(InPose.m[0][1], InPose.m[1][1], InPose.m[2][1], 0.0f),
+			FPlane(InPose.m[0][2], InPose.m[1][2], InPose.m[2][2], 0.0f),
+			FPlane(InPose.m[0][3], InPose.m[1][3], InPose.m[2][3], 1.0f));
+
+		if (!FMath::IsNearlyEqual(Pose.GetScaledAxis(EAxis::X).SizeSquared(), 1.f, KINDA_SMALL_NUMBER)
+			|| !FMath::IsNearlyEqual(Pose.GetScaledAxis(EAxis::Y).SizeSquared(), 1.f, KINDA_SMALL_NUMBER)
+			|| !FMath::IsNearlyEqual(Pose.GetScaledAxis(EAxis::Z).SizeSquared(), 1.f, KINDA_SMALL_NUMBER))
+		{
+			// the engine does the same: SteamVR apps (e.g. vr paint) can report matrices with scale
+			Pose.RemoveScaling();
+		}
+
+		const FQuat Orientation(Pose);
+		OutOrientation.X = -Orientation.Z;
+		OutOrientation.Y = Orientation.X;
+		OutOrientation.Z = Orientation.Y;
+		OutOrientation.W = -Orientation.W;
+
+		const FVector Position = FVector(-Pose.M[3][2], Pose.M[3][0], Pose.M[3][1]) - BaseOffset;
+		const FQuat BaseInv = BaseOrientation.Inverse();
+		OutPosition = BaseInv.RotateVector(Position);
+		OutOrientation = BaseInv * OutOrientation;
+		OutOrientation.Normalize();
+	}
+
+	/* OpenVR is right-handed, so angular velocity (pseudovector) flips sign after axes swap */
+	FORCEINLINE FVector ConvertLinearVelocity(const vr::HmdVector3_t& V, const FQuat& BaseOrientation)
+	{
+		return BaseOrientation.UnrotateVector(FVector(-V.v[2], V.v[0], V.v[1]));
+	}
+
+	FORCEINLINE FVector ConvertAngularVelocity(const vr::HmdVector3_t& V, const FQuat& BaseOrientation)
+	{
+		return BaseOrientation.UnrotateVector(FVector(V.v[2], -V.v[0], -V.v[1]));
+	}
+}
+
+bool FSteamVROpenVRDeviceSource::IsAvailable() const
+{
+	return vr::VRSystem() != nullptr;
+}
+
+uint64 FSteamVROpenVRDeviceSource::GetDevicePoses(const FQuat& BaseOrientation, const FVector& BaseOffset, FSteamVRDevicePose* OutPoses)
+{
+	vr::IVRSystem* SteamVRSystem = vr::VRSystem();
+	if (!SteamVRSystem)
+	{
+		return 0;
+	}
+
+	const vr::ETrackingUniverseOrigin Origin = vr::VRCompositor()
+		? vr::VRCompositor()->GetTrackingSpace()
+		: vr::TrackingUniverseStanding;
+
+	vr::TrackedDevicePose_t RawPoses[FSteamVRDevicePoseCache::MaxDevices];
+	SteamVRSystem->GetDeviceToAbsoluteTrackingPose(Origin, 0.f, RawPoses, FSteamVRDevicePoseCache::MaxDevices);
+
+	uint64 ConnectedMask = 0;
+	for (int32 DeviceId = 0; DeviceId < FSteamVRDevicePoseCache::MaxDevices; DeviceId++)
+	{
+		const vr::TrackedDevicePose_t& RawPose = RawPoses[DeviceId];
+		FSteamVRDevicePose& Pose = OutPoses[DeviceId];
+
+		Pose.bConnected = RawPose.bDeviceIsConnected;
+		Pose.bPoseValid = false;
+		Pose.bOutOfRange = RawPose.eTrackingResult == vr::TrackingResult_Running_OutOfRange;
+		if (RawPose.bDeviceIsConnected)
+		{
+			ConnectedMask |= (1ull << DeviceId);
+
+			if (RawPose.bPoseIsValid)
+			{
+				SteamVRPoseHelpers::ConvertPose(RawPose.mDeviceToAbsoluteTracking, BaseOrientation, BaseOffset, Pose.Orientation, Pose.Position);
+				Pose.LinearVelocity = SteamVRPoseHelpers::ConvertLinearVelocity(RawPose.vVelocity, BaseOrientation);
+				Pose.AngularVelocity = SteamVRPoseHelpers::ConvertAngularVelocity(RawPose.vAngularVelocity, BaseOrientation);
+				Pose.bPoseValid = true;
+			}
+		}
+	}
+	return ConnectedMask;
+}
+
+ESteamVRTrackedDeviceType FSteamVROpenVRDeviceSource::GetDeviceType(int32 DeviceId)
+{
+	vr::IVRSystem* SteamVRSystem = vr::VRSystem();
+	if (!SteamVRSystem)
+	{
+		return ESteamVRTrackedDeviceType::Invalid;
+	}
+
+	switch (SteamVRSystem->GetTrackedDeviceClass((vr::TrackedDeviceIndex_t)DeviceId))
+	{
+	case vr::TrackedDeviceClass_Controller:
+		return ESteamVRTrackedDeviceType::Controller;
+	case vr::TrackedDeviceClass_TrackingReference:
+		return ESteamVRTrackedDeviceType::TrackingReference;
+	case vr::TrackedDeviceClass_GenericTracker:
+		return ESteamVRTrackedDeviceType::Other;
+	default:
+		return ESteamVRTrackedDeviceType::Invalid;
+	}
+}
+
+ESteamVRControllerRole FSteamVROpenVRDeviceSource::GetControllerRole(int32 DeviceId)
+{
+	vr::IVRSystem* SteamVRSystem = vr::VRSystem();
+	if (!SteamVRSystem)
+	{
+		return ESteamVRControllerRole::Invalid;
+	}
+
+	switch (SteamVRSystem->GetControllerRoleForTrackedDeviceIndex((vr::TrackedDeviceIndex_t)DeviceId))
+	{
+	case vr::TrackedControllerRole_LeftHand:
+		return ESteamVRControllerRole::LeftHand;
+	case vr::TrackedControllerRole_RightHand:
+		return ESteamVRControllerRole::RightHand;
+	case vr::TrackedControllerRole_Invalid:
+		return ESteamVRControllerRole::Invalid;
+	default:
+		return ESteamVRControllerRole::Other;
+	}
+}
+
+bool FSteamVROpenVRDeviceSource::GetSerialNumber(int32 DeviceId, ANSICHAR* OutSerialNumber, int32 BufferSize)
+{
+	vr::IVRSystem* SteamVRSystem = vr::VRSystem();
+	if (!SteamVRSystem)
+	{
+		return false;
+	}
+
+	vr::ETrackedPropertyError OutError = vr::ETrackedPropertyError::TrackedProp_Success;
+	SteamVRSystem->GetStringTrackedDeviceProperty((vr::TrackedDeviceIndex_t)DeviceId, vr::Prop_SerialNumber_String, OutSerialNumber, BufferSize, &OutError);
+	if (OutError != vr::ETrackedPropertyError::TrackedProp_Success)
+	{
+		OutSerialNumber[0] = '\0';
+		return false;
+	}
+	return true;
+}
+
+bool FSteamVROpenVRDeviceSource::GetRenderModelName(int32 DeviceId, ANSICHAR* OutModelName, int32 BufferSize)
+{
+	vr::IVRSystem* SteamVRSystem = vr::VRSystem();
+	if (!SteamVRSystem)
+	{
+		return false;
+	}
+
+	vr::ETrackedPropertyError OutError = vr::ETrackedPropertyError::TrackedProp_Success;
+	SteamVRSystem->GetStringTrackedDeviceProperty((vr::TrackedDeviceIndex_t)DeviceId, vr::Prop_RenderModelName_String, OutModelName, BufferSize, &OutError);
+	if (OutError != vr::ETrackedPropertyError::TrackedProp_Success || OutModelName[0] == '\0')
+	{
+		OutModelName[0] = '\0';
+		return false;
+	}
+	return true;
+}
+
+bool FSteamVROpenVRDeviceSource::GetDisplayTiming(float& OutFrameDuration, float& OutVsyncToPhotons)
+{
+	vr::IVRSystem* SteamVRSystem = vr::VRSystem();
+	if (!SteamVRSystem)
+	{
+		return false;
+	}
+
+	const float DisplayFrequency = SteamVRSystem->GetFloatTrackedDeviceProperty(vr::k_unTrackedDeviceIndex_Hmd, vr::Prop_DisplayFrequency_Float);
+	OutFrameDuration = DisplayFrequency > 0.f ? 1.f / DisplayFrequency : 0.f;
+	OutVsyncToPhotons = SteamVRSystem->GetFloatTrackedDeviceProperty(vr::k_unTrackedDeviceIndex_Hmd, vr::Prop_SecondsFromVsyncToPhotons_Float);
+	return DisplayFrequency > 0.f;
+}
+
+bool FSteamVROpenVRDeviceSource::GetTimeSinceLastVsync(float& OutSeconds)
+{
+	vr::IVRSystem* SteamVRSystem = vr::VRSystem();
+	uint64 VsyncFrameCounter;
+	return SteamVRSystem && SteamVRSystem->GetTimeSinceLastVsync(&OutSeconds, &VsyncFrameCounter);
+}
@@ -0,0 +1,22 @@
+// (c) YuriNK (ykasczc@gmail.com), 2020. You're free to use it whatever way you want.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SteamVRDeviceSource.h"
+
+/** Reads devices from running SteamVR */
+class FSteamVROpenVRDeviceSource : public ISteamVRDeviceSource
+{
+public:
+	/** ISteamVRDeviceSource interface */
+	virtual FName GetSourceName() const override { return TEXT("OpenVR"); }
+	virtual bool IsAvailable() const override;
+	virtual uint64 GetDevicePoses(const FQuat& BaseOrientation, const FVector& BaseOffset, FSteamVRDevicePose* OutPoses) override;
+	virtual ESteamVRTrackedDeviceType GetDeviceType(int32 DeviceId) override;
+	virtual ESteamVRControllerRole GetControllerRole(int32 DeviceId) override;
+	virtual bool GetSerialNumber(int32 DeviceId, ANSICHAR* OutSerialNumber, int32 BufferSize) override;
+	virtual bool GetRenderModelName(int32 DeviceId, ANSICHAR* OutModelName, int32 BufferSize) override;
+	virtual bool GetDisplayTiming(float& OutFrameDuration, float& OutVsyncToPhotons) override;
+	virtual bool GetTimeSinceLastVsync(float& OutSeconds) override;
+};
@@ -0,0 +1,182 @@
+// (c) YuriNK (ykasczc@gmail.com), 2020. You're free to use it whatever way you want.
+
+#include "SteamVRPoseFilter.h"
+#include "SteamVRDevicePoseCache.h"
+#include "Math/VectorRegister.h"
+
+namespace SteamVRFilterHelpers
+{
+	/* Derivative cutoff of One-Euro filter (Hz) */
+	constexpr float DerivativeCutoff = 1.f;
+
+	/* One-Euro smoothing factor for cutoff frequency: r / (1 + r), r = 2 * PI * Cutoff * DeltaTime */
+	FORCEINLINE VectorRegister4Float SmoothingFactor(const VectorRegister4Float& Cutoff, const VectorRegister4Float& TwoPiDeltaTime)
+	{
+		const VectorRegister4Float R = VectorMultiply(Cutoff, TwoPiDeltaTime);
+		return VectorDivide(R, VectorAdd(R, GlobalVectorConstants::FloatOne));
+	}
+}
+
+FSteamVRPoseFilter::FSteamVRPoseFilter()
+{
+	ClearDeviceFilters();
+}
+
+void FSteamVRPoseFilter::SetDeviceFilter(int32 DeviceId, const FSteamVRPoseFilterSettings& Settings)
+{
+	if (DeviceId < 0 || DeviceId >= MaxDevices)
+	{
+		return;
+	}
+
+	const uint64 Bit = 1ull << DeviceId;
+	Type[DeviceId] = Settings.Type;
+	MinCutoff[DeviceId] = FMath::Max(Settings.MinCutoff, 0.01f);
+	Beta[DeviceId] = FMath::Max(Settings.Beta, 0.f);
+	SmoothTime[DeviceId] = FMath::Max(Settings.SmoothTime, 0.001f);
+
+	if (Settings.Type == ESteamVRPoseFilter::None)
+	{
+		ActiveMask &= ~Bit;
+	}
+	else
+	{
+		ActiveMask |= Bit;
+	}
+	InitializedMask &= ~Bit;
+}
+
+void FSteamVRPoseFilter::ClearDeviceFilters()
+{
+	FMemory::Memzero(Value);
+	FMemory::Memzero(Derivative);
+	FMemory::Memzero(Input);
+	FMemory::Memzero(LaneMode);
+	for (int32 DeviceId = 0; DeviceId < MaxDevices; DeviceId++)
+	{
+		Type[DeviceId] = ESteamVRPoseFilter::None;
+		MinCutoff[DeviceId] = 1.f;
+		Beta[DeviceId] = 0.f;
+		SmoothTime[DeviceId] = 1.f;
+	}
+	ActiveMask = 0;
+	InitializedMask = 0;
+}
+
+void FSteamVRPoseFilter::Apply(FSteamVRDevicePose* Poses, float DeltaTime)
+{
+	if (ActiveMask == 0)
+	{
+		return;
+	}
+	DeltaTime = FMath::Clamp(DeltaTime, 0.0001f, 0.1f);
+
+	// gather AoS poses to SoA lanes
+	const int32 NumDevices = 64 - FMath::CountLeadingZeros64(ActiveMask);
+	const int32 NumLanes = Align(NumDevices, 4);
+	for (int32 DeviceId = 0; DeviceId < NumLanes; DeviceId++)
+	{
+		const uint64 Bit = 1ull << DeviceId;
+		const FSteamVRDevicePose& Pose = Poses[DeviceId];
+		LaneMode[DeviceId] = 0.f;
+
+		if (!(ActiveMask & Bit) || !Pose.bPoseValid)
+		{
+			InitializedMask &= ~Bit;
+			continue;
+		}
+
+		FQuat Rotation = Pose.Orientation;
+		if (InitializedMask & Bit)
+		{
+			// keep quaternion in the same hemisphere as filtered value
+			const float Dot = Rotation.X * Value[3][DeviceId] + Rotation.Y * Value[4][DeviceId] + Rotation.Z * Value[5][DeviceId] + Rotation.W * Value[6][DeviceId];
+			if (Dot < 0.f)
+			{
+				Rotation = Rotation * -1.f;
+			}
+			LaneMode[DeviceId] = (float)Type[DeviceId];
+		}
+		Input[0][DeviceId] = (float)Pose.Position.X;
+		Input[1][DeviceId] = (float)Pose.Position.Y;
+		Input[2][DeviceId] = (float)Pose.Position.Z;
+		Input[3][DeviceId] = (float)Rotation.X;
+		Input[4][DeviceId] = (float)Rotation.Y;
+		Input[5][DeviceId] = (float)Rotation.Z;
+		Input[6][DeviceId] = (float)Rotation.W;
+	}
+
+	const VectorRegister4Float Zero = GlobalVectorConstants::FloatZero;
+	const VectorRegister4Float One = GlobalVectorConstants::FloatOne;
+	const VectorRegister4Float Two = VectorSetFloat1(2.f);
+	const VectorRegister4Float DeltaTimeV = VectorSetFloat1(DeltaTime);
+	const VectorRegister4Float InvDeltaTime = VectorSetFloat1(1.f / DeltaTime);
+	const VectorRegister4Float TwoPiDeltaTime = VectorSetFloat1(2.f * PI * DeltaTime);
+	const VectorRegister4Float DerivativeAlpha = SteamVRFilterHelpers::SmoothingFactor(VectorSetFloat1(SteamVRFilterHelpers::DerivativeCutoff), TwoPiDeltaTime);
+	const VectorRegister4Float ExpCoeff2 = VectorSetFloat1(0.48f);
+	const VectorRegister4Float ExpCoeff3 = VectorSetFloat1(0.235f);
+
+	for (int32 Lane = 0; Lane < NumLanes; Lane += 4)
+	{
+		const VectorRegister4Float Mode = VectorLoadAligned(&LaneMode[Lane]);
+		const VectorRegister4Float IsOneEuro = VectorCompareEQ(Mode, One);
+		const VectorRegister4Float IsDamped = VectorCompareEQ(Mode, Two);
+
+		// One-Euro: filtered derivatives and speed of position and rotation
+		VectorRegister4Float NewDerivative[NumChannels];
+		VectorRegister4Float SpeedSquared[2] = { Zero, Zero };
+		for (int32 Channel = 0; Channel < NumChannels; Channel++)
+		{
+			const VectorRegister4Float RawDerivative = VectorMultiply(VectorSubtract(VectorLoadAligned(&Input[Channel][Lane]), VectorLoadAligned(&Value[Channel][Lane])), InvDeltaTime);
+			const VectorRegister4Float PrevDerivative = VectorLoadAligned(&Derivative[Channel][Lane]);
+			NewDerivative[Channel] = VectorMultiplyAdd(DerivativeAlpha, VectorSubtract(RawDerivative, PrevDerivative), PrevDerivative);
+			SpeedSquared[Channel < 3 ? 0 : 1] = VectorMultiplyAdd(NewDerivative[Channel], NewDerivative[Channel], SpeedSquared[Channel < 3 ? 0 : 1]);
+		}
+		const VectorRegister4Float LaneMinCutoff = VectorLoadAligned(&MinCutoff[Lane]);
+		const VectorRegister4Float LaneBeta = VectorLoadAligned(&Beta[Lane]);
+		const VectorRegister4Float Alpha[2] =
+		{
+			SteamVRFilterHelpers::SmoothingFactor(VectorMultiplyAdd(LaneBeta, VectorSqrt(SpeedSquared[0]), LaneMinCutoff), TwoPiDeltaTime),
+			SteamVRFilterHelpers::SmoothingFactor(VectorMultiplyAdd(LaneBeta, VectorSqrt(SpeedSquared[1]), LaneMinCutoff), TwoPiDeltaTime)
+		};
+
+		// critically damped spring (exp approximation from Game Programming Gems 4)
+		const VectorRegister4Float Omega = VectorDivide(Two, VectorLoadAligned(&SmoothTime[Lane]));
+		const VectorRegister4Float X = VectorMultiply(Omega, DeltaTimeV);
+		const VectorRegister4Float Exp = VectorDivide(One, VectorMultiplyAdd(VectorMultiply(X, X), VectorMultiplyAdd(ExpCoeff3, X, ExpCoeff2), VectorAdd(One, X)));
+
+		for (int32 Channel = 0; Channel < NumChannels; Channel++)
+		{
+			const VectorRegister4Float Target = VectorLoadAligned(&Input[Channel][Lane]);
+			const VectorRegister4Float Previous = VectorLoadAligned(&Value[Channel][Lane]);
+			const VectorRegister4Float Velocity = VectorLoadAligned(&Derivative[Channel][Lane]);
+
+			const VectorRegister4Float OneEuroValue = VectorMultiplyAdd(Alpha[Channel < 3 ? 0 : 1], VectorSubtract(Target, Previous), Previous);
+
+			const VectorRegister4Float Change = VectorSubtract(Previous, Target);
+			const VectorRegister4Float Temp = VectorMultiply(VectorMultiplyAdd(Omega, Change, Velocity), DeltaTimeV);
+			const VectorRegister4Float DampedVelocity = VectorMultiply(VectorSubtract(Velocity, VectorMultiply(Omega, Temp)), Exp);
+			const VectorRegister4Float DampedValue = VectorMultiplyAdd(VectorAdd(Change, Temp), Exp, Target);
+
+			// lanes which aren't filtered this frame are reset to input
+			VectorStoreAligned(VectorSelect(IsOneEuro, OneEuroValue, VectorSelect(IsDamped, DampedValue, Target)), &Value[Channel][Lane]);
+			VectorStoreAligned(VectorSelect(IsOneEuro, NewDerivative[Channel], VectorSelect(IsDamped, DampedVelocity, Zero)), &Derivative[Channel][Lane]);
+		}
+	}
+
+	// scatter back
+	for (int32 DeviceId = 0; DeviceId < NumDevices; DeviceId++)
+	{
+		const uint64 Bit = 1ull << DeviceId;
+		if (!(ActiveMask & Bit) || !Poses[DeviceId].bPoseValid)
+		{
+			continue;
+		}
+		InitializedMask |= Bit;
+
+		FSteamVRDevicePose& Pose = Poses[DeviceId];
+		Pose.Position = FVector(Value[0][DeviceId], Value[1][DeviceId], Value[2][DeviceId]);
+		Pose.Orientation = FQuat(Value[3][DeviceId], Value[4][DeviceId], Value[5][DeviceId], Value[6][DeviceId]);
+		Pose.Orientation.Normalize();
+	}
+}
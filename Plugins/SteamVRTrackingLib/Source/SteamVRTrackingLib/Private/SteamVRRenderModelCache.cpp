@@ -0,0 +1,145 @@
+// (c) YuriNK (ykasczc@gmail.com), 2020. You're free to use it whatever way you want.
+
+#include "SteamVRRenderModelCache.h"
+#include "SteamVRTrackingLib.h"
+#include "Components/StaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/World.h"
+#include "GameFramework/WorldSettings.h"
+#include "Features/IModularFeatures.h"
+#include "IXRSystemAssets.h"
+#include "Materials/MaterialInterface.h"
+
+FName FSteamVRRenderModelCache::GetModelName(int32 DeviceId) const
+{
+	ISteamVRDeviceSource* DeviceSource = FSteamVRTrackingLibModule::Get().GetPoseCache().GetDeviceSource();
+	if (!DeviceSource || !DeviceSource->IsAvailable() || DeviceId == INDEX_NONE)
+	{
+		return NAME_None;
+	}
+
+	// render model names are short (e.g. {htc}vr_tracker_vive_1_0)
+	ANSICHAR ModelName[256];
+	if (!DeviceSource->GetRenderModelName(DeviceId, ModelName, UE_ARRAY_COUNT(ModelName)))
+	{
+		return NAME_None;
+	}
+	return FName(ModelName);
+}
+
+const FSteamVRRenderModel* FSteamVRRenderModelCache::RequestModel(const FName& ModelName, int32 DeviceId, UWorld* World)
+{
+	check(IsInGameThread());
+
+	if (ModelName.IsNone())
+	{
+		return nullptr;
+	}
+
+	FSteamVRRenderModel* Model = Models.Find(ModelName);
+	if (Model && (Model->State != FSteamVRRenderModel::EState::Loading || Model->Loader.IsValid()))
+	{
+		return Model;
+	}
+
+	// loader needs an owner actor; world settings live as long as the world
+	AActor* LoaderOwner = World ? World->GetWorldSettings() : nullptr;
+	if (!LoaderOwner)
+	{
+		return nullptr;
+	}
+
+	TArray<IXRSystemAssets*> XRAssetSystems = IModularFeatures::Get().GetModularFeatureImplementations<IXRSystemAssets>(IXRSystemAssets::GetModularFeatureName());
+	for (IXRSystemAssets* AssetSys : XRAssetSystems)
+	{
+		if (AssetSys->GetSystemName() != FName(TEXT("SteamVR")))
+		{
+			continue;
+		}
+
+		// load callback can be called before CreateRenderComponent returns, so the entry is added first
+		Models.FindOrAdd(ModelName) = FSteamVRRenderModel();
+		UPrimitiveComponent* Loader = AssetSys->CreateRenderComponent(DeviceId, LoaderOwner, RF_Transient, /*bForceSynchronous=*/false,
+			FXRComponentLoadComplete::CreateRaw(this, &FSteamVRRenderModelCache::OnModelLoaded, ModelName));
+
+		Model = Models.Find(ModelName);
+		if (!Loader)
+		{
+			Model->State = FSteamVRRenderModel::EState::Failed;
+		}
+		else if (Model->State == FSteamVRRenderModel::EState::Loading)
+		{
+			Model->Loader = Loader;
+		}
+		return Model;
+	}
+
+	return nullptr;
+}
+
+void FSteamVRRenderModelCache::OnModelLoaded(UPrimitiveComponent* LoadedComponent, FName ModelName)
+{
+	FSteamVRRenderModel* Model = Models.Find(ModelName);
+	if (!Model || Model->State != FSteamVRRenderModel::EState::Loading)
+	{
+		return;
+	}
+
+	const UStaticMeshComponent* MeshComponent = Cast<UStaticMeshComponent>(LoadedComponent);
+	if (MeshComponent && MeshComponent->GetStaticMesh())
+	{
+		Model->Mesh = MeshComponent->GetStaticMesh();
+		Model->Materials.Reset(MeshComponent->GetNumMaterials());
+		for (int32 MatIndex = 0; MatIndex < MeshComponent->GetNumMaterials(); ++MatIndex)
+		{
+			Model->Materials.Add(MeshComponent->GetMaterial(MatIndex));
+		}
+		Model->State = FSteamVRRenderModel::EState::Ready;
+		UE_LOG(LogTemp, Log, TEXT("SteamVRRenderModelCache: render model %s is loaded"), *ModelName.ToString());
+	}
+	else
+	{
+		Model->State = FSteamVRRenderModel::EState::Failed;
+	}
+
+	if (LoadedComponent)
+	{
+		LoadedComponent->DestroyComponent();
+	}
+	Model->Loader.Reset();
+}
+
+void FSteamVRRenderModelCache::PrewarmConnectedDevices(UWorld* World)
+{
+	check(IsInGameThread());
+
+	const uint64 ConnectedMask = FSteamVRTrackingLibModule::Get().GetPoseCache().GetConnectedDevicesMask();
+	for (int32 DeviceId = 0; DeviceId < FSteamVRDevicePoseCache::MaxDevices; DeviceId++)
+	{
+		if (ConnectedMask & (1ull << DeviceId))
+		{
+			RequestModel(GetModelName(DeviceId), DeviceId, World);
+		}
+	}
+}
+
+void FSteamVRRenderModelCache::Empty()
+{
+	for (auto& Model : Models)
+	{
+		if (UPrimitiveComponent* Loader = Model.Value.Loader.Get())
+		{
+			Loader->DestroyComponent();
+		}
+	}
+	Models.Empty();
+}
+
+void FSteamVRRenderModelCache::AddReferencedObjects(FReferenceCollector& Collector)
+{
+	for (auto& Model : Models)
+	{
+		Collector.AddReferencedObject(Model.Value.Mesh);
+		Collector.AddReferencedObjects(Model.Value.Materials);
+	}
+}
@@ -0,0 +1,371 @@
+// (c) YuriNK (ykasczc@gmail.com), 2020. You're free to use it whatever way you want.
+
+#include "SteamVRSimulatedDeviceSource.h"
+#include "SteamVRDevicePoseCache.h"
+#include "HAL/PlatformTime.h"
+#include "Algo/BinarySearch.h"
+
+using namespace SteamVRRecording;
+
+FSteamVRSimulatedDeviceSource::FSteamVRSimulatedDeviceSource(const FSettings& InSettings)
+	: Settings(InSettings)
+	, StartTime(FPlatformTime::Seconds())
+	, RecordingStartTime(0.0)
+	, RecordingDuration(0.0)
+{
+	// HMD always takes device ID 0
+	const int32 MaxDevices = FSteamVRDevicePoseCache::MaxDevices;
+	Settings.NumTrackingReferences = FMath::Clamp(Settings.NumTrackingReferences, 0, MaxDevices - 1);
+	Settings.NumControllers = FMath::Clamp(Settings.NumControllers, 0, MaxDevices - 1 - Settings.NumTrackingReferences);
+	FirstControllerId = 1 + Settings.NumTrackingReferences;
+	FirstTrackerId = FirstControllerId + Settings.NumControllers;
+
+	const bool bChurn = Settings.ChurnPeriod > 0.f && Settings.NumTrackers > 0;
+	Settings.NumTrackers = FMath::Clamp(Settings.NumTrackers, 0, MaxDevices - FirstTrackerId - (bChurn ? 1 : 0));
+	NumTrackerIds = Settings.NumTrackers + (bChurn ? 1 : 0);
+	Settings.DropoutWindow = FMath::Max(Settings.DropoutWindow, 0.001f);
+}
+
+bool FSteamVRSimulatedDeviceSource::OpenRecording(const FString& FileName)
+{
+	if (!Reader.Open(FileName) || Reader.GetNumChunks() == 0)
+	{
+		Reader.Close();
+		return false;
+	}
+
+	RecordingStartTime = Reader.GetStartTime();
+	RecordingDuration = Reader.GetEndTime() - RecordingStartTime;
+	StartTime = FPlatformTime::Seconds();
+	return true;
+}
+
+uint64 FSteamVRSimulatedDeviceSource::GetDevicePoses(const FQuat& BaseOrientation, const FVector& BaseOffset, FSteamVRDevicePose* OutPoses)
+{
+	const double Time = GetTime();
+	uint64 ConnectedMask = 0;
+
+	if (Reader.IsOpen())
+	{
+		ConnectedMask = GetRecordedPoses(Time, OutPoses);
+	}
+	else
+	{
+		// pose difference over this interval gives velocities
+		constexpr double VelocityDeltaTime = 0.005;
+
+		for (int32 DeviceId = 0; DeviceId < FSteamVRDevicePoseCache::MaxDevices; DeviceId++)
+		{
+			FSteamVRDevicePose& Pose = OutPoses[DeviceId];
+			int32 Index;
+			const ERole Role = GetDeviceRole(DeviceId, Time, Index);
+
+			Pose.bConnected = Role != ERole::None;
+			Pose.bPoseValid = Pose.bConnected;
+			Pose.bOutOfRange = false;
+			if (!Pose.bConnected)
+			{
+				continue;
+			}
+			ConnectedMask |= (1ull << DeviceId);
+
+			// dropout follows the device rather than device ID
+			const int32 DropoutWindow = (int32)FMath::FloorToDouble(Time / Settings.DropoutWindow);
+			const float Dropout = Role == ERole::TrackingReference ? 1.f : GetNoise(((uint32)Role << 8) | (uint32)Index, (uint32)DropoutWindow);
+			if (Dropout < 0.5f * Settings.DropoutChance)
+			{
+				// IMU only: pose freezes until tracking is back
+				GetProceduralPose(Role, Index, DropoutWindow * Settings.DropoutWindow, Pose.Position, Pose.Orientation);
+				Pose.LinearVelocity = Pose.AngularVelocity = FVector::ZeroVector;
+				Pose.bOutOfRange = true;
+			}
+			else if (Dropout < Settings.DropoutChance)
+			{
+				Pose.bPoseValid = false;
+				continue;
+			}
+			else
+			{
+				FVector NextPosition;
+				FQuat NextOrientation;
+				GetProceduralPose(Role, Index, Time, Pose.Position, Pose.Orientation);
+				GetProceduralPose(Role, Index, Time + VelocityDeltaTime, NextPosition, NextOrientation);
+
+				FQuat Delta = NextOrientation * Pose.Orientation.Inverse();
+				Delta.EnforceShortestArcWith(FQuat::Identity);
+				FVector Axis;
+				float Angle;
+				Delta.ToAxisAndAngle(Axis, Angle);
+
+				Pose.LinearVelocity = (NextPosition - Pose.Position) / VelocityDeltaTime;
+				Pose.AngularVelocity = Axis * (Angle / VelocityDeltaTime);
+			}
+
+			FSteamVRDevicePoseCache::ApplyBaseTransform(Pose, BaseOrientation, BaseOffset);
+		}
+	}
+
+	return ConnectedMask;
+}
+
+ESteamVRTrackedDeviceType FSteamVRSimulatedDeviceSource::GetDeviceType(int32 DeviceId)
+{
+	const double Time = GetTime();
+
+	if (Reader.IsOpen())
+	{
+		int32 Chunk, LastRecord;
+		uint64 SampleIndex;
+		const FDeviceEntry* Device = FindRecordedSample(Time, Chunk, LastRecord, SampleIndex) ? Reader.FindDevice(DeviceId, SampleIndex) : nullptr;
+		return Device ? (ESteamVRTrackedDeviceType)Device->DeviceType : ESteamVRTrackedDeviceType::Invalid;
+	}
+
+	int32 Index;
+	switch (GetDeviceRole(DeviceId, Time, Index))
+	{
+	case ERole::TrackingReference:
+		return ESteamVRTrackedDeviceType::TrackingReference;
+	case ERole::Controller:
+		return ESteamVRTrackedDeviceType::Controller;
+	case ERole::Tracker:
+		return ESteamVRTrackedDeviceType::Other;
+	default:
+		// OpenVR source doesn't report HMD class either
+		return ESteamVRTrackedDeviceType::Invalid;
+	}
+}
+
+ESteamVRControllerRole FSteamVRSimulatedDeviceSource::GetControllerRole(int32 DeviceId)
+{
+	// recordings don't store controller roles
+	if (Reader.IsOpen())
+	{
+		return ESteamVRControllerRole::Invalid;
+	}
+
+	int32 Index;
+	if (GetDeviceRole(DeviceId, GetTime(), Index) != ERole::Controller)
+	{
+		return ESteamVRControllerRole::Invalid;
+	}
+	switch (Index)
+	{
+	case 0:
+		return ESteamVRControllerRole::LeftHand;
+	case 1:
+		return ESteamVRControllerRole::RightHand;
+	default:
+		return ESteamVRControllerRole::Other;
+	}
+}
+
+bool FSteamVRSimulatedDeviceSource::GetSerialNumber(int32 DeviceId, ANSICHAR* OutSerialNumber, int32 BufferSize)
+{
+	const double Time = GetTime();
+
+	if (Reader.IsOpen())
+	{
+		int32 Chunk, LastRecord;
+		uint64 SampleIndex;
+		const ANSICHAR* SerialNumber = FindRecordedSample(Time, Chunk, LastRecord, SampleIndex) ? Reader.GetDeviceSerialNumber(DeviceId, SampleIndex) : nullptr;
+		if (!SerialNumber || SerialNumber[0] == '\0')
+		{
+			return false;
+		}
+		FCStringAnsi::Strncpy(OutSerialNumber, SerialNumber, BufferSize);
+		return true;
+	}
+
+	int32 Index;
+	const ANSICHAR* Prefix = nullptr;
+	switch (GetDeviceRole(DeviceId, Time, Index))
+	{
+	case ERole::HMD:
+		Prefix = "SIM-HMD";
+		break;
+	case ERole::TrackingReference:
+		Prefix = "SIM-LHB";
+		break;
+	case ERole::Controller:
+		Prefix = "SIM-CTL";
+		break;
+	case ERole::Tracker:
+		Prefix = "SIM-TRK";
+		break;
+	default:
+		return false;
+	}
+
+	FCStringAnsi::Snprintf(OutSerialNumber, BufferSize, "%s-%03d", Prefix, Index);
+	return true;
+}
+
+bool FSteamVRSimulatedDeviceSource::GetRenderModelName(int32 DeviceId, ANSICHAR* OutModelName, int32 BufferSize)
+{
+	// simulated devices can't be displayed by SteamVR render models
+	OutModelName[0] = '\0';
+	return false;
+}
+
+bool FSteamVRSimulatedDeviceSource::GetDisplayTiming(float& OutFrameDuration, float& OutVsyncToPhotons)
+{
+	OutFrameDuration = SimulatedFrameDuration;
+	OutVsyncToPhotons = SimulatedVsyncToPhotons;
+	return true;
+}
+
+bool FSteamVRSimulatedDeviceSource::GetTimeSinceLastVsync(float& OutSeconds)
+{
+	OutSeconds = (float)FMath::Fmod(GetTime(), (double)SimulatedFrameDuration);
+	return true;
+}
+
+FSteamVRSimulatedDeviceSource::ERole FSteamVRSimulatedDeviceSource::GetDeviceRole(int32 DeviceId, double Time, int32& OutIndex) const
+{
+	OutIndex = 0;
+	if (DeviceId == 0)
+	{
+		return ERole::HMD;
+	}
+	else if (DeviceId < FirstControllerId)
+	{
+		OutIndex = DeviceId - 1;
+		return ERole::TrackingReference;
+	}
+	else if (DeviceId < FirstTrackerId)
+	{
+		OutIndex = DeviceId - FirstControllerId;
+		return ERole::Controller;
+	}
+	else if (DeviceId < FirstTrackerId + NumTrackerIds)
+	{
+		OutIndex = DeviceId - FirstTrackerId;
+		if (NumTrackerIds > Settings.NumTrackers)
+		{
+			// every churn period trackers shift by one ID and one of them is off
+			const int64 Epoch = (int64)FMath::FloorToDouble(Time / Settings.ChurnPeriod);
+			OutIndex = (int32)(((OutIndex - Epoch) % NumTrackerIds + NumTrackerIds) % NumTrackerIds);
+			if (OutIndex >= Settings.NumTrackers || OutIndex == (int32)(Epoch % Settings.NumTrackers))
+			{
+				return ERole::None;
+			}
+		}
+		return ERole::Tracker;
+	}
+	return ERole::None;
+}
+
+void FSteamVRSimulatedDeviceSource::GetProceduralPose(ERole Role, int32 Index, double Time, FVector& OutPosition, FQuat& OutOrientation) const
+{
+	const float T = (float)Time;
+
+	switch (Role)
+	{
+	case ERole::HMD:
+		OutPosition = FVector(0.1f * FMath::Sin(0.5f * T), 0.1f * FMath::Sin(0.37f * T), 1.7f + 0.03f * FMath::Sin(1.3f * T));
+		OutOrientation = FRotator(10.f * FMath::Sin(0.4f * T), 30.f * FMath::Sin(0.25f * T), 0.f).Quaternion();
+		break;
+	case ERole::TrackingReference:
+	{
+		// corners of the room looking to the center
+		const float Angle = PI * (0.25f + 0.5f * Index);
+		OutPosition = FVector(2.5f * FMath::Cos(Angle), 2.5f * FMath::Sin(Angle), 2.3f);
+		OutOrientation = FRotator(-30.f, FMath::RadiansToDegrees(Angle) + 180.f, 0.f).Quaternion();
+		break;
+	}
+	case ERole::Controller:
+	{
+		const float Side = (Index % 2) ? 1.f : -1.f;
+		const float Phase = T * 1.1f + Index * 1.3f;
+		OutPosition = FVector(0.35f + 0.15f * FMath::Cos(Phase), Side * 0.25f + 0.1f * FMath::Sin(Phase), 1.1f + 0.15f * FMath::Sin(0.7f * Phase));
+		OutOrientation = FRotator(30.f * FMath::Sin(0.9f * Phase), 45.f * FMath::Sin(0.6f * Phase), 20.f * FMath::Sin(1.7f * T)).Quaternion();
+		break;
+	}
+	case ERole::Tracker:
+	{
+		// trackers walk around the room center
+		const float Angle = 2.f * PI * Index / FMath::Max(Settings.NumTrackers, 1) + 0.2f * T;
+		OutPosition = FVector(1.5f * FMath::Cos(Angle), 1.5f * FMath::Sin(Angle), 1.f + 0.1f * FMath::Sin(2.f * T + Index));
+		OutOrientation = FRotator(0.f, FMath::RadiansToDegrees(Angle) + 180.f, 0.f).Quaternion();
+		break;
+	}
+	default:
+		OutPosition = FVector::ZeroVector;
+		OutOrientation = FQuat::Identity;
+		break;
+	}
+}
+
+float FSteamVRSimulatedDeviceSource::GetNoise(uint32 A, uint32 B) const
+{
+	const uint32 Hash = MurmurFinalize32(A * 0x9E3779B9u ^ MurmurFinalize32(B + Settings.Seed * 0x85EBCA6Bu));
+	return (Hash & 0xFFFFFF) / 16777216.f;
+}
+
+double FSteamVRSimulatedDeviceSource::GetPlaybackTime(double Time) const
+{
+	return RecordingStartTime + (RecordingDuration > 0.0 ? FMath::Fmod(Time, RecordingDuration) : 0.0);
+}
+
+bool FSteamVRSimulatedDeviceSource::FindRecordedSample(double Time, int32& OutChunk, int32& OutLastRecord, uint64& OutSampleIndex) const
+{
+	const double PlaybackTime = GetPlaybackTime(Time);
+	OutChunk = Reader.FindChunk(PlaybackTime);
+	if (OutChunk < 0)
+	{
+		return false;
+	}
+
+	const FChunkHeader& ChunkHeader = Reader.GetChunkHeader(OutChunk);
+	const TArrayView<const FPoseRecord> Records = Reader.GetChunkRecords(OutChunk);
+	const uint32 MaxTimeOffset = (uint32)FMath::Clamp((PlaybackTime - ChunkHeader.ChunkTime) * 1e6, 0.0, (double)MAX_uint32);
+
+	// records are sorted by time within chunk
+	OutLastRecord = Algo::UpperBoundBy(Records, MaxTimeOffset, [](const FPoseRecord& Record) { return Record.TimeOffset; }) - 1;
+	if (OutLastRecord < 0)
+	{
+		return false;
+	}
+
+	OutSampleIndex = ChunkHeader.FirstSampleIndex + Records[OutLastRecord].SampleOffset;
+	return true;
+}
+
+uint64 FSteamVRSimulatedDeviceSource::GetRecordedPoses(double Time, FSteamVRDevicePose* OutPoses) const
+{
+	for (int32 DeviceId = 0; DeviceId < FSteamVRDevicePoseCache::MaxDevices; DeviceId++)
+	{
+		OutPoses[DeviceId].bConnected = OutPoses[DeviceId].bPoseValid = OutPoses[DeviceId].bOutOfRange = false;
+	}
+
+	int32 Chunk, LastRecord;
+	uint64 SampleIndex;
+	if (!FindRecordedSample(Time, Chunk, LastRecord, SampleIndex))
+	{
+		return 0;
+	}
+
+	// all records of the sample are stored together
+	uint64 ConnectedMask = 0;
+	const TArrayView<const FPoseRecord> Records = Reader.GetChunkRecords(Chunk);
+	const uint16 SampleOffset = Records[LastRecord].SampleOffset;
+	for (int32 Index = LastRecord; Index >= 0 && Records[Index].SampleOffset == SampleOffset; Index--)
+	{
+		const FPoseRecord& Record = Records[Index];
+		if (Record.DeviceId >= FSteamVRDevicePoseCache::MaxDevices)
+		{
+			continue;
+		}
+
+		FSteamVRDevicePose& Pose = OutPoses[Record.DeviceId];
+		Pose.bConnected = true;
+		Pose.bPoseValid = Record.TrackingState != (uint8)ETrackingState::NotTracked;
+		Pose.bOutOfRange = Record.TrackingState == (uint8)ETrackingState::InertialOnly;
+		Pose.Position = FVector(Record.Position[0], Record.Position[1], Record.Position[2]);
+		Pose.Orientation = FQuat(Record.Orientation[0], Record.Orientation[1], Record.Orientation[2], Record.Orientation[3]);
+		// velocities aren't recorded
+		Pose.LinearVelocity = Pose.AngularVelocity = FVector::ZeroVector;
+		ConnectedMask |= (1ull << Record.DeviceId);
+	}
+	return ConnectedMask;
+}
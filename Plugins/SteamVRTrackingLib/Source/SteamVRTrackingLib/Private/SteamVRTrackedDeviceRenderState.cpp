@@ -0,0 +1,71 @@
+// (c) YuriNK (ykasczc@gmail.com), 2020. You're free to use it whatever way you want.
+
+#include "SteamVRTrackedDeviceRenderState.h"
+#include "SteamVRTrackingLib.h"
+#include "SteamVRTrackingStats.h"
+#include "SceneView.h"
+#include "Components/SceneComponent.h"
+
+void FSteamVRTrackedDeviceRenderState::Publish(uint32 FrameNumber, const USceneComponent* Component)
+{
+	check(IsInGameThread());
+
+	GameThreadData.RelativeTransform = Component->GetRelativeTransform();
+	GameThreadData.ComponentScale = Component->GetComponentScale();
+	Mailbox.Write(FrameNumber, GameThreadData);
+}
+
+bool FSteamVRTrackedDeviceRenderState::GetLateUpdateTransforms_RenderThread(const FSceneViewFamily& InViewFamily, FTransform& OutOldTransform, FTransform& OutNewTransform) const
+{
+	if (!IsComponentAlive() || !TrackingLibModule)
+	{
+		return false;
+	}
+
+	FSteamVRTrackedDeviceLateUpdateData Data;
+	uint32 Retries = 0;
+	bool bPublished;
+	{
+		STEAMVR_TRACKING_SCOPE(STAT_SteamVRTracking_LateUpdateLockWait);
+		bPublished = Mailbox.Read(InViewFamily.FrameNumber, Data, &Retries);
+	}
+	if (Retries > 0)
+	{
+		STEAMVR_TRACKING_COUNT(LockRetries, Retries);
+	}
+	if (!bPublished || !Data.bHasAuthority || Data.DeviceId == INDEX_NONE)
+	{
+		return false;
+	}
+
+	// Find a view that is associated with this player.
+	float WorldToMetersScale = -1.0f;
+	for (const FSceneView* SceneView : InViewFamily.Views)
+	{
+		if (SceneView && SceneView->PlayerIndex == Data.PlayerIndex)
+		{
+			WorldToMetersScale = SceneView->WorldToMetersScale;
+			break;
+		}
+	}
+	// If there are no views associated with this player use view 0.
+	if (WorldToMetersScale < 0.0f)
+	{
+		check(InViewFamily.Views.Num() > 0);
+		WorldToMetersScale = InViewFamily.Views[0]->WorldToMetersScale;
+	}
+
+	// Poll state for the most recent controller transform
+	FSteamVRDevicePoseCache& PoseCache = TrackingLibModule->GetPoseCache();
+	const float PredictionSeconds = Data.bPredictFromFrameTiming ? PoseCache.GetSecondsToPhotons(ESteamVRPoseSnapshot::LateUpdate) : Data.PredictionSeconds;
+	FVector Position;
+	FRotator Orientation;
+	if (!PoseCache.GetDevicePositionAndOrientation(Data.DeviceId, Position, Orientation, WorldToMetersScale, ESteamVRPoseSnapshot::LateUpdate, PredictionSeconds))
+	{
+		return false;
+	}
+
+	OutOldTransform = Data.RelativeTransform;
+	OutNewTransform = FTransform(Orientation, Position, Data.ComponentScale);
+	return true;
+}
@@ -0,0 +1,148 @@
+// (c) YuriNK (ykasczc@gmail.com), 2020. You're free to use it whatever way you want.
+
+#include "SteamVRTrackedDeviceSceneComponent.h"
+#include "Components/PrimitiveComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/WorldSettings.h"
+
+//=============================================================================
+USteamVRTrackedDeviceSceneComponent::USteamVRTrackedDeviceSceneComponent(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = true;
+	PrimaryComponentTick.TickGroup = TG_PrePhysics;
+	PrimaryComponentTick.bTickEvenWhenPaused = true;
+
+	CurrentTrackingStatus = ETrackingStatus::NotTracked;
+	bAutoActivate = true;
+
+	// ensure InitializeComponent() gets called
+	bWantsInitializeComponent = true;
+}
+
+void USteamVRTrackedDeviceSceneComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	Updater.BeginPlay(this, FSteamVRTrackedDeviceUpdate::CreateUObject(this, &USteamVRTrackedDeviceSceneComponent::UpdateTrackedDevice));
+}
+
+//=============================================================================
+void USteamVRTrackedDeviceSceneComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	Updater.EndPlay(this);
+
+	Super::EndPlay(EndPlayReason);
+}
+
+//=============================================================================
+void USteamVRTrackedDeviceSceneComponent::BeginDestroy()
+{
+	Super::BeginDestroy();
+
+	Updater.Release();
+}
+
+//=============================================================================
+void USteamVRTrackedDeviceSceneComponent::TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction *ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	if (IsActive())
+	{
+		UpdateTrackedDevice(GetWorld() ? GetWorld()->GetWorldSettings()->WorldToMeters : 100.0f);
+	}
+}
+
+//=============================================================================
+void USteamVRTrackedDeviceSceneComponent::UpdateTrackedDevice(float WorldToMetersScale)
+{
+	Updater.Update(this, TrackingSettings, WorldToMetersScale, DisplayComponent, GetLoadCompleteDelegate());
+	CurrentTrackingStatus = Updater.GetTrackingStatus();
+}
+
+//=============================================================================
+void USteamVRTrackedDeviceSceneComponent::SetShowDeviceModel(const bool bShowDeviceModel)
+{
+	Updater.SetShowDeviceModel(this, TrackingSettings, bShowDeviceModel, DisplayComponent, GetLoadCompleteDelegate());
+}
+
+//=============================================================================
+void USteamVRTrackedDeviceSceneComponent::SetTrackedDeviceName(const FName NewSource)
+{
+	TrackingSettings.TrackedDeviceName = NewSource;
+	Updater.RegisterDelayTarget(this, TrackingSettings);
+}
+
+//=============================================================================
+void USteamVRTrackedDeviceSceneComponent::SetAssociatedPlayerIndex(const int32 NewPlayer)
+{
+	TrackingSettings.PlayerIndex = NewPlayer;
+	Updater.RegisterDelayTarget(this, TrackingSettings);
+}
+
+#if WITH_EDITOR
+//=============================================================================
+void USteamVRTrackedDeviceSceneComponent::PreEditChange(FProperty* PropertyAboutToChange)
+{
+	Updater.PreEditChange(TrackingSettings);
+	Super::PreEditChange(PropertyAboutToChange);
+}
+
+//=============================================================================
+void USteamVRTrackedDeviceSceneComponent::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	Updater.PostEditChangeProperty(this, TrackingSettings, PropertyChangedEvent, DisplayComponent, GetLoadCompleteDelegate());
+}
+#endif
+
+//=============================================================================
+void USteamVRTrackedDeviceSceneComponent::OnRegister()
+{
+	Super::OnRegister();
+
+	if (DisplayComponent == nullptr)
+	{
+		RefreshDisplayComponent();
+	}
+}
+
+//=============================================================================
+void USteamVRTrackedDeviceSceneComponent::InitializeComponent()
+{
+	Super::InitializeComponent();
+
+	Updater.RegisterDelayTarget(this, TrackingSettings);
+}
+
+//=============================================================================
+void USteamVRTrackedDeviceSceneComponent::OnComponentDestroyed(bool bDestroyingHierarchy)
+{
+	Super::OnComponentDestroyed(bDestroyingHierarchy);
+
+	if (DisplayComponent)
+	{
+		DisplayComponent->DestroyComponent();
+	}
+}
+
+//=============================================================================
+void USteamVRTrackedDeviceSceneComponent::RefreshDisplayComponent(const bool bForceDestroy)
+{
+	Updater.RefreshDisplayComponent(this, TrackingSettings, bForceDestroy, DisplayComponent, GetLoadCompleteDelegate());
+}
+
+//=============================================================================
+FXRComponentLoadComplete USteamVRTrackedDeviceSceneComponent::GetLoadCompleteDelegate()
+{
+	return FXRComponentLoadComplete::CreateUObject(this, &USteamVRTrackedDeviceSceneComponent::OnDisplayModelLoaded);
+}
+
+//=============================================================================
+void USteamVRTrackedDeviceSceneComponent::OnDisplayModelLoaded(UPrimitiveComponent* InDisplayComponent)
+{
+	Updater.OnDisplayModelLoaded(InDisplayComponent, DisplayComponent, TrackingSettings);
+}
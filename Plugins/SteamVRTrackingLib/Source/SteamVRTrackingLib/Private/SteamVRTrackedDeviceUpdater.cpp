@@ -0,0 +1,487 @@
+// (c) YuriNK (ykasczc@gmail.com), 2020. You're free to use it whatever way you want.
+
+#include "SteamVRTrackedDeviceUpdater.h"
+#include "Components/PrimitiveComponent.h"
+#include "Components/StaticMeshComponent.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "Features/IModularFeatures.h"
+#include "Materials/MaterialInterface.h"
+#include "Modules/ModuleManager.h"
+#include "MotionDelayBuffer.h"
+#include "SteamVRTrackingLibBPLibrary.h"
+#include "SteamVRTrackingLib.h"
+#include "SteamVRTrackingViewExtension.h"
+#include "SteamVRTrackingSubsystem.h"
+#include "SteamVRTrackingStats.h"
+
+FSteamVRTrackedDeviceUpdater::FSteamVRTrackedDeviceUpdater(FSteamVRTrackingLibModule* InTrackingLibModule)
+	: TrackingLibModule(InTrackingLibModule)
+	, bHasAuthority(false)
+	, bTracked(false)
+	, NextIdUpdateTime(0.f)
+	, CurrentDeviceId(INDEX_NONE)
+	, TrackingStatus(ETrackingStatus::NotTracked)
+	, bDeviceNameIsMotionSource(false)
+	, DisplayModelLoadState(EModelLoadStatus::Unloaded)
+{
+}
+
+//=============================================================================
+void FSteamVRTrackedDeviceUpdater::BeginPlay(UActorComponent* Component, const FSteamVRTrackedDeviceUpdate& UpdateDelegate)
+{
+	if (USteamVRTrackingSubsystem* TrackingSubsystem = UWorld::GetSubsystem<USteamVRTrackingSubsystem>(Component->GetWorld()))
+	{
+		TrackingSubsystem->RegisterTrackedDevice(Cast<USceneComponent>(Component), UpdateDelegate);
+		Component->SetComponentTickEnabled(false);
+	}
+}
+
+//=============================================================================
+void FSteamVRTrackedDeviceUpdater::EndPlay(UActorComponent* Component)
+{
+	if (USteamVRTrackingSubsystem* TrackingSubsystem = UWorld::GetSubsystem<USteamVRTrackingSubsystem>(Component->GetWorld()))
+	{
+		TrackingSubsystem->UnregisterTrackedDevice(Cast<USceneComponent>(Component));
+	}
+}
+
+//=============================================================================
+void FSteamVRTrackedDeviceUpdater::Update(USceneComponent* Component, const FSteamVRTrackedDeviceSettings& Settings, float WorldToMetersScale,
+	UPrimitiveComponent*& DisplayComponent, const FXRComponentLoadComplete& LoadCompleteDelegate)
+{
+	const bool bNewTrackedState = UpdateComponentPose(Component, Settings, WorldToMetersScale);
+
+	// if controller tracking just kicked in or shared render model was loaded
+	if (Settings.bDisplayDeviceModel && ((!bTracked && bNewTrackedState) || IsPendingDisplayModelLoaded()))
+	{
+		RefreshDisplayComponent(Component, Settings, false, DisplayComponent, LoadCompleteDelegate);
+	}
+	bTracked = bNewTrackedState;
+
+	UpdateRenderState(Component, Settings);
+}
+
+//=============================================================================
+bool FSteamVRTrackedDeviceUpdater::PollControllerState(const USceneComponent* Component, const FSteamVRTrackedDeviceSettings& Settings, FVector& Position, FRotator& Orientation, float WorldToMetersScale)
+{
+	check(IsInGameThread());
+
+	// Cache state from the game thread for use on the render thread
+	const AActor* MyOwner = Component->GetOwner();
+	bHasAuthority = MyOwner && MyOwner->HasLocalNetOwner();
+	const int32 PreviousDeviceId = CurrentDeviceId;
+	CurrentDeviceId = INDEX_NONE;
+	TrackingStatus = ETrackingStatus::NotTracked;
+
+	if (bHasAuthority)
+	{
+		if (!TrackingLibModule)
+		{
+			TrackingLibModule = FModuleManager::LoadModulePtr<FSteamVRTrackingLibModule>(TEXT("SteamVRTrackingLib"));
+			if (!TrackingLibModule)
+			{
+				return false;
+			}
+		}
+
+		// using friendly name instead?
+		int32 DeviceId = INDEX_NONE;
+		if (Settings.TrackedDeviceName != CheckedDeviceName)
+		{
+			CheckedDeviceName = Settings.TrackedDeviceName;
+			bDeviceNameIsMotionSource = FSteamVRMotionSourceResolver::IsMotionSource(CheckedDeviceName);
+		}
+		if (bDeviceNameIsMotionSource)
+		{
+			DeviceId = TrackingLibModule->GetMotionSourceResolver().GetDeviceIdByMotionSource(Settings.TrackedDeviceName, true, ESteamVRTrackedDeviceType::Invalid);
+		}
+		else
+		{
+			bool bForceUpdateId = false;
+			if (Settings.SteamVRIdUpdateInterval > 0.f)
+			{
+				const float CurrentTime = Component->GetWorld()->GetRealTimeSeconds();
+
+				if (CurrentTime > NextIdUpdateTime)
+				{
+					NextIdUpdateTime = CurrentTime + Settings.SteamVRIdUpdateInterval;
+					bForceUpdateId = true;
+				}
+			}
+			else if (Settings.SteamVRIdUpdateInterval == 0.f)
+			{
+				bForceUpdateId = true;
+			}
+
+			// ID of connected device can't change, even if it lost tracking
+			if (bForceUpdateId && PreviousDeviceId != INDEX_NONE)
+			{
+				const FSteamVRDeviceTrackingState* TrackingState = TrackingLibModule->GetPoseCache().GetDeviceTrackingState(PreviousDeviceId);
+				bForceUpdateId = !TrackingState || TrackingState->State == ESteamVRTrackingState::Disconnected;
+			}
+
+			DeviceId = TrackingLibModule->GetTrackedDeviceIdByName(Settings.TrackedDeviceName, bForceUpdateId);
+		}
+
+		// late update reuses device ID resolved on game thread
+		CurrentDeviceId = DeviceId;
+		if (DeviceId == INDEX_NONE)
+		{
+			return false;
+		}
+
+		STEAMVR_TRACKING_COUNT(PosePolls, 1);
+		FSteamVRDevicePoseCache& PoseCache = TrackingLibModule->GetPoseCache();
+		float PredictionSeconds = 0.f;
+		if (Settings.PosePrediction == ESteamVRPosePrediction::Fixed)
+		{
+			PredictionSeconds = Settings.PredictionTime;
+		}
+		else if (Settings.PosePrediction == ESteamVRPosePrediction::FrameTiming)
+		{
+			PredictionSeconds = PoseCache.GetSecondsToPhotons();
+		}
+		if (PoseCache.GetDevicePositionAndOrientation(DeviceId, Position, Orientation, WorldToMetersScale, ESteamVRPoseSnapshot::GameThread, PredictionSeconds))
+		{
+			const FSteamVRDeviceTrackingState* TrackingState = PoseCache.GetDeviceTrackingState(DeviceId);
+			TrackingStatus = (TrackingState && TrackingState->State == ESteamVRTrackingState::InertialOnly) ? ETrackingStatus::InertialOnly : ETrackingStatus::Tracked;
+			return true;
+		}
+		return GetDropoutPose(Settings, Position, Orientation, WorldToMetersScale, PredictionSeconds);
+	}
+
+	return false;
+}
+
+//=============================================================================
+bool FSteamVRTrackedDeviceUpdater::GetDropoutPose(const FSteamVRTrackedDeviceSettings& Settings, FVector& Position, FRotator& Orientation, float WorldToMetersScale, float PredictionSeconds)
+{
+	if (Settings.DropoutHoldTime <= 0.f)
+	{
+		return false;
+	}
+
+	const FSteamVRDeviceTrackingState* TrackingState = TrackingLibModule->GetPoseCache().GetDeviceTrackingState(CurrentDeviceId);
+	if (!TrackingState || TrackingState->State != ESteamVRTrackingState::Lost || !TrackingState->LastGoodPose.bPoseValid)
+	{
+		return false;
+	}
+
+	const float SecondsSinceGoodPose = (float)(FPlatformTime::Seconds() - TrackingState->LastGoodTime);
+	if (SecondsSinceGoodPose > Settings.DropoutHoldTime)
+	{
+		return false;
+	}
+
+	// status stays NotTracked: pose is only held
+	const FSteamVRDevicePose& Pose = TrackingState->LastGoodPose;
+	FVector HeldPosition = Pose.Position;
+	FQuat HeldOrientation = Pose.Orientation;
+	if (Settings.bExtrapolateDropout)
+	{
+		Pose.Predict(FMath::Min(SecondsSinceGoodPose + PredictionSeconds, FSteamVRDevicePoseCache::MaxPredictionSeconds), HeldPosition, HeldOrientation);
+	}
+	Position = HeldPosition * WorldToMetersScale;
+	Orientation = HeldOrientation.Rotator();
+	return true;
+}
+
+//=============================================================================
+bool FSteamVRTrackedDeviceUpdater::UpdateComponentPose(USceneComponent* Component, const FSteamVRTrackedDeviceSettings& Settings, float WorldToMetersScale)
+{
+	FVector Position;
+	FRotator Orientation;
+	if (!PollControllerState(Component, Settings, Position, Orientation, WorldToMetersScale))
+	{
+		return false;
+	}
+
+	// device at rest shouldn't propagate transform to children every frame
+	if (!Component->GetRelativeLocation().Equals(Position, PoseLocationTolerance) || !Component->GetRelativeRotation().Equals(Orientation, PoseRotationTolerance))
+	{
+		Component->SetRelativeLocationAndRotation(Position, Orientation);
+	}
+	return true;
+}
+
+//=============================================================================
+void FSteamVRTrackedDeviceUpdater::UpdateRenderState(USceneComponent* Component, const FSteamVRTrackedDeviceSettings& Settings)
+{
+	if (!RenderState.IsValid() && TrackingLibModule && GEngine)
+	{
+		RenderState = MakeShared<FSteamVRTrackedDeviceRenderState, ESPMode::ThreadSafe>(TrackingLibModule);
+		TrackingLibModule->GetTrackingViewExtension()->RegisterComponent(Component, RenderState);
+	}
+	if (RenderState.IsValid())
+	{
+		RenderState->GameThreadData.DeviceId = CurrentDeviceId;
+		RenderState->GameThreadData.PlayerIndex = Settings.PlayerIndex;
+		RenderState->GameThreadData.bHasAuthority = bHasAuthority;
+		RenderState->GameThreadData.bPredictFromFrameTiming = Settings.PosePrediction == ESteamVRPosePrediction::FrameTiming;
+		RenderState->GameThreadData.PredictionSeconds = Settings.PosePrediction == ESteamVRPosePrediction::Fixed ? Settings.PredictionTime : 0.f;
+		RenderState->bLateUpdateEnabled = !Settings.bDisableLowLatencyUpdate;
+	}
+}
+
+//=============================================================================
+void FSteamVRTrackedDeviceUpdater::Release()
+{
+	// render thread keeps its own reference to render state, so there is nothing to wait for
+	if (RenderState.IsValid())
+	{
+		RenderState->MarkComponentDestroyed();
+		if (TrackingLibModule && FModuleManager::Get().IsModuleLoaded(TEXT("SteamVRTrackingLib")))
+		{
+			TrackingLibModule->GetTrackingViewExtension()->UnregisterComponent(RenderState);
+		}
+		RenderState.Reset();
+	}
+}
+
+//=============================================================================
+void FSteamVRTrackedDeviceUpdater::RegisterDelayTarget(USceneComponent* Component, const FSteamVRTrackedDeviceSettings& Settings)
+{
+	UWorld* MyWorld = Component->GetWorld();
+	if (MyWorld && MyWorld->IsGameWorld() && Component->HasBeenInitialized())
+	{
+		FMotionDelayService::RegisterDelayTarget(Component, Settings.PlayerIndex, Settings.TrackedDeviceName);
+	}
+}
+
+//=============================================================================
+void FSteamVRTrackedDeviceUpdater::SetShowDeviceModel(USceneComponent* Component, FSteamVRTrackedDeviceSettings& Settings, bool bShowDeviceModel,
+	UPrimitiveComponent*& DisplayComponent, const FXRComponentLoadComplete& LoadCompleteDelegate)
+{
+	if (Settings.bDisplayDeviceModel != bShowDeviceModel)
+	{
+		Settings.bDisplayDeviceModel = bShowDeviceModel;
+#if WITH_EDITORONLY_DATA
+		const UWorld* MyWorld = Component->GetWorld();
+		const bool bIsGameInst = MyWorld && MyWorld->WorldType != EWorldType::Editor && MyWorld->WorldType != EWorldType::EditorPreview;
+
+		if (!bIsGameInst)
+		{
+			// tear down and destroy the existing component if we're an editor inst
+			RefreshDisplayComponent(Component, Settings, /*bForceDestroy =*/true, DisplayComponent, LoadCompleteDelegate);
+		}
+		else
+#endif
+		if (DisplayComponent)
+		{
+			DisplayComponent->SetHiddenInGame(bShowDeviceModel, /*bPropagateToChildren =*/false);
+		}
+		else if (!bShowDeviceModel)
+		{
+			RefreshDisplayComponent(Component, Settings, false, DisplayComponent, LoadCompleteDelegate);
+		}
+	}
+}
+
+#if WITH_EDITOR
+//=============================================================================
+void FSteamVRTrackedDeviceUpdater::PreEditChange(const FSteamVRTrackedDeviceSettings& Settings)
+{
+	PreEditMaterialCount = Settings.DisplayMeshMaterialOverrides.Num();
+}
+
+//=============================================================================
+void FSteamVRTrackedDeviceUpdater::PostEditChangeProperty(USceneComponent* Component, const FSteamVRTrackedDeviceSettings& Settings, const FPropertyChangedEvent& PropertyChangedEvent,
+	UPrimitiveComponent*& DisplayComponent, const FXRComponentLoadComplete& LoadCompleteDelegate)
+{
+	const FProperty* PropertyThatChanged = PropertyChangedEvent.Property;
+	const FName PropertyName = (PropertyThatChanged != nullptr) ? PropertyThatChanged->GetFName() : NAME_None;
+
+	if (PropertyName == GET_MEMBER_NAME_CHECKED(FSteamVRTrackedDeviceSettings, bDisplayDeviceModel))
+	{
+		RefreshDisplayComponent(Component, Settings, /*bForceDestroy =*/true, DisplayComponent, LoadCompleteDelegate);
+	}
+	else if (PropertyName == GET_MEMBER_NAME_CHECKED(FSteamVRTrackedDeviceSettings, DisplayMeshMaterialOverrides))
+	{
+		RefreshDisplayComponent(Component, Settings, /*bForceDestroy =*/Settings.DisplayMeshMaterialOverrides.Num() < PreEditMaterialCount, DisplayComponent, LoadCompleteDelegate);
+	}
+}
+#endif
+
+//=============================================================================
+void FSteamVRTrackedDeviceUpdater::RefreshDisplayComponent(USceneComponent* Component, const FSteamVRTrackedDeviceSettings& Settings, bool bForceDestroy,
+	UPrimitiveComponent*& DisplayComponent, const FXRComponentLoadComplete& LoadCompleteDelegate)
+{
+	const FName& TrackedDeviceName = Settings.TrackedDeviceName;
+	const FName& DisplayModelSource = Settings.DisplayModelSource;
+	if (Component->IsRegistered())
+	{
+		TArray<USceneComponent*> DisplayAttachChildren;
+		auto DestroyDisplayComponent = [this, &DisplayAttachChildren, &DisplayComponent]()
+		{
+			DisplayDeviceId.Clear();
+			DisplayModelName = NAME_None;
+
+			if (DisplayComponent)
+			{
+				// @TODO: save/restore socket attachments as well
+				DisplayAttachChildren = DisplayComponent->GetAttachChildren();
+
+				DisplayComponent->DestroyComponent(/*bPromoteChildren =*/true);
+				DisplayComponent = nullptr;
+			}
+		};
+		if (bForceDestroy)
+		{
+			DestroyDisplayComponent();
+		}
+
+		UPrimitiveComponent* NewDisplayComponent = nullptr;
+		if (Settings.bDisplayDeviceModel)
+		{
+			const EObjectFlags SubObjFlags = RF_Transactional | RF_TextExportTransient;
+			PendingModelName = NAME_None;
+
+			// device ID is already resolved if component is tracked
+			const int32 DeviceId = CurrentDeviceId != INDEX_NONE
+				? CurrentDeviceId
+				: USteamVRTrackingLibBPLibrary::GetDeviceIdByMotionSource(TrackedDeviceName, true, ESteamVRTrackedDeviceType::Invalid);
+
+			// devices of the same kind share SteamVR render model, so it's loaded once and instanced from cache
+			const FSteamVRRenderModel* CachedModel = nullptr;
+			FName ModelName;
+			if (DisplayModelSource.IsNone() || DisplayModelSource == FName(TEXT("SteamVR")))
+			{
+				FSteamVRRenderModelCache& RenderModelCache = FSteamVRTrackingLibModule::Get().GetRenderModelCache();
+				ModelName = RenderModelCache.GetModelName(DeviceId);
+				CachedModel = RenderModelCache.RequestModel(ModelName, DeviceId, Component->GetWorld());
+			}
+
+			if (CachedModel && CachedModel->State != FSteamVRRenderModel::EState::Failed)
+			{
+				if (DisplayComponent && DisplayModelName == ModelName)
+				{
+					// tracking re-engaged, model is the same
+					NewDisplayComponent = DisplayComponent;
+				}
+				else if (CachedModel->State == FSteamVRRenderModel::EState::Ready)
+				{
+					UStaticMeshComponent* MeshComponent = NewObject<UStaticMeshComponent>(Component->GetOwner(), NAME_None, SubObjFlags);
+					MeshComponent->SetStaticMesh(CachedModel->Mesh);
+					for (int32 MatIndex = 0; MatIndex < CachedModel->Materials.Num(); ++MatIndex)
+					{
+						MeshComponent->SetMaterial(MatIndex, CachedModel->Materials[MatIndex]);
+					}
+
+					DestroyDisplayComponent();
+					DisplayModelName = ModelName;
+					DisplayModelLoadState = EModelLoadStatus::Complete;
+					NewDisplayComponent = MeshComponent;
+				}
+				else
+				{
+					// never wait for model on game thread: component calls RefreshDisplayComponent again when it's loaded
+					PendingModelName = ModelName;
+					return;
+				}
+			}
+			else
+			{
+				TArray<IXRSystemAssets*> XRAssetSystems = IModularFeatures::Get().GetModularFeatureImplementations<IXRSystemAssets>(IXRSystemAssets::GetModularFeatureName());
+				for (IXRSystemAssets* AssetSys : XRAssetSystems)
+				{
+					if (!DisplayModelSource.IsNone() && AssetSys->GetSystemName() != DisplayModelSource)
+					{
+						continue;
+					}
+
+					if (DisplayComponent && DisplayDeviceId.IsOwnedBy(AssetSys) && DisplayDeviceId.DeviceId == DeviceId)
+					{
+						// assume that the current DisplayComponent is the same one we'd get back, so don't recreate it
+						// @TODO: maybe we should add a IsCurrentlyRenderable(int32 DeviceId) to IXRSystemAssets to confirm this in some manner
+						NewDisplayComponent = DisplayComponent;
+						break;
+					}
+
+					// needs to be set before CreateRenderComponent() since the LoadComplete callback may be triggered before it returns (for syncrounous loads)
+					DisplayModelLoadState = EModelLoadStatus::Pending;
+
+					NewDisplayComponent = AssetSys->CreateRenderComponent(DeviceId, Component->GetOwner(), SubObjFlags, /*bForceSynchronous=*/false, LoadCompleteDelegate);
+					if (NewDisplayComponent != nullptr)
+					{
+						if (DisplayModelLoadState != EModelLoadStatus::Complete)
+						{
+							DisplayModelLoadState = EModelLoadStatus::InProgress;
+						}
+						DestroyDisplayComponent();
+						DisplayDeviceId = FXRDeviceId(AssetSys, DeviceId);
+						break;
+					}
+					else
+					{
+						DisplayModelLoadState = EModelLoadStatus::Unloaded;
+					}
+				}
+			}
+
+			if (NewDisplayComponent == nullptr)
+			{
+				UE_LOG(LogTemp, Warning, TEXT("Failed to create a display component for the MotionController - no XR system (if there were any) had a model for the specified source ('%s')"), *TrackedDeviceName.ToString());
+			}
+			else if (NewDisplayComponent != DisplayComponent)
+			{
+				NewDisplayComponent->SetupAttachment(Component);
+				// force disable collision - if users wish to use collision, they can setup their own sub-component
+				NewDisplayComponent->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+				NewDisplayComponent->RegisterComponent();
+
+				for (USceneComponent* Child : DisplayAttachChildren)
+				{
+					Child->SetupAttachment(NewDisplayComponent);
+				}
+
+				DisplayComponent = NewDisplayComponent;
+			}
+
+			if (DisplayComponent)
+			{
+				if (DisplayModelLoadState != EModelLoadStatus::InProgress)
+				{
+					LoadCompleteDelegate.ExecuteIfBound(DisplayComponent);
+				}
+
+				DisplayComponent->SetHiddenInGame(Component->bHiddenInGame);
+				DisplayComponent->SetVisibility(Component->GetVisibleFlag());
+			}
+		}
+		else if (DisplayComponent)
+		{
+			DisplayComponent->SetHiddenInGame(true, /*bPropagateToChildren =*/false);
+		}
+	}
+}
+
+//=============================================================================
+bool FSteamVRTrackedDeviceUpdater::IsPendingDisplayModelLoaded() const
+{
+	if (PendingModelName.IsNone() || !TrackingLibModule)
+	{
+		return false;
+	}
+	const FSteamVRRenderModel* CachedModel = TrackingLibModule->GetRenderModelCache().FindModel(PendingModelName);
+	return !CachedModel || CachedModel->State != FSteamVRRenderModel::EState::Loading || !CachedModel->Loader.IsValid();
+}
+
+//=============================================================================
+void FSteamVRTrackedDeviceUpdater::OnDisplayModelLoaded(UPrimitiveComponent* InDisplayComponent, const UPrimitiveComponent* DisplayComponent, const FSteamVRTrackedDeviceSettings& Settings)
+{
+	const TArray<UMaterialInterface*>& MaterialOverrides = Settings.DisplayMeshMaterialOverrides;
+	if (InDisplayComponent == DisplayComponent || DisplayModelLoadState == EModelLoadStatus::Pending)
+	{
+		if (InDisplayComponent)
+		{
+			const int32 MatCount = FMath::Min(InDisplayComponent->GetNumMaterials(), MaterialOverrides.Num());
+			for (int32 MatIndex = 0; MatIndex < MatCount; ++MatIndex)
+			{
+				InDisplayComponent->SetMaterial(MatIndex, MaterialOverrides[MatIndex]);
+			}
+		}
+		DisplayModelLoadState = EModelLoadStatus::Complete;
+	}
+}
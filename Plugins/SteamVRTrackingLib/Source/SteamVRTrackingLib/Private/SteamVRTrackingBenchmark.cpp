@@ -0,0 +1,504 @@
+// (c) YuriNK (ykasczc@gmail.com), 2020. You're free to use it whatever way you want.
+
+#include "SteamVRTrackingBenchmark.h"
+
+#if !UE_BUILD_SHIPPING
+
+#include "SteamVRTrackingLib.h"
+#include "SteamVRSimulatedDeviceSource.h"
+#include "SteamVRTrackedDeviceUpdater.h"
+#include "SteamVRTrackedDeviceRenderState.h"
+#include "EditorSteamVRController.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/MemoryBase.h"
+#include "HAL/PlatformTime.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "SceneView.h"
+#include "RenderingThread.h"
+#include "Dom/JsonObject.h"
+#include "Dom/JsonValue.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+#include "Misc/App.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeExit.h"
+
+namespace SteamVRBenchmarkHelpers
+{
+	/** Number of rounds Iterations are split into: only the quietest round counts allocations */
+	constexpr int32 NumAllocationRounds = 4;
+
+	/** Heap allocations of all threads since start. Engine allocator only counts them in non-shipping builds. */
+	uint64 GetTotalAllocations()
+	{
+		return (uint64)FMalloc::TotalMallocCalls + (uint64)FMalloc::TotalReallocCalls;
+	}
+
+	double GetPercentile(const TArray<double>& SortedSamples, double Percentile)
+	{
+		const int32 Index = FMath::Clamp(FMath::RoundToInt(Percentile * (SortedSamples.Num() - 1)), 0, SortedSamples.Num() - 1);
+		return SortedSamples[Index];
+	}
+
+	void RunBenchmarkCommand(const TArray<FString>& Args)
+	{
+		int32 Iterations = 2000;
+		FString FileName = FSteamVRTrackingBenchmark::GetDefaultReportFileName();
+		for (const FString& Arg : Args)
+		{
+			if (Arg.IsNumeric())
+			{
+				Iterations = FMath::Max(FCString::Atoi(*Arg), 10);
+			}
+			else
+			{
+				FParse::Value(*Arg, TEXT("File="), FileName);
+			}
+		}
+
+		FSteamVRTrackingBenchmark Benchmark(Iterations);
+		const TSharedRef<FJsonObject> Report = Benchmark.Run();
+		for (const FString& Skipped : Benchmark.GetSkippedScenarios())
+		{
+			UE_LOG(LogTemp, Warning, TEXT("SteamVRTrackingBenchmark: skipped %s"), *Skipped);
+		}
+		FSteamVRTrackingBenchmark::SaveReport(Report, FileName);
+	}
+
+	FAutoConsoleCommand BenchmarkCommand(
+		TEXT("SteamVRTracking.Benchmark"),
+		TEXT("Measure tracking hot paths with 1, 8, 32 and 64 simulated devices.\n")
+		TEXT("SteamVRTracking.Benchmark [Iterations=2000] [File=Path.json]"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&RunBenchmarkCommand));
+}
+
+using namespace SteamVRBenchmarkHelpers;
+
+const int32 FSteamVRTrackingBenchmark::DeviceCounts[4] = { 1, 8, 32, 64 };
+
+FSteamVRTrackingBenchmark::FSteamVRTrackingBenchmark(int32 InIterations)
+	: Iterations(InIterations)
+	, World(nullptr)
+	, PlayerController(nullptr)
+	, bCountAllocations(false)
+{
+}
+
+FSteamVRTrackingBenchmark::~FSteamVRTrackingBenchmark()
+{
+	DestroyWorld();
+}
+
+bool FSteamVRTrackingBenchmark::IsAllocationCountingSupported()
+{
+	const uint64 StartAllocations = GetTotalAllocations();
+	void* Probe = FMemory::Malloc(64);
+	FMemory::Free(Probe);
+	return GetTotalAllocations() != StartAllocations;
+}
+
+FString FSteamVRTrackingBenchmark::GetDefaultReportFileName()
+{
+	return FPaths::ProjectSavedDir() / TEXT("Benchmarks") / FString::Printf(TEXT("SteamVRTracking-%s.json"), *FDateTime::Now().ToString());
+}
+
+bool FSteamVRTrackingBenchmark::SaveReport(const TSharedRef<FJsonObject>& Report, const FString& FileName)
+{
+	FString Output;
+	const TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Output);
+	FJsonSerializer::Serialize(Report, Writer);
+	if (FFileHelper::SaveStringToFile(Output, *FileName))
+	{
+		UE_LOG(LogTemp, Log, TEXT("SteamVRTrackingBenchmark: report saved to %s"), *FileName);
+		return true;
+	}
+	UE_LOG(LogTemp, Warning, TEXT("SteamVRTrackingBenchmark: can't write report to %s"), *FileName);
+	return false;
+}
+
+TSharedRef<FJsonObject> FSteamVRTrackingBenchmark::Run()
+{
+	check(IsInGameThread());
+
+	Results.Reset();
+	SkippedScenarios.Reset();
+	AllocationFailures.Reset();
+
+	bCountAllocations = IsAllocationCountingSupported();
+	if (!bCountAllocations)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("SteamVRTrackingBenchmark: engine allocator doesn't count calls, heap allocations aren't measured"));
+	}
+
+	// private module instance: device source and tracking setup of the running one stay as they are
+	TrackingLibModule = MakeUnique<FSteamVRTrackingLibModule>();
+	TrackingLibModule->StartupModule();
+	CreateWorld();
+
+	for (const int32 NumDevices : DeviceCounts)
+	{
+		RunScenarios(NumDevices);
+	}
+
+	DestroyWorld();
+	// late update could still reference the module
+	FlushRenderingCommands();
+	TrackingLibModule->ShutdownModule();
+	TrackingLibModule.Reset();
+
+	TArray<TSharedPtr<FJsonValue>> Skipped;
+	for (const FString& Scenario : SkippedScenarios)
+	{
+		Skipped.Add(MakeShared<FJsonValueString>(Scenario));
+	}
+
+	TSharedRef<FJsonObject> Report = MakeShared<FJsonObject>();
+	Report->SetNumberField(TEXT("Version"), 2);
+	Report->SetStringField(TEXT("Platform"), FPlatformProperties::IniPlatformName());
+	Report->SetStringField(TEXT("BuildConfiguration"), LexToString(FApp::GetBuildConfiguration()));
+	Report->SetStringField(TEXT("DateTime"), FDateTime::UtcNow().ToIso8601());
+	Report->SetNumberField(TEXT("Iterations"), Iterations);
+	Report->SetBoolField(TEXT("AllocationsCounted"), bCountAllocations);
+	Report->SetNumberField(TEXT("AllocationFailures"), AllocationFailures.Num());
+	Report->SetArrayField(TEXT("Skipped"), Skipped);
+	Report->SetArrayField(TEXT("Results"), Results);
+	return Report;
+}
+
+void FSteamVRTrackingBenchmark::CreateWorld()
+{
+	if (!GEngine)
+	{
+		return;
+	}
+
+	World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("SteamVRTrackingBenchmark"));
+	World->AddToRoot();
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+
+	// standalone world, so the player controller is local
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.ObjectFlags |= RF_Transient;
+	PlayerController = World->SpawnActor<APlayerController>(SpawnParameters);
+}
+
+void FSteamVRTrackingBenchmark::DestroyWorld()
+{
+	if (World)
+	{
+		GEngine->DestroyWorldContext(World);
+		World->DestroyWorld(false);
+		World->RemoveFromRoot();
+		World = nullptr;
+		PlayerController = nullptr;
+	}
+}
+
+void FSteamVRTrackingBenchmark::RunScenarios(int32 NumDevices)
+{
+	FSteamVRTrackingLibModule& Module = *TrackingLibModule;
+
+	// HMD, two controllers and trackers
+	FSteamVRSimulatedDeviceSource::FSettings Settings;
+	Settings.NumTrackingReferences = 0;
+	Settings.NumControllers = FMath::Min(NumDevices - 1, 2);
+	Settings.NumTrackers = NumDevices - 1 - Settings.NumControllers;
+	const TSharedRef<FSteamVRSimulatedDeviceSource, ESPMode::ThreadSafe> DeviceSource = MakeShared<FSteamVRSimulatedDeviceSource, ESPMode::ThreadSafe>(Settings);
+	Module.SetDeviceSource(DeviceSource);
+	Module.GetMotionSourceResolver().Invalidate();
+
+	// every device is bound by friendly name and has a motion source (friendly name for HMD)
+	TArray<FSteamVRDeviceBindingSetup> Bindings;
+	TArray<FName> MotionSources;
+	int32 NumControllers = 0, NumTrackers = 0;
+	for (int32 DeviceId = 0; DeviceId < NumDevices; DeviceId++)
+	{
+		ANSICHAR SerialNumber[64];
+		DeviceSource->GetSerialNumber(DeviceId, SerialNumber, UE_ARRAY_COUNT(SerialNumber));
+
+		FSteamVRDeviceBindingSetup& Binding = Bindings.AddDefaulted_GetRef();
+		Binding.SerialNumber = FName(ANSI_TO_TCHAR(SerialNumber));
+		Binding.FriendlyName = *FString::Printf(TEXT("Benchmark_%d"), DeviceId);
+		Binding.Type = DeviceSource->GetDeviceType(DeviceId);
+
+		switch (Binding.Type)
+		{
+		case ESteamVRTrackedDeviceType::Controller:
+			MotionSources.Add(NumControllers++ == 0 ? FName(TEXT("Left")) : FName(TEXT("Right")));
+			break;
+		case ESteamVRTrackedDeviceType::Other:
+			MotionSources.Add(*FString::Printf(TEXT("Special_%d"), ++NumTrackers));
+			break;
+		default:
+			MotionSources.Add(Binding.FriendlyName);
+			break;
+		}
+	}
+	Module.InitializeTrackingNamesFromArray(Bindings);
+
+	Measure(TEXT("GetTrackedDeviceIdByName"), NumDevices, [&]()
+	{
+		for (const FSteamVRDeviceBindingSetup& Binding : Bindings)
+		{
+			Module.GetTrackedDeviceIdByName(Binding.FriendlyName, true);
+		}
+	});
+
+	Measure(TEXT("GetDeviceIdByMotionSource"), NumDevices, [&]()
+	{
+		for (const FName& MotionSource : MotionSources)
+		{
+			Module.GetMotionSourceResolver().GetDeviceIdByMotionSource(MotionSource, true, ESteamVRTrackedDeviceType::Invalid);
+		}
+	});
+
+	// resolver caches IDs per frame, so this is the cost of the first call in frame. Cache entries are allocated again.
+	Measure(TEXT("GetDeviceIdByMotionSourceUncached"), NumDevices, [&]()
+	{
+		Module.GetMotionSourceResolver().Invalidate();
+		for (const FName& MotionSource : MotionSources)
+		{
+			Module.GetMotionSourceResolver().GetDeviceIdByMotionSource(MotionSource, true, ESteamVRTrackedDeviceType::Invalid);
+		}
+	}, false);
+
+	// updater only polls devices for components owned by local player
+	USceneComponent* OwnerComponent = PlayerController ? PlayerController->GetRootComponent() : nullptr;
+	if (OwnerComponent)
+	{
+		TArray<FSteamVRTrackedDeviceSettings> DeviceSettings;
+		TArray<FSteamVRTrackedDeviceUpdater> Updaters;
+		Updaters.Reserve(Bindings.Num());
+		for (const FSteamVRDeviceBindingSetup& Binding : Bindings)
+		{
+			FSteamVRTrackedDeviceSettings& DeviceSetting = DeviceSettings.AddDefaulted_GetRef();
+			DeviceSetting.TrackedDeviceName = Binding.FriendlyName;
+			Updaters.Emplace(&Module);
+		}
+
+		FVector Position;
+		FRotator Orientation;
+		int32 NumResolved = 0;
+		for (int32 Index = 0; Index < Updaters.Num(); Index++)
+		{
+			Updaters[Index].PollControllerState(OwnerComponent, DeviceSettings[Index], Position, Orientation, 100.f);
+			NumResolved += Updaters[Index].GetCurrentDeviceId() != INDEX_NONE ? 1 : 0;
+		}
+
+		if (NumResolved > 0)
+		{
+			Measure(TEXT("PollControllerState"), NumDevices, [&]()
+			{
+				for (int32 Index = 0; Index < Updaters.Num(); Index++)
+				{
+					Updaters[Index].PollControllerState(OwnerComponent, DeviceSettings[Index], Position, Orientation, 100.f);
+				}
+			});
+		}
+		else
+		{
+			Skip(TEXT("PollControllerState"), NumDevices, TEXT("no device was resolved, player controller isn't local"));
+		}
+
+		for (FSteamVRTrackedDeviceUpdater& Updater : Updaters)
+		{
+			Updater.Release();
+		}
+	}
+	else
+	{
+		Skip(TEXT("PollControllerState"), NumDevices, TEXT("can't create world with local player controller"));
+	}
+
+	MeasureEditorControllerTick(NumDevices, DeviceSource, MotionSources);
+	MeasureLateUpdate(NumDevices);
+}
+
+void FSteamVRTrackingBenchmark::MeasureEditorControllerTick(int32 NumDevices, const TSharedRef<FSteamVRSimulatedDeviceSource, ESPMode::ThreadSafe>& DeviceSource, const TArray<FName>& MotionSources)
+{
+	if (!World)
+	{
+		Skip(TEXT("EditorSteamVRController.Tick"), NumDevices, TEXT("can't create world"));
+		return;
+	}
+
+	// actor always reads engine's module instance, so simulated devices are installed there until the scenario is done
+	FSteamVRTrackingLibModule& EngineModule = FSteamVRTrackingLibModule::Get();
+	if (EngineModule.GetTrackingRecorder().IsRecording())
+	{
+		Skip(TEXT("EditorSteamVRController.Tick"), NumDevices, TEXT("tracking session is being recorded from the current device source"));
+		return;
+	}
+
+	const TSharedPtr<ISteamVRDeviceSource, ESPMode::ThreadSafe> PreviousDeviceSource = EngineModule.GetDeviceSource();
+	EngineModule.SetDeviceSource(DeviceSource);
+	EngineModule.GetMotionSourceResolver().Invalidate();
+	ON_SCOPE_EXIT
+	{
+		EngineModule.SetDeviceSource(PreviousDeviceSource);
+		EngineModule.GetMotionSourceResolver().Invalidate();
+	};
+
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.ObjectFlags |= RF_Transient;
+	AEditorSteamVRController* Controller = World->SpawnActor<AEditorSteamVRController>(SpawnParameters);
+	if (!Controller)
+	{
+		Skip(TEXT("EditorSteamVRController.Tick"), NumDevices, TEXT("can't spawn controller actor"));
+		return;
+	}
+
+	for (const FName& MotionSource : MotionSources)
+	{
+		FSteamVRTrackedComponent& TrackedComponent = Controller->TrackedObjects.Add(MotionSource);
+		TrackedComponent.Actor = Controller;
+		TrackedComponent.ComponentName = Controller->GetRootComponent()->GetFName();
+	}
+	Controller->bIsEnabled = true;
+	Controller->UpdateObjectsList();
+
+	Measure(TEXT("EditorSteamVRController.Tick"), NumDevices, [Controller]()
+	{
+		Controller->Tick(1.f / 90.f);
+	});
+
+	Controller->Destroy();
+}
+
+void FSteamVRTrackingBenchmark::MeasureLateUpdate(int32 NumDevices)
+{
+	// late update only needs frame number and world to meters scale of the view family
+	FSceneViewFamilyContext ViewFamily(FSceneViewFamily::ConstructionValues(nullptr, nullptr, FEngineShowFlags(ESFIM_Game)));
+	ViewFamily.FrameNumber = MAX_uint32 - 1;
+
+	FSceneViewInitOptions ViewInitOptions;
+	ViewInitOptions.ViewFamily = &ViewFamily;
+	ViewInitOptions.SetViewRectangle(FIntRect(0, 0, 64, 64));
+	ViewInitOptions.ViewOrigin = FVector::ZeroVector;
+	ViewInitOptions.ViewRotationMatrix = FMatrix::Identity;
+	ViewInitOptions.ProjectionMatrix = FReversedZPerspectiveMatrix(0.25f * PI, 1.f, 1.f, 1.f);
+	ViewInitOptions.WorldToMetersScale = 100.f;
+	ViewFamily.Views.Add(new FSceneView(ViewInitOptions));
+
+	TArray<TSharedPtr<FSteamVRTrackedDeviceRenderState, ESPMode::ThreadSafe>> RenderStates;
+	for (int32 DeviceId = 0; DeviceId < NumDevices; DeviceId++)
+	{
+		TSharedPtr<FSteamVRTrackedDeviceRenderState, ESPMode::ThreadSafe> RenderState = MakeShared<FSteamVRTrackedDeviceRenderState, ESPMode::ThreadSafe>(TrackingLibModule.Get());
+		RenderState->GameThreadData.DeviceId = DeviceId;
+		RenderState->GameThreadData.bHasAuthority = true;
+		RenderState->Mailbox.Write(ViewFamily.FrameNumber, RenderState->GameThreadData);
+		RenderStates.Add(RenderState);
+	}
+
+	FTimings Timings;
+	ENQUEUE_RENDER_COMMAND(SteamVRTrackingBenchmarkLateUpdate)(
+		[this, &ViewFamily, &RenderStates, &Timings](FRHICommandListImmediate& RHICmdList)
+	{
+		MeasureOnCurrentThread([&]()
+		{
+			FTransform OldTransform, NewTransform;
+			for (const auto& RenderState : RenderStates)
+			{
+				RenderState->GetLateUpdateTransforms_RenderThread(ViewFamily, OldTransform, NewTransform);
+			}
+		}, Timings);
+	});
+	FlushRenderingCommands();
+
+	AddResult(TEXT("LateUpdate_RenderThread"), NumDevices, Timings);
+}
+
+void FSteamVRTrackingBenchmark::MeasureOnCurrentThread(TFunctionRef<void()> Body, FTimings& OutTimings) const
+{
+	const int32 NumWarmUpIterations = FMath::Max(Iterations / 10, 1);
+	for (int32 Iteration = 0; Iteration < NumWarmUpIterations; Iteration++)
+	{
+		Body();
+	}
+
+	// other threads allocate too, but a path which allocates does it in every round
+	const int32 RoundIterations = FMath::Max(Iterations / NumAllocationRounds, 1);
+	OutTimings.Samples.SetNumUninitialized(RoundIterations * NumAllocationRounds);
+	OutTimings.RoundIterations = RoundIterations;
+	OutTimings.NumAllocations = MAX_uint64;
+
+	int32 Sample = 0;
+	for (int32 Round = 0; Round < NumAllocationRounds; Round++)
+	{
+		const uint64 StartAllocations = GetTotalAllocations();
+		for (int32 Iteration = 0; Iteration < RoundIterations; Iteration++)
+		{
+			const uint64 StartCycles = FPlatformTime::Cycles64();
+			Body();
+			OutTimings.Samples[Sample++] = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles) * 1000.0;
+		}
+		OutTimings.NumAllocations = FMath::Min(OutTimings.NumAllocations, GetTotalAllocations() - StartAllocations);
+	}
+}
+
+void FSteamVRTrackingBenchmark::Measure(const TCHAR* Scenario, int32 NumDevices, TFunctionRef<void()> Body, bool bExpectNoAllocations)
+{
+	FTimings Timings;
+	Timings.bExpectNoAllocations = bExpectNoAllocations;
+	MeasureOnCurrentThread(Body, Timings);
+	AddResult(Scenario, NumDevices, Timings);
+}
+
+void FSteamVRTrackingBenchmark::Skip(const TCHAR* Scenario, int32 NumDevices, const TCHAR* Reason)
+{
+	SkippedScenarios.Add(FString::Printf(TEXT("%s (%d devices): %s"), Scenario, NumDevices, Reason));
+}
+
+void FSteamVRTrackingBenchmark::AddResult(const TCHAR* Scenario, int32 NumDevices, FTimings& Timings)
+{
+	if (Timings.Samples.Num() == 0)
+	{
+		Skip(Scenario, NumDevices, TEXT("nothing was measured"));
+		return;
+	}
+
+	Timings.Samples.Sort();
+	double Total = 0.0;
+	for (const double Sample : Timings.Samples)
+	{
+		Total += Sample;
+	}
+
+	const double Mean = Total / Timings.Samples.Num();
+	const double P50 = GetPercentile(Timings.Samples, 0.5);
+	const double P90 = GetPercentile(Timings.Samples, 0.9);
+	const double P99 = GetPercentile(Timings.Samples, 0.99);
+	const double Max = Timings.Samples.Last();
+	const double AllocationsPerIteration = (double)Timings.NumAllocations / Timings.RoundIterations;
+
+	TSharedRef<FJsonObject> Result = MakeShared<FJsonObject>();
+	Result->SetStringField(TEXT("Scenario"), Scenario);
+	Result->SetNumberField(TEXT("Devices"), NumDevices);
+	Result->SetNumberField(TEXT("MeanUs"), Mean);
+	Result->SetNumberField(TEXT("P50Us"), P50);
+	Result->SetNumberField(TEXT("P90Us"), P90);
+	Result->SetNumberField(TEXT("P99Us"), P99);
+	Result->SetNumberField(TEXT("MaxUs"), Max);
+	if (bCountAllocations)
+	{
+		Result->SetNumberField(TEXT("AllocationsPerIteration"), AllocationsPerIteration);
+	}
+	Results.Add(MakeShared<FJsonValueObject>(Result));
+
+	if (bCountAllocations && Timings.bExpectNoAllocations && Timings.NumAllocations > 0)
+	{
+		AllocationFailures.Add(FString::Printf(TEXT("%s (%d devices) made %llu heap allocations in %d iterations after warm-up"),
+			Scenario, NumDevices, Timings.NumAllocations, Timings.RoundIterations));
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("SteamVRTrackingBenchmark: %-36s devices=%2d mean=%8.3fus p50=%8.3fus p90=%8.3fus p99=%8.3fus max=%8.3fus allocs=%.2f"),
+		Scenario, NumDevices, Mean, P50, P90, P99, Max, bCountAllocations ? AllocationsPerIteration : -1.0);
+}
+
+#endif
@@ -0,0 +1,89 @@
+// (c) YuriNK (ykasczc@gmail.com), 2020. You're free to use it whatever way you want.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#if !UE_BUILD_SHIPPING
+
+class UWorld;
+class APlayerController;
+class FJsonObject;
+class FSteamVRTrackingLibModule;
+class FSteamVRSimulatedDeviceSource;
+
+/**
+* Microbenchmark of tracking hot paths with simulated devices (see FSteamVRSimulatedDeviceSource).
+* Run as automation test SteamVRTracking.Benchmark or with console command:
+*   SteamVRTracking.Benchmark [Iterations=2000] [File=Path.json]
+* Every scenario is measured at 1, 8, 32 and 64 devices. Results (percentiles in microseconds and heap allocations
+* per iteration) are logged and written to JSON file, by default Saved/Benchmarks/SteamVRTracking-<time>.json.
+* Benchmark runs on its own instance of tracking module and its own world, so state of the running module isn't touched.
+* The only exception is AEditorSteamVRController::Tick: the actor reads the engine's module, so simulated device source
+* is installed there for this scenario and the previous one is restored after it.
+* Steady state scenarios shouldn't allocate after warm-up, automation test SteamVRTracking.SteadyStateAllocations checks it.
+*/
+class FSteamVRTrackingBenchmark
+{
+public:
+	FSteamVRTrackingBenchmark(int32 InIterations);
+	~FSteamVRTrackingBenchmark();
+
+	/** Game thread. Runs all scenarios and returns report. */
+	TSharedRef<FJsonObject> Run();
+
+	/** Scenarios which couldn't be measured in the last run, with reasons */
+	const TArray<FString>& GetSkippedScenarios() const { return SkippedScenarios; }
+
+	/** Steady state scenarios which allocated in the last run */
+	const TArray<FString>& GetAllocationFailures() const { return AllocationFailures; }
+
+	/** Whether heap allocations are counted by engine allocator (see FMalloc::TotalMallocCalls) */
+	static bool IsAllocationCountingSupported();
+
+	/** Saved/Benchmarks/SteamVRTracking-<time>.json */
+	static FString GetDefaultReportFileName();
+	static bool SaveReport(const TSharedRef<FJsonObject>& Report, const FString& FileName);
+
+	static const int32 DeviceCounts[4];
+
+private:
+	struct FTimings
+	{
+		/** Microseconds per iteration */
+		TArray<double> Samples;
+		/** Allocations in the quietest round, see MeasureOnCurrentThread */
+		uint64 NumAllocations = 0;
+		int32 RoundIterations = 0;
+		/** Steady state path should make no allocations */
+		bool bExpectNoAllocations = true;
+	};
+
+	int32 Iterations;
+	TUniquePtr<FSteamVRTrackingLibModule> TrackingLibModule;
+	UWorld* World;
+	APlayerController* PlayerController;
+	bool bCountAllocations;
+
+	TArray<TSharedPtr<class FJsonValue>> Results;
+	TArray<FString> SkippedScenarios;
+	TArray<FString> AllocationFailures;
+
+	void CreateWorld();
+	void DestroyWorld();
+
+	/**
+	* Run Body Iterations times after warm-up, measuring every call. Engine allocator only counts allocations of all threads,
+	* so iterations are split into rounds and allocations of the quietest round are reported.
+	*/
+	void MeasureOnCurrentThread(TFunctionRef<void()> Body, FTimings& OutTimings) const;
+	void Measure(const TCHAR* Scenario, int32 NumDevices, TFunctionRef<void()> Body, bool bExpectNoAllocations = true);
+	void AddResult(const TCHAR* Scenario, int32 NumDevices, FTimings& Timings);
+	void Skip(const TCHAR* Scenario, int32 NumDevices, const TCHAR* Reason);
+
+	void RunScenarios(int32 NumDevices);
+	void MeasureEditorControllerTick(int32 NumDevices, const TSharedRef<FSteamVRSimulatedDeviceSource, ESPMode::ThreadSafe>& DeviceSource, const TArray<FName>& MotionSources);
+	void MeasureLateUpdate(int32 NumDevices);
+};
+
+#endif
@@ -4,44 +4,411 @@
 #include "SteamVRTrackingSetup.h"
 #include "SteamVRFunctionLibrary.h"
 #include "SteamVRTrackingLibBPLibrary.h"
+#include "SteamVRTrackingViewExtension.h"
+#include "SteamVRTrackingStats.h"
+#include "SceneViewExtension.h"
+#include "RenderingThread.h"
+#include "SteamVROpenVRDeviceSource.h"
+#include "SteamVRSimulatedDeviceSource.h"
+#include "Misc/CommandLine.h"
+#include "Misc/CoreDelegates.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
 
 #define LOCTEXT_NAMESPACE "FSteamVRTrackingLibModule"
 
 void FSteamVRTrackingLibModule::StartupModule()
 {
+	IndexedDevicesMask = 0;
+	bDeviceIndexDirty = false;
+	DeviceTopologyVersion = 0;
+	DeviceIndexFrame = MAX_uint64;
+	bTopologyChangePending = false;
+	ConnectedControllers.Reserve(FSteamVRDevicePoseCache::MaxDevices);
+	ConnectedTrackers.Reserve(FSteamVRDevicePoseCache::MaxDevices);
+	ConnectedTrackingReferences.Reserve(FSteamVRDevicePoseCache::MaxDevices);
+	MotionSourceResolver = MakeUnique<FSteamVRMotionSourceResolver>(*this);
+	TrackingSampler = MakeUnique<FSteamVRTrackingSampler>(PoseCache);
+	TrackingRecorder = MakeUnique<FSteamVRTrackingRecorder>(*TrackingSampler);
+	TrackingSetupWatcher = MakeUnique<FSteamVRTrackingSetupWatcher>(*this);
+	for (FIndexedDevice& Device : IndexedDevices)
+	{
+		Device.SerialNumber[0] = '\0';
+		Device.SerialName = NAME_None;
+		Device.Type = ESteamVRTrackedDeviceType::Invalid;
+		Device.Role = ESteamVRControllerRole::Invalid;
+	}
+	PoseCache.SetDeviceSource(CreateDefaultDeviceSource());
+	EndFrameHandle = FCoreDelegates::OnEndFrame.AddRaw(this, &FSteamVRTrackingLibModule::OnEndFrame);
 }
 
 void FSteamVRTrackingLibModule::ShutdownModule()
 {
+	FCoreDelegates::OnEndFrame.Remove(EndFrameHandle);
+	TrackingSetupWatcher.Reset();
+	RenderModelCache.Reset();
+	TrackingRecorder.Reset();
+	TrackingSampler.Reset();
+	MotionSourceResolver.Reset();
+
+	if (TrackingViewExtension.IsValid())
+	{
+		// render thread can still use the extension
+		FlushRenderingCommands();
+		TrackingViewExtension.Reset();
+	}
+}
+
+TSharedPtr<ISteamVRDeviceSource, ESPMode::ThreadSafe> FSteamVRTrackingLibModule::CreateDefaultDeviceSource() const
+{
+	// -SteamVRSimulation[=NumTrackers|=Session.svrrec] [-SteamVRSimulationDropout=0.05] [-SteamVRSimulationChurn=10]
+	const TCHAR* CommandLine = FCommandLine::Get();
+	FString SimulationParam;
+	const bool bSimulation = FParse::Value(CommandLine, TEXT("SteamVRSimulation="), SimulationParam) || FParse::Param(CommandLine, TEXT("SteamVRSimulation"));
+	if (!bSimulation)
+	{
+		return MakeShared<FSteamVROpenVRDeviceSource, ESPMode::ThreadSafe>();
+	}
+
+	FSteamVRSimulatedDeviceSource::FSettings Settings;
+	FParse::Value(CommandLine, TEXT("SteamVRSimulationDropout="), Settings.DropoutChance);
+	FParse::Value(CommandLine, TEXT("SteamVRSimulationChurn="), Settings.ChurnPeriod);
+	FParse::Value(CommandLine, TEXT("SteamVRSimulationSeed="), Settings.Seed);
+	if (SimulationParam.IsNumeric())
+	{
+		Settings.NumTrackers = FCString::Atoi(*SimulationParam);
+	}
+
+	TSharedRef<FSteamVRSimulatedDeviceSource, ESPMode::ThreadSafe> Source = MakeShared<FSteamVRSimulatedDeviceSource, ESPMode::ThreadSafe>(Settings);
+	if (!SimulationParam.IsEmpty() && !SimulationParam.IsNumeric())
+	{
+		const FString FileName = FPaths::IsRelative(SimulationParam) ? FPaths::ProjectSavedDir() / TEXT("TrackingSessions") / SimulationParam : SimulationParam;
+		if (!Source->OpenRecording(FileName))
+		{
+			UE_LOG(LogTemp, Warning, TEXT("SteamVRTrackingLib: can't play back %s, using procedural simulation"), *FileName);
+		}
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("SteamVRTrackingLib: using simulated devices (%s)"), Source->IsPlayingRecording() ? *SimulationParam : TEXT("procedural"));
+	return Source;
+}
+
+void FSteamVRTrackingLibModule::SetDeviceSource(const TSharedPtr<ISteamVRDeviceSource, ESPMode::ThreadSafe>& InDeviceSource)
+{
+	// background threads read device source without synchronization
+	const bool bWasSampling = TrackingSampler->IsRunning();
+	TrackingRecorder->StopRecording();
+	TrackingSampler->StopSampling();
+
+	PoseCache.SetDeviceSource(InDeviceSource);
+	bDeviceIndexDirty = true;
+
+	if (bWasSampling)
+	{
+		TrackingSampler->StartSampling(TrackingSampler->GetSampleRate(), (int32)TrackingSampler->GetCapacity());
+	}
+}
+
+const TSharedPtr<FSteamVRTrackingViewExtension, ESPMode::ThreadSafe>& FSteamVRTrackingLibModule::GetTrackingViewExtension()
+{
+	if (!TrackingViewExtension.IsValid() && GEngine)
+	{
+		TrackingViewExtension = FSceneViewExtensions::NewExtension<FSteamVRTrackingViewExtension>();
+	}
+	return TrackingViewExtension;
+}
+
+FSteamVRRenderModelCache& FSteamVRTrackingLibModule::GetRenderModelCache()
+{
+	check(IsInGameThread());
+
+	// GC referencer can't be created before UObject system, so it isn't created in StartupModule
+	if (!RenderModelCache.IsValid())
+	{
+		RenderModelCache = MakeUnique<FSteamVRRenderModelCache>();
+	}
+	return *RenderModelCache;
 }
 
 int32 FSteamVRTrackingLibModule::GetTrackedDeviceIdByName(const FName& FriendlyName, bool bForceUpdateId)
 {
-	if (FSteamVRDeviceBindingSetup* BidningSetup = DeviceSetup.Find(FriendlyName))
+	const bool bGameThread = IsInGameThread();
+	if (bGameThread)
+	{
+		// binding IDs are resolved again when device table changes
+		UpdateDeviceIndex();
+	}
+
+	if (const FSteamVRDeviceBindingSetup* BidningSetup = DeviceRegistry.Read().Bindings.Find(FriendlyName))
+	{
+		if (bForceUpdateId && bGameThread)
+		{
+			STEAMVR_TRACKING_COUNT(IdCacheMisses, 1);
+			return GetTrackedDeviceIdBySerialNumber(BidningSetup->SerialNumber, BidningSetup->Type);
+		}
+
+		return BidningSetup->Id;
+	}
+	else
+	{
+		return INDEX_NONE;
+	}
+}
+
+int32 FSteamVRTrackingLibModule::GetTrackedDeviceIdBySerialNumber(const FName& SerialNumber, ESteamVRTrackedDeviceType DeviceType)
+{
+	UpdateDeviceIndex();
+	STEAMVR_TRACKING_COUNT(SerialLookups, 1);
+
+	if (const int32* DeviceId = SerialToDeviceId.Find(SerialNumber))
+	{
+		if (DeviceType == ESteamVRTrackedDeviceType::Invalid || IndexedDevices[*DeviceId].Type == DeviceType)
+		{
+			return *DeviceId;
+		}
+	}
+	return INDEX_NONE;
+}
+
+const ANSICHAR* FSteamVRTrackingLibModule::GetTrackedDeviceSerialNumber(int32 DeviceId)
+{
+	UpdateDeviceIndex();
+
+	if (DeviceId >= 0 && DeviceId < FSteamVRDevicePoseCache::MaxDevices && IndexedDevices[DeviceId].SerialNumber[0] != '\0')
+	{
+		return IndexedDevices[DeviceId].SerialNumber;
+	}
+	return nullptr;
+}
+
+const TArray<int32>& FSteamVRTrackingLibModule::GetConnectedDeviceIds(ESteamVRTrackedDeviceType DeviceType)
+{
+	UpdateDeviceIndex();
+
+	switch (DeviceType)
 	{
-		if (BidningSetup->Id == INDEX_NONE || bForceUpdateId)
+	case ESteamVRTrackedDeviceType::Controller:
+		return ConnectedControllers;
+	case ESteamVRTrackedDeviceType::TrackingReference:
+		return ConnectedTrackingReferences;
+	case ESteamVRTrackedDeviceType::Other:
+		return ConnectedTrackers;
+	default:
+		return NoDevices;
+	}
+}
+
+int32 FSteamVRTrackingLibModule::GetDeviceIdByControllerRole(ESteamVRControllerRole Role)
+{
+	UpdateDeviceIndex();
+
+	if (Role != ESteamVRControllerRole::Invalid)
+	{
+		for (const int32 DeviceId : ConnectedControllers)
 		{
-			TArray<int32> DeviceIds;
-			USteamVRFunctionLibrary::GetValidTrackedDeviceIds(BidningSetup->Type, DeviceIds);
+			if (IndexedDevices[DeviceId].Role == Role)
+			{
+				return DeviceId;
+			}
+		}
+	}
+	return INDEX_NONE;
+}
+
+uint32 FSteamVRTrackingLibModule::GetDeviceTopologyVersion()
+{
+	UpdateDeviceIndex();
+	return DeviceTopologyVersion;
+}
+
+void FSteamVRTrackingLibModule::UpdateDeviceIndex(bool bEndOfFrame)
+{
+	// game thread pose snapshot and therefore set of connected devices doesn't change during frame
+	if (DeviceIndexFrame == GFrameCounter && !bDeviceIndexDirty)
+	{
+		return;
+	}
+	DeviceIndexFrame = GFrameCounter;
+
+	const uint64 ConnectedMask = bEndOfFrame ? PoseCache.QueryConnectedDevicesMask() : PoseCache.GetConnectedDevicesMask();
+	if (ConnectedMask != IndexedDevicesMask || bDeviceIndexDirty)
+	{
+		RebuildDeviceIndex(ConnectedMask);
+	}
+	else if (UpdateControllerRoles())
+	{
+		DeviceTopologyVersion++;
+		bTopologyChangePending = true;
+	}
+}
+
+void FSteamVRTrackingLibModule::RebuildDeviceIndex(uint64 ConnectedMask)
+{
+	bDeviceIndexDirty = false;
+
+	STEAMVR_TRACKING_SCOPE(STAT_SteamVRTracking_DeviceIndexRebuild);
+
+	ISteamVRDeviceSource* DeviceSource = PoseCache.GetDeviceSource();
+	SerialToDeviceId.Reset();
+	ConnectedControllers.Reset();
+	ConnectedTrackers.Reset();
+	ConnectedTrackingReferences.Reset();
+
+	ANSICHAR OldSerialNumber[MaxSerialNumberLength];
+	for (int32 DeviceId = 0; DeviceId < FSteamVRDevicePoseCache::MaxDevices; DeviceId++)
+	{
+		FIndexedDevice& Device = IndexedDevices[DeviceId];
+		const bool bWasConnected = (IndexedDevicesMask & (1ull << DeviceId)) != 0;
+		const bool bConnected = DeviceSource && (ConnectedMask & (1ull << DeviceId));
+		const ESteamVRControllerRole OldRole = Device.Role;
+		FCStringAnsi::Strncpy(OldSerialNumber, Device.SerialNumber, MaxSerialNumberLength);
+
+		Device.SerialNumber[0] = '\0';
+		Device.SerialName = NAME_None;
+		Device.Type = ESteamVRTrackedDeviceType::Invalid;
+		Device.Role = ESteamVRControllerRole::Invalid;
 
-			for (const auto Id : DeviceIds)
+		if (bConnected)
+		{
+			Device.Type = DeviceSource->GetDeviceType(DeviceId);
+			switch (Device.Type)
 			{
-				FString SN = USteamVRTrackingLibBPLibrary::GetTrackedDeviceSerialNumber(Id);
+			case ESteamVRTrackedDeviceType::Controller:
+				ConnectedControllers.Add(DeviceId);
+				Device.Role = DeviceSource->GetControllerRole(DeviceId);
+				break;
+			case ESteamVRTrackedDeviceType::TrackingReference:
+				ConnectedTrackingReferences.Add(DeviceId);
+				break;
+			case ESteamVRTrackedDeviceType::Other:
+				ConnectedTrackers.Add(DeviceId);
+				break;
+			default:
+				break;
+			}
 
-				if (BidningSetup->SerialNumber.IsEqual(FName(*SN)))
+			if (!DeviceSource->GetSerialNumber(DeviceId, Device.SerialNumber, MaxSerialNumberLength))
+			{
+				Device.SerialNumber[0] = '\0';
+			}
+			else
+			{
+				// don't add new entries to global names table: serial number which isn't interned yet can't be used in any tracking setup
+				Device.SerialName = FName(Device.SerialNumber, FNAME_Find);
+				if (!Device.SerialName.IsNone())
 				{
-					BidningSetup->Id = Id;
-					break;
+					SerialToDeviceId.Add(Device.SerialName, DeviceId);
 				}
 			}
 		}
 
-		return BidningSetup->Id;
+		// SteamVR can give device ID of disconnected device to another one
+		const bool bReplaced = bWasConnected && bConnected && FCStringAnsi::Strcmp(OldSerialNumber, Device.SerialNumber) != 0;
+		if (bWasConnected && (!bConnected || bReplaced))
+		{
+			PendingTopologyChanges.Add(FSteamVRDeviceTopologyChange{ DeviceId, ESteamVRDeviceChange::Deactivated });
+		}
+		if (bConnected && (!bWasConnected || bReplaced))
+		{
+			PendingTopologyChanges.Add(FSteamVRDeviceTopologyChange{ DeviceId, ESteamVRDeviceChange::Activated });
+		}
+		else if (bConnected && Device.Role != OldRole)
+		{
+			PendingTopologyChanges.Add(FSteamVRDeviceTopologyChange{ DeviceId, ESteamVRDeviceChange::RoleChanged });
+		}
 	}
-	else
+
+	IndexedDevicesMask = DeviceSource ? ConnectedMask : 0;
+	DeviceTopologyVersion++;
+	bTopologyChangePending = true;
+
+	UpdateDeviceBindings();
+}
+
+bool FSteamVRTrackingLibModule::UpdateControllerRoles()
+{
+	ISteamVRDeviceSource* DeviceSource = PoseCache.GetDeviceSource();
+	if (!DeviceSource)
 	{
-		return INDEX_NONE;
+		return false;
+	}
+
+	bool bChanged = false;
+	for (const int32 DeviceId : ConnectedControllers)
+	{
+		const ESteamVRControllerRole Role = DeviceSource->GetControllerRole(DeviceId);
+		if (Role != IndexedDevices[DeviceId].Role)
+		{
+			IndexedDevices[DeviceId].Role = Role;
+			PendingTopologyChanges.Add(FSteamVRDeviceTopologyChange{ DeviceId, ESteamVRDeviceChange::RoleChanged });
+			bChanged = true;
+		}
+	}
+	return bChanged;
+}
+
+void FSteamVRTrackingLibModule::UpdateDeviceBindings()
+{
+	// readers can't see the snapshot until it's complete
+	TUniquePtr<FSteamVRDeviceRegistrySnapshot> Snapshot = MakeUnique<FSteamVRDeviceRegistrySnapshot>();
+	Snapshot->Bindings.Reserve(DeviceSetup.Num());
+	Snapshot->TopologyVersion = DeviceTopologyVersion;
+
+	FSteamVRPoseFilterSettings NewFilters[FSteamVRDevicePoseCache::MaxDevices];
+	FName NewFilterSerials[FSteamVRDevicePoseCache::MaxDevices];
+	for (const auto& Binding : DeviceSetup)
+	{
+		FSteamVRDeviceBindingSetup& NewBinding = Snapshot->Bindings.Add(Binding.Key, Binding.Value);
+		NewBinding.Id = FindBindingDeviceId(Binding.Value);
+
+		if (NewBinding.Id != INDEX_NONE)
+		{
+			NewFilters[NewBinding.Id] = Binding.Value.Filter;
+			NewFilterSerials[NewBinding.Id] = Binding.Value.SerialNumber;
+		}
 	}
+
+	// resetting filter state makes device jump, so unchanged filters are kept
+	for (int32 DeviceId = 0; DeviceId < FSteamVRDevicePoseCache::MaxDevices; DeviceId++)
+	{
+		if (NewFilters[DeviceId] != DeviceFilters[DeviceId] || NewFilterSerials[DeviceId] != DeviceFilterSerials[DeviceId])
+		{
+			DeviceFilters[DeviceId] = NewFilters[DeviceId];
+			DeviceFilterSerials[DeviceId] = NewFilterSerials[DeviceId];
+			PoseCache.SetDeviceFilter(DeviceId, NewFilters[DeviceId]);
+		}
+	}
+
+	DeviceRegistry.Publish(MoveTemp(Snapshot));
+}
+
+int32 FSteamVRTrackingLibModule::FindBindingDeviceId(const FSteamVRDeviceBindingSetup& Binding) const
+{
+	const int32* DeviceId = SerialToDeviceId.Find(Binding.SerialNumber);
+	if (DeviceId && (Binding.Type == ESteamVRTrackedDeviceType::Invalid || IndexedDevices[*DeviceId].Type == Binding.Type))
+	{
+		return *DeviceId;
+	}
+	return INDEX_NONE;
+}
+
+void FSteamVRTrackingLibModule::OnEndFrame()
+{
+	UpdateDeviceIndex(true);
+
+	if (bTopologyChangePending)
+	{
+		bTopologyChangePending = false;
+
+		// listeners can query device table, so don't broadcast array which can be modified.
+		// Both arrays keep their capacity.
+		Swap(PendingTopologyChanges, BroadcastTopologyChanges);
+		DeviceTopologyChanged.Broadcast(BroadcastTopologyChanges);
+		BroadcastTopologyChanges.Reset();
+	}
+
+	DeviceRegistry.CollectRetired();
+	FSteamVRTrackingCounters::PublishFrame();
 }
 
 void FSteamVRTrackingLibModule::InitializeTrackingNames(const USteamVRTrackingSetup* SteamVRTrackingSetup)
@@ -53,7 +420,66 @@ void FSteamVRTrackingLibModule::InitializeTrackingNames(const USteamVRTrackingSe
 
 void FSteamVRTrackingLibModule::InitializeTrackingNamesFromArray(const TArray<FSteamVRDeviceBindingSetup>& SteamVRTrackingDevices)
 {
-	DeviceSetup.Empty();
+	// new bindings become visible to other threads when the registry is published in UpdateDeviceIndex
+	check(IsInGameThread());
+	CopyTrackingNames(SteamVRTrackingDevices);
+
+	// serial numbers of the new setup could be missing in index, and filters should be reassigned
+	bDeviceIndexDirty = true;
+	UpdateDeviceIndex();
+}
+
+void FSteamVRTrackingLibModule::ReloadTrackingNamesFromArray(const TArray<FSteamVRDeviceBindingSetup>& SteamVRTrackingDevices)
+{
+	check(IsInGameThread());
+	UpdateDeviceIndex();
+	CopyTrackingNames(SteamVRTrackingDevices);
+
+	// connected devices with serial numbers which weren't interned when device index was built
+	for (const auto& Binding : DeviceSetup)
+	{
+		if (SerialToDeviceId.Contains(Binding.Value.SerialNumber))
+		{
+			continue;
+		}
+
+		const FString SerialNumber = Binding.Value.SerialNumber.ToString();
+		for (int32 DeviceId = 0; DeviceId < FSteamVRDevicePoseCache::MaxDevices; DeviceId++)
+		{
+			FIndexedDevice& Device = IndexedDevices[DeviceId];
+			if (Device.SerialNumber[0] != '\0' && FCString::Strcmp(*SerialNumber, ANSI_TO_TCHAR(Device.SerialNumber)) == 0)
+			{
+				Device.SerialName = Binding.Value.SerialNumber;
+				SerialToDeviceId.Add(Device.SerialName, DeviceId);
+				break;
+			}
+		}
+	}
+
+	// components and resolver only need to resolve IDs again if a name was moved to another device
+	const FSteamVRDeviceRegistrySnapshot& OldRegistry = DeviceRegistry.Read();
+	bool bIdsChanged = (OldRegistry.Bindings.Num() != DeviceSetup.Num());
+	for (const auto& Binding : DeviceSetup)
+	{
+		const FSteamVRDeviceBindingSetup* OldBinding = OldRegistry.Bindings.Find(Binding.Key);
+		if (!OldBinding || OldBinding->Id != FindBindingDeviceId(Binding.Value))
+		{
+			bIdsChanged = true;
+			break;
+		}
+	}
+	if (bIdsChanged)
+	{
+		DeviceTopologyVersion++;
+		bTopologyChangePending = true;
+	}
+
+	UpdateDeviceBindings();
+}
+
+void FSteamVRTrackingLibModule::CopyTrackingNames(const TArray<FSteamVRDeviceBindingSetup>& SteamVRTrackingDevices)
+{
+	DeviceSetup.Empty(SteamVRTrackingDevices.Num());
 	for (const auto& DeviceData : SteamVRTrackingDevices)
 	{
 		if (!DeviceData.SerialNumber.IsNone() && !DeviceData.FriendlyName.IsNone())
@@ -67,7 +493,7 @@ void FSteamVRTrackingLibModule::InitializeTrackingNamesFromArray(const TArray<FS
 
 void FSteamVRTrackingLibModule::GetTrackedDeviceSetupByName(const FName& FriendlyName, FSteamVRDeviceBindingSetup& OutData) const
 {
-	if (const FSteamVRDeviceBindingSetup* BidningSetup = DeviceSetup.Find(FriendlyName))
+	if (const FSteamVRDeviceBindingSetup* BidningSetup = DeviceRegistry.Read().Bindings.Find(FriendlyName))
 	{
 		OutData = *BidningSetup;
 	}
@@ -1,16 +1,17 @@
 // (c) YuriNK (ykasczc@gmail.com), 2020. You're free to use it whatever way you want.
 
 #include "SteamVRTrackingLibBPLibrary.h"
-#include "openvr.h"
-#include "Features/IModularFeatures.h"
-#include "IMotionController.h"
-#include "XRMotionControllerBase.h"
+#include "SteamVRDeviceSource.h"
 #include "SteamVRFunctionLibrary.h"
 #include "Misc/CString.h"
 #include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
 #include "Modules/ModuleManager.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
 #include "SteamVRTrackingSetup.h"
 #include "SteamVRTrackingLib.h"
+#include "SteamVRTrackingSetupWatcher.h"
 
 #include "Templates/SharedPointer.h"
 #include "Dom/JsonValue.h"
@@ -18,74 +19,6 @@
 #include "JsonObjectConverter.h"
 #include "JsonObjectWrapper.h"
 
-namespace JsonHelpers
-{
-	FString GetJsonTypeDesc(const EJson Type)
-	{
-		switch (Type)
-		{
-		case EJson::None:
-			return TEXT("EJson::None");
-		case EJson::Null:
-			return TEXT("EJson::Null");
-		case EJson::String:
-			return TEXT("EJson::String");
-		case EJson::Number:
-			return TEXT("EJson::Number");
-		case EJson::Boolean:
-			return TEXT("EJson::Boolean");
-		case EJson::Array:
-			return TEXT("EJson::Array");
-		case EJson::Object:
-			return TEXT("EJson::Object");
-		default:
-			return TEXT("UNKNOWN TYPE, should never happen");
-		}
-	}
-
-	int32 GetFormatVersion(const TSharedRef<const FJsonObject>& JsonRoot)
-	{
-		const FString KeyName = TEXT("FormatVersion");
-		if (JsonRoot->Values.Contains(KeyName))
-		{
-			double Value = 0.f;
-			if (JsonRoot->Values[KeyName]->TryGetNumber(Value))
-			{
-				return (int32)Value;
-			}
-		}
-		return 0;
-	}
-
-	bool ReadJsonDevice(const TSharedRef<const FJsonObject>& JsonDevice, FSteamVRDeviceBindingSetup& OutBinding)
-	{
-		const FString KeySN = TEXT("SerialNumber");
-		const FString KeyType = TEXT("Type");
-		const FString KeyName = TEXT("Name");
-
-		if (!JsonDevice->Values.Contains(KeySN) || !JsonDevice->Values.Contains(KeyType) || !JsonDevice->Values.Contains(KeyName))
-		{
-			return false;
-		}
-
-		FString DeviceType = JsonDevice->Values[KeyType]->AsString().ToLower();
-
-		OutBinding.Id = INDEX_NONE;
-		OutBinding.SerialNumber = FName(*JsonDevice->Values[KeySN]->AsString());
-
-		if (DeviceType == TEXT("controller"))
-			OutBinding.Type = ESteamVRTrackedDeviceType::Controller;
-		else if (DeviceType == TEXT("vivetracker"))
-			OutBinding.Type = ESteamVRTrackedDeviceType::Other;
-		else
-			return false;
-
-		OutBinding.FriendlyName = FName(*JsonDevice->Values[KeyName]->AsString());
-
-		return true;
-	}
-}
-
 ///////////////////////////////////////////////////////////////////////////////////////////////////////
 
 USteamVRTrackingLibBPLibrary::USteamVRTrackingLibBPLibrary(const FObjectInitializer& ObjectInitializer)
@@ -95,130 +28,109 @@ USteamVRTrackingLibBPLibrary::USteamVRTrackingLibBPLibrary(const FObjectInitiali
 
 int32 USteamVRTrackingLibBPLibrary::GetDeviceIdByMotionSource(const FName MotionSource, bool bAnyDeviceType, ESteamVRTrackedDeviceType DeviceType)
 {
-	const float WorldToMetersScale = 100.f;
-
-	bool bIsMotionSource = (MotionSource.IsEqual(TEXT("Right"))
-		|| MotionSource.IsEqual(TEXT("Left"))
-		|| MotionSource.ToString().Left(8) == TEXT("Special_"));
+	return FSteamVRTrackingLibModule::Get().GetMotionSourceResolver().GetDeviceIdByMotionSource(MotionSource, bAnyDeviceType, DeviceType);
+}
 
-	// using friendly name instead?
-	if (!bIsMotionSource)
+FString USteamVRTrackingLibBPLibrary::GetTrackedDeviceSerialNumber(int32 DeviceID)
+{
+	// connected devices are already indexed by module
+	if (const ANSICHAR* IndexedSerialNumber = FSteamVRTrackingLibModule::Get().GetTrackedDeviceSerialNumber(DeviceID))
 	{
-		return USteamVRTrackingLibBPLibrary::GetTrackedDeviceIdByName(MotionSource, false);
+		return ANSI_TO_TCHAR(IndexedSerialNumber);
 	}
 
-	TArray<IMotionController*> MotionControllers = IModularFeatures::Get().GetModularFeatureImplementations<IMotionController>(IMotionController::GetModularFeatureName());
+	ISteamVRDeviceSource* DeviceSource = FSteamVRTrackingLibModule::Get().GetPoseCache().GetDeviceSource();
 
-	FVector Location;
-	FRotator Rotation;
-	bool HasValidValue = false;
-	for (auto MotionController : MotionControllers)
+	if (DeviceSource && DeviceSource->IsAvailable())
 	{
-		if (MotionController != nullptr && MotionController->GetControllerOrientationAndPosition(0, MotionSource, Rotation, Location, WorldToMetersScale))
+		char OutString[256];
+		if (DeviceSource->GetSerialNumber(DeviceID, OutString, 256))
 		{
-			HasValidValue = true;
-			break;
+			return ANSI_TO_TCHAR(OutString);
+		}
+		else
+		{
+			return TEXT("Property Read Error");
 		}
 	}
-
-	if (Location.IsZero())
+	else
 	{
-		HasValidValue = false;
+		return TEXT("Can't find SteamVR");
 	}
+	return TEXT("");
+}
 
-	if (HasValidValue)
+void USteamVRTrackingLibBPLibrary::SetBackgroundSamplingEnabled(bool bEnabled, float SampleRate, int32 BufferSize)
+{
+	FSteamVRTrackingSampler& Sampler = FSteamVRTrackingLibModule::Get().GetTrackingSampler();
+	if (bEnabled)
 	{
-		float MinDistance = 10000.f;
-		float MinId = INDEX_NONE;
-
-		TArray<int32> OutDevices;
-		if (bAnyDeviceType)
-		{
-			TArray<int32> OutTrackers;
-			USteamVRFunctionLibrary::GetValidTrackedDeviceIds(ESteamVRTrackedDeviceType::Controller, OutDevices);
-			USteamVRFunctionLibrary::GetValidTrackedDeviceIds(ESteamVRTrackedDeviceType::Other, OutTrackers);
-			OutDevices.Append(OutTrackers);
-		}
-		else
-		{
-			USteamVRFunctionLibrary::GetValidTrackedDeviceIds(DeviceType, OutDevices);
-		}
-
-		for (auto DeviceId : OutDevices)
-		{
-			FVector CtrlLocation;
-			FRotator CtrlRotation;
-
-			USteamVRFunctionLibrary::GetTrackedDevicePositionAndOrientation(DeviceId, CtrlLocation, CtrlRotation);
-
-			const float NewDistance = FVector::DistSquared(CtrlLocation, Location);
-			if (NewDistance < MinDistance)
-			{
-				MinDistance = NewDistance;
-				MinId = DeviceId;
-			}
-		}
-
-		if (MinDistance > 5.f * 5.f)
-		{
-			MinId = INDEX_NONE;
-		}
-
-		return MinId;
+		Sampler.StartSampling(SampleRate, BufferSize);
 	}
 	else
 	{
-		FString szMotionSource = MotionSource.ToString();
-		if (szMotionSource.Left(7) == TEXT("Special"))
-		{
-			FString szTrackerNumber = *MotionSource.ToString().Right(szMotionSource.Len() - 8);
-			//UE_LOG(LogTemp, Log, TEXT("MotionSource is tracker, szTrackerNumber = "), *szTrackerNumber);
+		Sampler.StopSampling();
+	}
+}
 
-			int32 TrackerNumber = FCString::Atoi(*szTrackerNumber);
+bool USteamVRTrackingLibBPLibrary::GetLatestSampledDevicePose(int32 DeviceID, FVector& Position, FRotator& Orientation, float WorldToMetersScale)
+{
+	FSteamVRDevicePose Pose;
+	if (FSteamVRTrackingLibModule::Get().GetTrackingSampler().GetLatestPose(DeviceID, Pose) && Pose.bPoseValid)
+	{
+		Position = Pose.Position * WorldToMetersScale;
+		Orientation = Pose.Orientation.Rotator();
+		return true;
+	}
+	return false;
+}
 
-			TArray<int32> OutTrackers;
-			USteamVRFunctionLibrary::GetValidTrackedDeviceIds(ESteamVRTrackedDeviceType::Other, OutTrackers);
+bool USteamVRTrackingLibBPLibrary::GetTrackedDeviceDropoutStats(int32 DeviceID, int32& DropoutCount, float& TotalDropoutTime, float& LongestDropoutTime, bool& bInDropout)
+{
+	const FSteamVRDeviceTrackingState* TrackingState = FSteamVRTrackingLibModule::Get().GetPoseCache().GetDeviceTrackingState(DeviceID);
+	if (!TrackingState)
+	{
+		return false;
+	}
 
-			//UE_LOG(LogTemp, Log, TEXT("Have %d active trackers with required numbrr %d"), OutTrackers.Num(), TrackerNumber);
+	DropoutCount = (int32)TrackingState->NumDropouts;
+	TotalDropoutTime = (float)TrackingState->TotalDropoutSeconds;
+	LongestDropoutTime = (float)TrackingState->LongestDropoutSeconds;
+	bInDropout = TrackingState->IsInDropout();
+	return true;
+}
 
-			if (TrackerNumber > 0 && OutTrackers.Num() >= TrackerNumber)
-			{
-				OutTrackers.Sort();
-				return OutTrackers[TrackerNumber - 1];
-			}
-		}
+void USteamVRTrackingLibBPLibrary::ResetTrackingDropoutStats()
+{
+	FSteamVRTrackingLibModule::Get().GetPoseCache().ResetDropoutStats();
+}
 
-		return INDEX_NONE;
+void USteamVRTrackingLibBPLibrary::PrewarmDeviceRenderModels(UObject* WorldContextObject)
+{
+	UWorld* World = GEngine ? GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::LogAndReturnNull) : nullptr;
+	if (World)
+	{
+		FSteamVRTrackingLibModule::Get().GetRenderModelCache().PrewarmConnectedDevices(World);
 	}
 }
 
-FString USteamVRTrackingLibBPLibrary::GetTrackedDeviceSerialNumber(int32 DeviceID)
+bool USteamVRTrackingLibBPLibrary::StartTrackingSessionRecording(const FString& FileName)
 {
-	vr::IVRSystem* SteamVRSystem = vr::VRSystem();
-
-	if (SteamVRSystem)
+	FString FullFileName = FileName;
+	if (FPaths::IsRelative(FullFileName))
 	{
-		char OutString[256];
-
-		vr::ETrackedPropertyError OutError = vr::ETrackedPropertyError::TrackedProp_Success;
-		const vr::ETrackedDeviceProperty Prop_SN = vr::ETrackedDeviceProperty::Prop_SerialNumber_String;
-
-		SteamVRSystem->GetStringTrackedDeviceProperty((vr::TrackedDeviceIndex_t)DeviceID, Prop_SN, OutString, 256, &OutError);
-
-		if (OutError == vr::ETrackedPropertyError::TrackedProp_Success)
-		{
-			return ANSI_TO_TCHAR(OutString);
-		}
-		else
-		{
-			return TEXT("Property Read Error");
-		}
+		FullFileName = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("TrackingSessions"), FileName);
 	}
-	else
+	if (FPaths::GetExtension(FullFileName).IsEmpty())
 	{
-		return TEXT("Can't find SteamVR");
+		FullFileName += TEXT(".svrrec");
 	}
-	return TEXT("");
+	return FSteamVRTrackingLibModule::Get().GetTrackingRecorder().StartRecording(FullFileName);
+}
+
+void USteamVRTrackingLibBPLibrary::StopTrackingSessionRecording()
+{
+	FSteamVRTrackingLibModule::Get().GetTrackingRecorder().StopRecording();
 }
 
 bool USteamVRTrackingLibBPLibrary::SetSteamVRTrackingSetup(USteamVRTrackingSetup* TrackingSetup)
@@ -267,6 +179,13 @@ void USteamVRTrackingLibBPLibrary::ExportTrackingSetupToJSON(const TArray<FSteam
 		JsonDeviceObject->SetField(KeySN, MakeShared<FJsonValueString>(DeviceBinding.SerialNumber.ToString()));
 		JsonDeviceObject->SetField(KeyType, MakeShared<FJsonValueString>(DevTyp));
 		JsonDeviceObject->SetField(KeyName, MakeShared<FJsonValueString>(DeviceBinding.FriendlyName.ToString()));
+		if (DeviceBinding.Filter.Type != ESteamVRPoseFilter::None)
+		{
+			JsonDeviceObject->SetStringField(TEXT("Filter"), StaticEnum<ESteamVRPoseFilter>()->GetNameStringByValue((int64)DeviceBinding.Filter.Type));
+			JsonDeviceObject->SetNumberField(TEXT("MinCutoff"), DeviceBinding.Filter.MinCutoff);
+			JsonDeviceObject->SetNumberField(TEXT("Beta"), DeviceBinding.Filter.Beta);
+			JsonDeviceObject->SetNumberField(TEXT("SmoothTime"), DeviceBinding.Filter.SmoothTime);
+		}
 		
 		JsonDevicesArray.Push(MakeShared<FJsonValueObject>(JsonDeviceObject));
 	}
@@ -292,60 +211,38 @@ bool USteamVRTrackingLibBPLibrary::ImportTrackingSetupFromJSON(TArray<FSteamVRDe
 		return false;
 	}
 
-	TSharedPtr<FJsonObject> JsonObject;
-	TSharedRef<TJsonReader<>> JsonReader = TJsonReaderFactory<>::Create(JsonString);
-
-	if (!FJsonSerializer::Deserialize(JsonReader, JsonObject) || !JsonObject.IsValid())
+	TArray<FSteamVRDeviceBindingSetup> TrackingSetup;
+	int32 FileFormatVersion = 0;
+	FString Error;
+	if (!FSteamVRTrackingSetupJson::Parse(JsonString, TrackingSetup, FileFormatVersion, Error))
 	{
-		UE_LOG(LogTemp, Error, TEXT("Unable to parse json=[%s]"), *JsonString);
+		UE_LOG(LogTemp, Error, TEXT("TrackingSetup file [%s] has invalid format: %s"), *ImportFileName, *Error);
 		return false;
 	}
-
-	int32 FileFormatVersion = JsonHelpers::GetFormatVersion(JsonObject.ToSharedRef());
 	UE_LOG(LogTemp, Log, TEXT("Reading TrackingSetup file. Format Version: %d"), FileFormatVersion);
 
-	// Read json array	
-	const FString KeyDevices = TEXT("Devices");
-
-	if (!JsonObject->Values.Contains(KeyDevices))
-	{
-		UE_LOG(LogTemp, Error, TEXT("TrackingSetup file [%s] has invalid format."), *ImportFileName);
-		return false;
-	}
-	const TSharedPtr<FJsonValue>& DevicesObject = JsonObject->Values[KeyDevices];
-	if (DevicesObject->Type != EJson::Array)
-	{
-		UE_LOG(LogTemp, Error, TEXT("TrackingSetup file [%s] has invalid format."), *ImportFileName);
-		return false;
-	}
-
-	OutTrackingSetup.Empty();
+	OutTrackingSetup = MoveTemp(TrackingSetup);
+	return true;
+}
 
-	// load all devices
-	const auto DevicesList = DevicesObject->AsArray();
-	for (const auto& Device : DevicesList)
+bool USteamVRTrackingLibBPLibrary::SetTrackingSetupFileWatching(bool bEnabled, const FString& FileName, float PollInterval)
+{
+	FSteamVRTrackingSetupWatcher& Watcher = FSteamVRTrackingLibModule::Get().GetTrackingSetupWatcher();
+	if (bEnabled)
 	{
-		//UE_LOG(LogTemp, Log, TEXT("Device loaded. Type is %s"), *JsonHelpers::GetJsonTypeDesc(Device->Type));
-		if (Device->Type != EJson::Object)
-		{
-			UE_LOG(LogTemp, Error, TEXT("TrackingSetup file [%s] has invalid format."), *ImportFileName);
-			return false;
-		}
-
-		const TSharedPtr<FJsonObject> DeviceObject = Device->AsObject();
-		FSteamVRDeviceBindingSetup NewBinding;
-		if (!JsonHelpers::ReadJsonDevice(DeviceObject.ToSharedRef(), NewBinding))
-		{
-			UE_LOG(LogTemp, Error, TEXT("TrackingSetup file [%s] has invalid format."), *ImportFileName);
-			return false;
-		}
-
-		OutTrackingSetup.Add(NewBinding);
+		return Watcher.StartWatching(FileName, PollInterval);
 	}
-
+	Watcher.StopWatching();
 	return true;
 }
 
+bool USteamVRTrackingLibBPLibrary::IsTrackedDeviceSerialNumber(int32 DeviceID, const FName& SerialNumber)
+{
+	// FNAME_Find only looks name up, serial number of another device can't be in the name table
+	const ANSICHAR* IndexedSerialNumber = FSteamVRTrackingLibModule::Get().GetTrackedDeviceSerialNumber(DeviceID);
+	return IndexedSerialNumber && !SerialNumber.IsNone() && FName(IndexedSerialNumber, FNAME_Find) == SerialNumber;
+}
+
 FName USteamVRTrackingLibBPLibrary::GetTrackedDeviceSerialNumberByName(const FName& DeviceFriendlyName)
 {
 	FSteamVRDeviceBindingSetup Data;
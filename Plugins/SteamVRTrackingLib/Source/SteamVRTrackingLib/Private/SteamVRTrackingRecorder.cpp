@@ -0,0 +1,297 @@
+// (c) YuriNK (ykasczc@gmail.com), 2020. You're free to use it whatever way you want.
+
+#include "SteamVRTrackingRecorder.h"
+#include "HAL/RunnableThread.h"
+#include "HAL/PlatformFilemanager.h"
+#include "HAL/PlatformProcess.h"
+#include "Misc/DateTime.h"
+#include "Misc/Paths.h"
+#include "SteamVRDeviceSource.h"
+
+using namespace SteamVRRecording;
+
+FSteamVRTrackingRecorder::FSteamVRTrackingRecorder(FSteamVRTrackingSampler& InSampler)
+	: Sampler(InSampler)
+	, Thread(nullptr)
+	, bStopRequested(false)
+	, bWriteError(false)
+	, NumRecordedSamples(0)
+	, NumDroppedSamples(0)
+	, KnownDevicesMask(0)
+	, NextSampleIndex(0)
+{
+	FMemory::Memzero(FileHeader);
+	FMemory::Memzero(ChunkHeader);
+}
+
+FSteamVRTrackingRecorder::~FSteamVRTrackingRecorder()
+{
+	StopRecording();
+}
+
+bool FSteamVRTrackingRecorder::StartRecording(const FString& FileName)
+{
+	check(IsInGameThread());
+	StopRecording();
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	PlatformFile.CreateDirectoryTree(*FPaths::GetPath(FileName));
+	File.Reset(PlatformFile.OpenWrite(*FileName));
+	if (!File.IsValid())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("SteamVRTrackingRecorder: can't open file %s"), *FileName);
+		return false;
+	}
+
+	FMemory::Memzero(FileHeader);
+	FileHeader.Magic = FileMagic;
+	FileHeader.Version = FormatVersion;
+	FileHeader.HeaderSize = sizeof(FFileHeader);
+	FileHeader.StartTime = FPlatformTime::Seconds();
+	FileHeader.StartDateTimeTicks = FDateTime::UtcNow().GetTicks();
+	bWriteError.store(false);
+	if (!WriteToFile(&FileHeader, sizeof(FFileHeader)))
+	{
+		return false;
+	}
+
+	if (!Sampler.IsRunning())
+	{
+		Sampler.StartSampling();
+	}
+
+	ChunkBuffer.SetNumUninitialized(sizeof(FChunkHeader) + ChunkCapacity * sizeof(FPoseRecord));
+	FMemory::Memzero(ChunkHeader);
+	DeviceTable.Reset();
+	ChunkIndex.Reset();
+	KnownDevicesMask = 0;
+	NextSampleIndex = Sampler.GetNumSamples();
+	NumRecordedSamples.store(0);
+	NumDroppedSamples.store(0);
+
+	bStopRequested.store(false);
+	Thread = FRunnableThread::Create(this, TEXT("SteamVRTrackingRecorder"), 0, TPri_BelowNormal);
+	if (!Thread)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("SteamVRTrackingRecorder: can't create recorder thread"));
+		File.Reset();
+		return false;
+	}
+	return true;
+}
+
+void FSteamVRTrackingRecorder::StopRecording()
+{
+	if (Thread)
+	{
+		Thread->Kill(true);
+		delete Thread;
+		Thread = nullptr;
+
+		if (HasWriteError())
+		{
+			UE_LOG(LogTemp, Warning, TEXT("SteamVRTrackingRecorder: session is incomplete, %llu samples recorded before write error"), GetNumRecordedSamples());
+		}
+	}
+}
+
+uint32 FSteamVRTrackingRecorder::Run()
+{
+	// wake up often enough to never let sampler overwrite unread samples
+	const float PollInterval = FMath::Clamp(0.25f * Sampler.GetCapacity() / Sampler.GetSampleRate(), 0.001f, 0.05f);
+
+	while (!bStopRequested.load(std::memory_order_relaxed) && !HasWriteError())
+	{
+		ReadNewSamples();
+		FPlatformProcess::SleepNoStats(PollInterval);
+	}
+	ReadNewSamples();
+	FinalizeFile();
+
+	return 0;
+}
+
+void FSteamVRTrackingRecorder::ReadNewSamples()
+{
+	const uint64 NumSamples = Sampler.GetNumSamples();
+	const uint64 OldestSample = Sampler.GetOldestSampleIndex();
+	if (NextSampleIndex < OldestSample)
+	{
+		NumDroppedSamples.fetch_add(OldestSample - NextSampleIndex, std::memory_order_relaxed);
+		NextSampleIndex = OldestSample;
+	}
+
+	for (; NextSampleIndex < NumSamples && !HasWriteError(); NextSampleIndex++)
+	{
+		if (Sampler.ReadSample(NextSampleIndex, Sample))
+		{
+			WriteSample(NextSampleIndex);
+			NumRecordedSamples.fetch_add(1, std::memory_order_relaxed);
+		}
+		else
+		{
+			NumDroppedSamples.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+}
+
+void FSteamVRTrackingRecorder::WriteSample(uint64 SampleIndex)
+{
+	if (Sample.ConnectedMask & ~KnownDevicesMask)
+	{
+		WriteNewDevices(SampleIndex, Sample.ConnectedMask);
+	}
+	KnownDevicesMask = Sample.ConnectedMask;
+
+	// start new chunk if this sample doesn't fit
+	const int32 NumDevices = FMath::CountBits(Sample.ConnectedMask);
+	if (ChunkHeader.NumRecords > 0
+		&& (ChunkHeader.NumRecords + NumDevices > ChunkCapacity
+			|| SampleIndex - ChunkHeader.FirstSampleIndex > MAX_uint16
+			|| Sample.Timestamp - ChunkHeader.ChunkTime > 3600.0))
+	{
+		FlushChunk();
+	}
+	if (ChunkHeader.NumRecords == 0)
+	{
+		ChunkHeader.FirstSampleIndex = SampleIndex;
+		ChunkHeader.ChunkTime = Sample.Timestamp;
+	}
+	ChunkHeader.LastSampleIndex = SampleIndex;
+
+	const uint32 TimeOffset = (uint32)FMath::Max((Sample.Timestamp - ChunkHeader.ChunkTime) * 1e6, 0.0);
+	const uint16 SampleOffset = (uint16)(SampleIndex - ChunkHeader.FirstSampleIndex);
+	FPoseRecord* Records = GetRecords();
+
+	for (uint64 Mask = Sample.ConnectedMask; Mask != 0; Mask &= Mask - 1)
+	{
+		const int32 DeviceId = (int32)FMath::CountTrailingZeros64(Mask);
+		const FSteamVRDevicePose& Pose = Sample.Poses[DeviceId];
+
+		FPoseRecord& Record = Records[ChunkHeader.NumRecords++];
+		Record.TimeOffset = TimeOffset;
+		Record.SampleOffset = SampleOffset;
+		Record.DeviceId = (uint8)DeviceId;
+		Record.TrackingState = (uint8)(!Pose.bPoseValid ? ETrackingState::NotTracked : (Pose.bOutOfRange ? ETrackingState::InertialOnly : ETrackingState::Tracked));
+		Record.Position[0] = (float)Pose.Position.X;
+		Record.Position[1] = (float)Pose.Position.Y;
+		Record.Position[2] = (float)Pose.Position.Z;
+		Record.Orientation[0] = (float)Pose.Orientation.X;
+		Record.Orientation[1] = (float)Pose.Orientation.Y;
+		Record.Orientation[2] = (float)Pose.Orientation.Z;
+		Record.Orientation[3] = (float)Pose.Orientation.W;
+	}
+}
+
+void FSteamVRTrackingRecorder::WriteNewDevices(uint64 SampleIndex, uint64 ConnectedMask)
+{
+	ISteamVRDeviceSource* DeviceSource = Sampler.GetDeviceSource();
+	const int32 FirstNewDevice = DeviceTable.Num();
+
+	for (uint64 Mask = ConnectedMask & ~KnownDevicesMask; Mask != 0; Mask &= Mask - 1)
+	{
+		const int32 DeviceId = (int32)FMath::CountTrailingZeros64(Mask);
+
+		FDeviceEntry& Device = DeviceTable.AddZeroed_GetRef();
+		Device.FirstSampleIndex = SampleIndex;
+		Device.DeviceId = (uint8)DeviceId;
+		Device.DeviceType = (uint8)ESteamVRTrackedDeviceType::Invalid;
+
+		if (DeviceSource)
+		{
+			Device.DeviceType = (uint8)DeviceSource->GetDeviceType(DeviceId);
+			DeviceSource->GetSerialNumber(DeviceId, Device.SerialNumber, MaxSerialNumberLength);
+		}
+	}
+
+	// device chunk is written right away, so serial numbers survive if session isn't finalized
+	FChunkHeader DeviceChunk;
+	FMemory::Memzero(DeviceChunk);
+	DeviceChunk.Magic = DeviceChunkMagic;
+	DeviceChunk.NumRecords = DeviceTable.Num() - FirstNewDevice;
+	DeviceChunk.FirstSampleIndex = DeviceChunk.LastSampleIndex = SampleIndex;
+	DeviceChunk.ChunkTime = Sample.Timestamp;
+
+	// pose chunk in progress is written after device chunk, it's fine for reader
+	if (WriteToFile(&DeviceChunk, sizeof(FChunkHeader)))
+	{
+		WriteToFile(&DeviceTable[FirstNewDevice], DeviceChunk.NumRecords * sizeof(FDeviceEntry));
+	}
+}
+
+void FSteamVRTrackingRecorder::FlushChunk()
+{
+	if (ChunkHeader.NumRecords == 0 || !File.IsValid())
+	{
+		return;
+	}
+
+	ChunkHeader.Magic = ChunkMagic;
+	FMemory::Memcpy(ChunkBuffer.GetData(), &ChunkHeader, sizeof(FChunkHeader));
+
+	const uint64 Offset = (uint64)File->Tell();
+	if (WriteToFile(ChunkBuffer.GetData(), sizeof(FChunkHeader) + ChunkHeader.NumRecords * sizeof(FPoseRecord)))
+	{
+		ChunkIndex.Add(FChunkIndexEntry{ Offset, ChunkHeader.ChunkTime });
+	}
+
+	FileHeader.NumSamples += ChunkHeader.LastSampleIndex - ChunkHeader.FirstSampleIndex + 1;
+	ChunkHeader.NumRecords = 0;
+}
+
+void FSteamVRTrackingRecorder::FinalizeFile()
+{
+	if (!File.IsValid())
+	{
+		return;
+	}
+	FlushChunk();
+	// after write error the file is already closed, reader scans its complete chunks
+	if (!File.IsValid())
+	{
+		return;
+	}
+
+	FileHeader.DeviceTableOffset = (uint64)File->Tell();
+	FileHeader.NumDevices = DeviceTable.Num();
+	if (!WriteToFile(DeviceTable.GetData(), DeviceTable.Num() * sizeof(FDeviceEntry)))
+	{
+		return;
+	}
+
+	FileHeader.ChunkIndexOffset = (uint64)File->Tell();
+	FileHeader.NumChunks = ChunkIndex.Num();
+	if (!WriteToFile(ChunkIndex.GetData(), ChunkIndex.Num() * sizeof(FChunkIndexEntry)))
+	{
+		return;
+	}
+
+	if (!File->Seek(0))
+	{
+		UE_LOG(LogTemp, Error, TEXT("SteamVRTrackingRecorder: can't finalize session file, device table and chunk index aren't saved"));
+		bWriteError.store(true);
+		File.Reset();
+		return;
+	}
+	if (WriteToFile(&FileHeader, sizeof(FFileHeader)))
+	{
+		File->Flush();
+		File.Reset();
+	}
+}
+
+bool FSteamVRTrackingRecorder::WriteToFile(const void* Source, int64 Size)
+{
+	if (!File.IsValid())
+	{
+		return false;
+	}
+	if (!File->Write(reinterpret_cast<const uint8*>(Source), Size))
+	{
+		UE_LOG(LogTemp, Error, TEXT("SteamVRTrackingRecorder: can't write session file, recording is stopped"));
+		bWriteError.store(true);
+		File.Reset();
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,218 @@
+// (c) YuriNK (ykasczc@gmail.com), 2020. You're free to use it whatever way you want.
+
+#include "SteamVRTrackingRecording.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Async/MappedFileHandle.h"
+#include "Algo/BinarySearch.h"
+
+using namespace SteamVRRecording;
+
+FSteamVRTrackingRecordingReader::FSteamVRTrackingRecordingReader()
+	: Data(nullptr)
+	, DataSize(0)
+	, Header(nullptr)
+{
+}
+
+FSteamVRTrackingRecordingReader::~FSteamVRTrackingRecordingReader()
+{
+	Close();
+}
+
+bool FSteamVRTrackingRecordingReader::Open(const FString& FileName)
+{
+	Close();
+
+	MappedFile.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*FileName));
+	if (!MappedFile.IsValid() || MappedFile->GetFileSize() < (int64)sizeof(FFileHeader))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("SteamVRTrackingRecordingReader: can't open file %s"), *FileName);
+		Close();
+		return false;
+	}
+
+	MappedRegion.Reset(MappedFile->MapRegion(0, MappedFile->GetFileSize()));
+	if (!MappedRegion.IsValid())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("SteamVRTrackingRecordingReader: can't map file %s"), *FileName);
+		Close();
+		return false;
+	}
+	Data = MappedRegion->GetMappedPtr();
+	DataSize = MappedRegion->GetMappedSize();
+
+	const FFileHeader* FileHeader = reinterpret_cast<const FFileHeader*>(Data);
+	if (FileHeader->Magic != FileMagic || FileHeader->Version > FormatVersion || FileHeader->HeaderSize < sizeof(FFileHeader))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("SteamVRTrackingRecordingReader: %s isn't a tracking session file"), *FileName);
+		Close();
+		return false;
+	}
+	Header = FileHeader;
+
+	// offsets of corrupted file can be anything, so they're checked without overflow
+	const bool bDeviceTableInFile = Header->DeviceTableOffset != 0 && Header->DeviceTableOffset <= (uint64)DataSize
+		&& Header->NumDevices <= ((uint64)DataSize - Header->DeviceTableOffset) / sizeof(FDeviceEntry);
+	const bool bChunkIndexInFile = Header->ChunkIndexOffset != 0 && Header->ChunkIndexOffset <= (uint64)DataSize
+		&& Header->NumChunks <= ((uint64)DataSize - Header->ChunkIndexOffset) / sizeof(FChunkIndexEntry);
+	if (bDeviceTableInFile && bChunkIndexInFile)
+	{
+		Devices = MakeArrayView(reinterpret_cast<const FDeviceEntry*>(Data + Header->DeviceTableOffset), Header->NumDevices);
+		ChunkIndex = MakeArrayView(reinterpret_cast<const FChunkIndexEntry*>(Data + Header->ChunkIndexOffset), Header->NumChunks);
+		if (!IsChunkIndexValid())
+		{
+			UE_LOG(LogTemp, Warning, TEXT("SteamVRTrackingRecordingReader: %s has invalid chunk index, scanning chunks"), *FileName);
+			ScanChunks();
+		}
+	}
+	else
+	{
+		UE_LOG(LogTemp, Log, TEXT("SteamVRTrackingRecordingReader: %s wasn't finalized, scanning chunks"), *FileName);
+		ScanChunks();
+	}
+
+	return true;
+}
+
+void FSteamVRTrackingRecordingReader::Close()
+{
+	Header = nullptr;
+	Devices = TArrayView<const FDeviceEntry>();
+	ChunkIndex = TArrayView<const FChunkIndexEntry>();
+	ScannedChunkIndex.Empty();
+	ScannedDevices.Empty();
+	Data = nullptr;
+	DataSize = 0;
+	MappedRegion.Reset();
+	MappedFile.Reset();
+}
+
+bool FSteamVRTrackingRecordingReader::IsChunkIndexValid() const
+{
+	for (const FChunkIndexEntry& Entry : ChunkIndex)
+	{
+		if (Entry.Offset < Header->HeaderSize || Entry.Offset > (uint64)DataSize || (uint64)DataSize - Entry.Offset < sizeof(FChunkHeader))
+		{
+			return false;
+		}
+		const FChunkHeader* Chunk = reinterpret_cast<const FChunkHeader*>(Data + Entry.Offset);
+		if (Chunk->Magic != ChunkMagic || Chunk->NumRecords > ((uint64)DataSize - Entry.Offset - sizeof(FChunkHeader)) / sizeof(FPoseRecord))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+void FSteamVRTrackingRecordingReader::ScanChunks()
+{
+	int64 Offset = Header->HeaderSize;
+	while (Offset + (int64)sizeof(FChunkHeader) <= DataSize)
+	{
+		const FChunkHeader* Chunk = reinterpret_cast<const FChunkHeader*>(Data + Offset);
+		const int64 RecordSize = Chunk->Magic == DeviceChunkMagic ? sizeof(FDeviceEntry) : sizeof(FPoseRecord);
+		const int64 ChunkEnd = Offset + sizeof(FChunkHeader) + Chunk->NumRecords * RecordSize;
+		if ((Chunk->Magic != ChunkMagic && Chunk->Magic != DeviceChunkMagic) || ChunkEnd > DataSize)
+		{
+			// end of data or chunk was cut by crash
+			break;
+		}
+
+		if (Chunk->Magic == DeviceChunkMagic)
+		{
+			ScannedDevices.Append(reinterpret_cast<const FDeviceEntry*>(Chunk + 1), Chunk->NumRecords);
+		}
+		else
+		{
+			ScannedChunkIndex.Add(FChunkIndexEntry{ (uint64)Offset, Chunk->ChunkTime });
+		}
+		Offset = ChunkEnd;
+	}
+
+	Devices = ScannedDevices;
+	ChunkIndex = ScannedChunkIndex;
+}
+
+const FChunkHeader& FSteamVRTrackingRecordingReader::GetChunkHeader(int32 Chunk) const
+{
+	check(ChunkIndex.IsValidIndex(Chunk));
+	return *reinterpret_cast<const FChunkHeader*>(Data + ChunkIndex[Chunk].Offset);
+}
+
+TArrayView<const FPoseRecord> FSteamVRTrackingRecordingReader::GetChunkRecords(int32 Chunk) const
+{
+	const FChunkHeader& ChunkHeader = GetChunkHeader(Chunk);
+	return MakeArrayView(reinterpret_cast<const FPoseRecord*>(&ChunkHeader + 1), ChunkHeader.NumRecords);
+}
+
+double FSteamVRTrackingRecordingReader::GetRecordTime(int32 Chunk, const FPoseRecord& Record) const
+{
+	return GetChunkHeader(Chunk).ChunkTime + Record.TimeOffset * 1e-6;
+}
+
+double FSteamVRTrackingRecordingReader::GetStartTime() const
+{
+	return ChunkIndex.Num() > 0 ? ChunkIndex[0].ChunkTime : (Header ? Header->StartTime : 0.0);
+}
+
+double FSteamVRTrackingRecordingReader::GetEndTime() const
+{
+	if (ChunkIndex.Num() == 0)
+	{
+		return GetStartTime();
+	}
+
+	const int32 LastChunk = ChunkIndex.Num() - 1;
+	const TArrayView<const FPoseRecord> Records = GetChunkRecords(LastChunk);
+	return Records.Num() > 0 ? GetRecordTime(LastChunk, Records.Last()) : ChunkIndex[LastChunk].ChunkTime;
+}
+
+int32 FSteamVRTrackingRecordingReader::FindChunk(double Time) const
+{
+	// first chunk starting later than Time
+	const int32 NextChunk = Algo::UpperBoundBy(ChunkIndex, Time, [](const FChunkIndexEntry& Entry) { return Entry.ChunkTime; });
+	return NextChunk - 1;
+}
+
+const FPoseRecord* FSteamVRTrackingRecordingReader::FindDeviceRecord(int32 DeviceId, double Time) const
+{
+	const int32 StartChunk = FindChunk(Time);
+
+	// device is usually present in every sample, so previous chunk is enough if it isn't in current one
+	for (int32 Chunk = StartChunk; Chunk >= 0 && Chunk >= StartChunk - 1; Chunk--)
+	{
+		const FChunkHeader& ChunkHeader = GetChunkHeader(Chunk);
+		const TArrayView<const FPoseRecord> Records = GetChunkRecords(Chunk);
+		const uint32 MaxTimeOffset = (uint32)FMath::Clamp((Time - ChunkHeader.ChunkTime) * 1e6, 0.0, (double)MAX_uint32);
+
+		for (int32 Index = Records.Num() - 1; Index >= 0; Index--)
+		{
+			const FPoseRecord& Record = Records[Index];
+			if (Record.DeviceId == DeviceId && Record.TimeOffset <= MaxTimeOffset)
+			{
+				return &Record;
+			}
+		}
+	}
+	return nullptr;
+}
+
+const FDeviceEntry* FSteamVRTrackingRecordingReader::FindDevice(int32 DeviceId, uint64 SampleIndex) const
+{
+	const FDeviceEntry* Result = nullptr;
+	for (const FDeviceEntry& Device : Devices)
+	{
+		if (Device.DeviceId == DeviceId && Device.FirstSampleIndex <= SampleIndex
+			&& (!Result || Device.FirstSampleIndex > Result->FirstSampleIndex))
+		{
+			Result = &Device;
+		}
+	}
+	return Result;
+}
+
+const ANSICHAR* FSteamVRTrackingRecordingReader::GetDeviceSerialNumber(int32 DeviceId, uint64 SampleIndex) const
+{
+	const FDeviceEntry* Device = FindDevice(DeviceId, SampleIndex);
+	return Device ? Device->SerialNumber : nullptr;
+}
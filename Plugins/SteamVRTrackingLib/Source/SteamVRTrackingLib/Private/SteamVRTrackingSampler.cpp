@@ -0,0 +1,279 @@
+// (c) YuriNK (ykasczc@gmail.com), 2020. You're free to use it whatever way you want.
+
+#include "SteamVRTrackingSampler.h"
+#include "HAL/RunnableThread.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
+#include "SteamVRDeviceSource.h"
+
+FSteamVRTrackingSampler::FSteamVRTrackingSampler(FSteamVRDevicePoseCache& InPoseCache)
+	: PoseCache(InPoseCache)
+	, Thread(nullptr)
+	, bStopRequested(false)
+	, SampleRate(DefaultSampleRate)
+	, Capacity(0)
+	, Head(0)
+{
+}
+
+FSteamVRTrackingSampler::~FSteamVRTrackingSampler()
+{
+	StopSampling();
+}
+
+void FSteamVRTrackingSampler::StartSampling(float InSampleRate, int32 InCapacity)
+{
+	check(IsInGameThread());
+	StopSampling();
+
+	SampleRate = FMath::Clamp(InSampleRate, 1.f, MaxSampleRate);
+
+	const uint64 NewCapacity = FMath::RoundUpToPowerOfTwo(FMath::Max(InCapacity, 2));
+	if (NewCapacity != Capacity)
+	{
+		Capacity = NewCapacity;
+		Slots = MakeUnique<FSlot[]>(Capacity);
+		Head.store(0, std::memory_order_release);
+	}
+
+	bStopRequested.store(false);
+	Thread = FRunnableThread::Create(this, TEXT("SteamVRTrackingSampler"), 0, TPri_AboveNormal);
+	if (!Thread)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("SteamVRTrackingSampler: can't create sampling thread"));
+	}
+}
+
+void FSteamVRTrackingSampler::StopSampling()
+{
+	if (Thread)
+	{
+		Thread->Kill(true);
+		delete Thread;
+		Thread = nullptr;
+	}
+}
+
+uint32 FSteamVRTrackingSampler::Run()
+{
+	const double Interval = 1.0 / SampleRate;
+	double NextSampleTime = FPlatformTime::Seconds();
+
+	while (!bStopRequested.load(std::memory_order_relaxed))
+	{
+		TakeSample();
+
+		NextSampleTime += Interval;
+		double Now = FPlatformTime::Seconds();
+		if (NextSampleTime < Now)
+		{
+			// fell behind: don't try to catch up with burst of samples
+			NextSampleTime = Now;
+			continue;
+		}
+
+		// no busy wait: samples are timestamped, so sleep jitter only changes spacing of samples
+		FPlatformProcess::SleepNoStats((float)(NextSampleTime - Now));
+	}
+	return 0;
+}
+
+void FSteamVRTrackingSampler::TakeSample()
+{
+	// source isn't changed while sampler is running
+	ISteamVRDeviceSource* DeviceSource = PoseCache.GetDeviceSource();
+	if (!DeviceSource || !DeviceSource->IsAvailable())
+	{
+		return;
+	}
+
+	FQuat BaseOrientation;
+	FVector BaseOffset;
+	PoseCache.GetBaseTransform(BaseOrientation, BaseOffset);
+
+	const uint64 SampleIndex = Head.load(std::memory_order_relaxed);
+	FSlot& Slot = Slots[SampleIndex & (Capacity - 1)];
+
+	Slot.Sequence.store(SampleIndex * 2 + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	Slot.Sample.ConnectedMask = DeviceSource->GetDevicePoses(BaseOrientation, BaseOffset, Slot.Sample.Poses);
+	Slot.Sample.Timestamp = FPlatformTime::Seconds();
+	Slot.Sequence.store(SampleIndex * 2 + 2, std::memory_order_release);
+
+	Head.store(SampleIndex + 1, std::memory_order_release);
+}
+
+bool FSteamVRTrackingSampler::ReadPose(uint64 SampleIndex, int32 DeviceId, double& OutTimestamp, FSteamVRDevicePose& OutPose) const
+{
+	const FSlot& Slot = Slots[SampleIndex & (Capacity - 1)];
+	const uint64 Sequence = Slot.Sequence.load(std::memory_order_acquire);
+	if (Sequence != SampleIndex * 2 + 2)
+	{
+		return false;
+	}
+
+	OutTimestamp = Slot.Sample.Timestamp;
+	FMemory::Memcpy(&OutPose, &Slot.Sample.Poses[DeviceId], sizeof(FSteamVRDevicePose));
+	std::atomic_thread_fence(std::memory_order_acquire);
+	return Slot.Sequence.load(std::memory_order_relaxed) == Sequence;
+}
+
+bool FSteamVRTrackingSampler::ReadTimestamp(uint64 SampleIndex, double& OutTimestamp) const
+{
+	const FSlot& Slot = Slots[SampleIndex & (Capacity - 1)];
+	const uint64 Sequence = Slot.Sequence.load(std::memory_order_acquire);
+	if (Sequence != SampleIndex * 2 + 2)
+	{
+		return false;
+	}
+
+	OutTimestamp = Slot.Sample.Timestamp;
+	std::atomic_thread_fence(std::memory_order_acquire);
+	return Slot.Sequence.load(std::memory_order_relaxed) == Sequence;
+}
+
+bool FSteamVRTrackingSampler::ReadSample(uint64 SampleIndex, FSteamVRPoseSample& OutSample) const
+{
+	if (SampleIndex >= Head.load(std::memory_order_acquire))
+	{
+		return false;
+	}
+
+	const FSlot& Slot = Slots[SampleIndex & (Capacity - 1)];
+	const uint64 Sequence = Slot.Sequence.load(std::memory_order_acquire);
+	if (Sequence != SampleIndex * 2 + 2)
+	{
+		return false;
+	}
+
+	FMemory::Memcpy(&OutSample, &Slot.Sample, sizeof(FSteamVRPoseSample));
+	std::atomic_thread_fence(std::memory_order_acquire);
+	return Slot.Sequence.load(std::memory_order_relaxed) == Sequence;
+}
+
+uint64 FSteamVRTrackingSampler::GetOldestSampleIndex() const
+{
+	// the oldest slot can be overwritten at any moment, so don't use it
+	const uint64 NumSamples = Head.load(std::memory_order_acquire);
+	return NumSamples > Capacity ? NumSamples - Capacity + 1 : 0;
+}
+
+bool FSteamVRTrackingSampler::GetLatestSample(FSteamVRPoseSample& OutSample) const
+{
+	for (;;)
+	{
+		const uint64 NumSamples = Head.load(std::memory_order_acquire);
+		if (NumSamples == 0)
+		{
+			return false;
+		}
+		if (ReadSample(NumSamples - 1, OutSample))
+		{
+			return true;
+		}
+		// writer went around the whole ring while we were reading, take the new latest sample
+	}
+}
+
+bool FSteamVRTrackingSampler::GetLatestPose(int32 DeviceId, FSteamVRDevicePose& OutPose, double* OutTimestamp) const
+{
+	if (DeviceId < 0 || DeviceId >= FSteamVRDevicePoseCache::MaxDevices)
+	{
+		return false;
+	}
+
+	for (;;)
+	{
+		const uint64 NumSamples = Head.load(std::memory_order_acquire);
+		if (NumSamples == 0)
+		{
+			return false;
+		}
+
+		double Timestamp;
+		if (ReadPose(NumSamples - 1, DeviceId, Timestamp, OutPose))
+		{
+			if (OutTimestamp)
+			{
+				*OutTimestamp = Timestamp;
+			}
+			return true;
+		}
+	}
+}
+
+bool FSteamVRTrackingSampler::GetPoseAtTime(int32 DeviceId, double Time, FSteamVRDevicePose& OutPose) const
+{
+	if (DeviceId < 0 || DeviceId >= FSteamVRDevicePoseCache::MaxDevices)
+	{
+		return false;
+	}
+
+	const uint64 NumSamples = Head.load(std::memory_order_acquire);
+	if (NumSamples < 2)
+	{
+		return false;
+	}
+	const uint64 First = GetOldestSampleIndex();
+
+	// binary search for the last sample taken not later than Time
+	uint64 Low = First, High = NumSamples;
+	while (Low < High)
+	{
+		const uint64 Middle = Low + (High - Low) / 2;
+		double Timestamp;
+		if (!ReadTimestamp(Middle, Timestamp))
+		{
+			// overwritten: everything older is gone too
+			Low = Middle + 1;
+		}
+		else if (Timestamp <= Time)
+		{
+			Low = Middle + 1;
+		}
+		else
+		{
+			High = Middle;
+		}
+	}
+	if (Low == First)
+	{
+		// requested time is older than buffer
+		return false;
+	}
+
+	const uint64 IndexA = Low - 1;
+	double TimeA;
+	FSteamVRDevicePose PoseA;
+	if (!ReadPose(IndexA, DeviceId, TimeA, PoseA) || !PoseA.bPoseValid)
+	{
+		return false;
+	}
+
+	if (IndexA == NumSamples - 1)
+	{
+		// requested time is after the latest sample: allow it only within one sampling interval
+		if (Time - TimeA > 1.0 / SampleRate)
+		{
+			return false;
+		}
+		OutPose = PoseA;
+		return true;
+	}
+
+	double TimeB;
+	FSteamVRDevicePose PoseB;
+	if (!ReadPose(IndexA + 1, DeviceId, TimeB, PoseB) || !PoseB.bPoseValid)
+	{
+		return false;
+	}
+
+	const float Alpha = TimeB > TimeA ? (float)FMath::Clamp((Time - TimeA) / (TimeB - TimeA), 0.0, 1.0) : 0.f;
+	OutPose.Position = FMath::Lerp(PoseA.Position, PoseB.Position, Alpha);
+	OutPose.Orientation = FQuat::Slerp(PoseA.Orientation, PoseB.Orientation, Alpha);
+	OutPose.LinearVelocity = FMath::Lerp(PoseA.LinearVelocity, PoseB.LinearVelocity, Alpha);
+	OutPose.AngularVelocity = FMath::Lerp(PoseA.AngularVelocity, PoseB.AngularVelocity, Alpha);
+	OutPose.bConnected = true;
+	OutPose.bPoseValid = true;
+	return true;
+}
@@ -0,0 +1,322 @@
+// (c) YuriNK (ykasczc@gmail.com), 2020. You're free to use it whatever way you want.
+
+#include "SteamVRTrackingSetupWatcher.h"
+#include "SteamVRTrackingLib.h"
+#include "Async/Async.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Serialization/JsonReader.h"
+
+namespace SteamVRTrackingSetupHelpers
+{
+	/* Required fields of a device */
+	enum EDeviceField : uint8
+	{
+		Field_SerialNumber = 1 << 0,
+		Field_Type = 1 << 1,
+		Field_Name = 1 << 2,
+		Field_All = Field_SerialNumber | Field_Type | Field_Name
+	};
+
+	bool ReadDeviceString(const FString& Key, const FString& Value, FSteamVRDeviceBindingSetup& Binding, uint8& Fields)
+	{
+		if (Key == TEXT("SerialNumber"))
+		{
+			Binding.SerialNumber = FName(*Value);
+			Fields |= Field_SerialNumber;
+		}
+		else if (Key == TEXT("Name"))
+		{
+			Binding.FriendlyName = FName(*Value);
+			Fields |= Field_Name;
+		}
+		else if (Key == TEXT("Type"))
+		{
+			if (Value.Equals(TEXT("controller"), ESearchCase::IgnoreCase))
+			{
+				Binding.Type = ESteamVRTrackedDeviceType::Controller;
+			}
+			else if (Value.Equals(TEXT("vivetracker"), ESearchCase::IgnoreCase))
+			{
+				Binding.Type = ESteamVRTrackedDeviceType::Other;
+			}
+			else
+			{
+				return false;
+			}
+			Fields |= Field_Type;
+		}
+		else if (Key == TEXT("Filter"))
+		{
+			const int64 FilterValue = StaticEnum<ESteamVRPoseFilter>()->GetValueByNameString(Value);
+			if (FilterValue != INDEX_NONE)
+			{
+				Binding.Filter.Type = (ESteamVRPoseFilter)FilterValue;
+			}
+		}
+		return true;
+	}
+
+	void ReadDeviceNumber(const FString& Key, double Value, FSteamVRDeviceBindingSetup& Binding)
+	{
+		if (Key == TEXT("MinCutoff")) Binding.Filter.MinCutoff = (float)Value;
+		else if (Key == TEXT("Beta")) Binding.Filter.Beta = (float)Value;
+		else if (Key == TEXT("SmoothTime")) Binding.Filter.SmoothTime = (float)Value;
+	}
+}
+
+bool FSteamVRTrackingSetupJson::Parse(const FString& JsonString, TArray<FSteamVRDeviceBindingSetup>& OutBindings, int32& OutFormatVersion, FString& OutError)
+{
+	using namespace SteamVRTrackingSetupHelpers;
+
+	OutBindings.Reset();
+	OutFormatVersion = 0;
+
+	// root object is depth 1, "Devices" array is depth 2, device objects are depth 3
+	TSharedRef<TJsonReader<TCHAR>> Reader = TJsonReaderFactory<TCHAR>::Create(JsonString);
+	EJsonNotation Notation;
+	int32 Depth = 0;
+	bool bInDevices = false;
+	bool bHasDevices = false;
+	FSteamVRDeviceBindingSetup Binding;
+	uint8 Fields = 0;
+
+	while (Reader->ReadNext(Notation))
+	{
+		switch (Notation)
+		{
+		case EJsonNotation::ObjectStart:
+			if (bInDevices && Depth == 2)
+			{
+				Binding = FSteamVRDeviceBindingSetup();
+				Fields = 0;
+			}
+			else if (Depth == 1 && Reader->GetIdentifier() == TEXT("Devices"))
+			{
+				OutError = TEXT("Devices should be an array");
+				return false;
+			}
+			Depth++;
+			break;
+
+		case EJsonNotation::ObjectEnd:
+			Depth--;
+			if (bInDevices && Depth == 2)
+			{
+				if (Fields != Field_All)
+				{
+					OutError = FString::Printf(TEXT("device %d should have SerialNumber, Type and Name"), OutBindings.Num());
+					return false;
+				}
+				OutBindings.Add(Binding);
+			}
+			break;
+
+		case EJsonNotation::ArrayStart:
+			if (Depth == 0)
+			{
+				OutError = TEXT("root value should be an object");
+				return false;
+			}
+			if (Depth == 1 && Reader->GetIdentifier() == TEXT("Devices"))
+			{
+				bInDevices = bHasDevices = true;
+			}
+			else if (bInDevices && Depth == 2)
+			{
+				OutError = FString::Printf(TEXT("device %d should be an object"), OutBindings.Num());
+				return false;
+			}
+			Depth++;
+			break;
+
+		case EJsonNotation::ArrayEnd:
+			Depth--;
+			if (bInDevices && Depth == 1)
+			{
+				bInDevices = false;
+			}
+			break;
+
+		case EJsonNotation::String:
+			if (bInDevices && Depth == 3 && !ReadDeviceString(Reader->GetIdentifier(), Reader->GetValueAsString(), Binding, Fields))
+			{
+				OutError = FString::Printf(TEXT("device %d has unknown type %s"), OutBindings.Num(), *Reader->GetValueAsString());
+				return false;
+			}
+			else if (bInDevices && Depth == 2)
+			{
+				OutError = FString::Printf(TEXT("device %d should be an object"), OutBindings.Num());
+				return false;
+			}
+			break;
+
+		case EJsonNotation::Number:
+			if (bInDevices && Depth == 3)
+			{
+				ReadDeviceNumber(Reader->GetIdentifier(), Reader->GetValueAsNumber(), Binding);
+			}
+			else if (Depth == 1 && Reader->GetIdentifier() == TEXT("FormatVersion"))
+			{
+				OutFormatVersion = (int32)Reader->GetValueAsNumber();
+			}
+			else if (bInDevices && Depth == 2)
+			{
+				OutError = FString::Printf(TEXT("device %d should be an object"), OutBindings.Num());
+				return false;
+			}
+			break;
+
+		case EJsonNotation::Error:
+			OutError = Reader->GetErrorMessage();
+			return false;
+
+		default:
+			break;
+		}
+	}
+
+	if (!Reader->GetErrorMessage().IsEmpty())
+	{
+		OutError = Reader->GetErrorMessage();
+		return false;
+	}
+	if (!bHasDevices)
+	{
+		OutError = TEXT("Devices array is missing");
+		return false;
+	}
+	return true;
+}
+
+bool FSteamVRTrackingSetupJson::Validate(const TArray<FSteamVRDeviceBindingSetup>& Bindings, FString& OutError)
+{
+	TSet<FName> FriendlyNames;
+	FriendlyNames.Reserve(Bindings.Num());
+	for (const FSteamVRDeviceBindingSetup& Binding : Bindings)
+	{
+		if (Binding.SerialNumber.IsNone() || Binding.FriendlyName.IsNone())
+		{
+			OutError = TEXT("serial number and name can't be empty");
+			return false;
+		}
+
+		bool bAlreadyInSet = false;
+		FriendlyNames.Add(Binding.FriendlyName, &bAlreadyInSet);
+		if (bAlreadyInSet)
+		{
+			OutError = FString::Printf(TEXT("name %s is used for more than one device"), *Binding.FriendlyName.ToString());
+			return false;
+		}
+	}
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+
+FSteamVRTrackingSetupWatcher::FSteamVRTrackingSetupWatcher(FSteamVRTrackingLibModule& InTrackingLibModule)
+	: TrackingLibModule(InTrackingLibModule)
+	, FileTimeStamp(FDateTime::MinValue())
+	, FileSize(INDEX_NONE)
+{
+}
+
+FSteamVRTrackingSetupWatcher::~FSteamVRTrackingSetupWatcher()
+{
+	StopWatching();
+}
+
+bool FSteamVRTrackingSetupWatcher::StartWatching(const FString& InFileName, float InPollInterval)
+{
+	check(IsInGameThread());
+	StopWatching();
+
+	if (!IFileManager::Get().FileExists(*InFileName))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("SteamVRTrackingSetupWatcher: can't find file %s"), *InFileName);
+		return false;
+	}
+
+	FileName = InFileName;
+	FileTimeStamp = FDateTime::MinValue();
+	FileSize = INDEX_NONE;
+	TickerHandle = FTSTicker::GetCoreTicker().AddTicker(
+		FTickerDelegate::CreateRaw(this, &FSteamVRTrackingSetupWatcher::Tick), FMath::Max(InPollInterval, 0.f));
+
+	// first check loads the file
+	Tick(0.f);
+	return true;
+}
+
+void FSteamVRTrackingSetupWatcher::StopWatching()
+{
+	if (TickerHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+		TickerHandle.Reset();
+	}
+
+	// result is dropped, but parse task can't outlive the watcher
+	if (PendingParse.IsValid())
+	{
+		PendingParse.Wait();
+		PendingParse.Reset();
+	}
+}
+
+bool FSteamVRTrackingSetupWatcher::Tick(float DeltaTime)
+{
+	if (PendingParse.IsValid())
+	{
+		if (!PendingParse.IsReady())
+		{
+			return true;
+		}
+		ApplyParseResult(PendingParse.Get());
+		PendingParse.Reset();
+	}
+
+	// editors can save file in several steps, so size is checked too
+	const FFileStatData StatData = IFileManager::Get().GetStatData(*FileName);
+	if (!StatData.bIsValid || (StatData.ModificationTime == FileTimeStamp && StatData.FileSize == FileSize))
+	{
+		return true;
+	}
+	FileTimeStamp = StatData.ModificationTime;
+	FileSize = StatData.FileSize;
+
+	PendingParse = Async(EAsyncExecution::ThreadPool, [FileNameCopy = FileName]()
+	{
+		return ParseFile(FileNameCopy);
+	});
+	return true;
+}
+
+FSteamVRTrackingSetupWatcher::FParseResult FSteamVRTrackingSetupWatcher::ParseFile(const FString& FileName)
+{
+	FParseResult Result;
+
+	FString JsonString;
+	if (!FFileHelper::LoadFileToString(JsonString, *FileName))
+	{
+		Result.Error = TEXT("can't read file");
+		return Result;
+	}
+
+	Result.bSuccess = FSteamVRTrackingSetupJson::Parse(JsonString, Result.Bindings, Result.FormatVersion, Result.Error)
+		&& FSteamVRTrackingSetupJson::Validate(Result.Bindings, Result.Error);
+	return Result;
+}
+
+void FSteamVRTrackingSetupWatcher::ApplyParseResult(const FParseResult& Result)
+{
+	if (!Result.bSuccess)
+	{
+		// keep current setup until the file is fixed
+		UE_LOG(LogTemp, Warning, TEXT("SteamVRTrackingSetupWatcher: TrackingSetup file [%s] wasn't reloaded: %s"), *FileName, *Result.Error);
+		return;
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("SteamVRTrackingSetupWatcher: reloaded TrackingSetup file [%s] (format version %d, %d devices)"), *FileName, Result.FormatVersion, Result.Bindings.Num());
+	TrackingLibModule.ReloadTrackingNamesFromArray(Result.Bindings);
+}
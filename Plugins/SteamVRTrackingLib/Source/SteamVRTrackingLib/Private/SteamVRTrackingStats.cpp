@@ -0,0 +1,45 @@
+// (c) YuriNK (ykasczc@gmail.com), 2020. You're free to use it whatever way you want.
+
+#include "SteamVRTrackingStats.h"
+#include "ProfilingDebugging/CountersTrace.h"
+
+DEFINE_STAT(STAT_SteamVRTracking_PoseCacheRefresh);
+DEFINE_STAT(STAT_SteamVRTracking_DeviceIndexRebuild);
+DEFINE_STAT(STAT_SteamVRTracking_MotionSourceResolve);
+DEFINE_STAT(STAT_SteamVRTracking_LateUpdate);
+DEFINE_STAT(STAT_SteamVRTracking_LateUpdateLockWait);
+DEFINE_STAT(STAT_SteamVRTracking_ComponentsUpdate);
+DEFINE_STAT(STAT_SteamVRTracking_MocapTick);
+DEFINE_STAT(STAT_SteamVRTracking_MocapSolve);
+DEFINE_STAT(STAT_SteamVRTracking_MocapSolveWait);
+DEFINE_STAT(STAT_SteamVRTracking_MocapTakePush);
+
+DEFINE_STAT(STAT_SteamVRTracking_PosePolls);
+DEFINE_STAT(STAT_SteamVRTracking_SourceQueries);
+DEFINE_STAT(STAT_SteamVRTracking_IdCacheMisses);
+DEFINE_STAT(STAT_SteamVRTracking_SerialLookups);
+DEFINE_STAT(STAT_SteamVRTracking_LockRetries);
+
+UE_TRACE_CHANNEL_DEFINE(SteamVRTrackingChannel);
+
+TRACE_DECLARE_INT_COUNTER(SteamVRTracking_PosePolls, TEXT("SteamVRTracking/Pose Polls"));
+TRACE_DECLARE_INT_COUNTER(SteamVRTracking_SourceQueries, TEXT("SteamVRTracking/Device Source Queries"));
+TRACE_DECLARE_INT_COUNTER(SteamVRTracking_IdCacheMisses, TEXT("SteamVRTracking/ID Cache Misses"));
+TRACE_DECLARE_INT_COUNTER(SteamVRTracking_SerialLookups, TEXT("SteamVRTracking/Serial Lookups"));
+TRACE_DECLARE_INT_COUNTER(SteamVRTracking_LockRetries, TEXT("SteamVRTracking/Late Update Lock Retries"));
+
+std::atomic<uint32> FSteamVRTrackingCounters::Values[(int32)ESteamVRTrackingCounter::Num];
+
+void FSteamVRTrackingCounters::PublishFrame()
+{
+	if (!UE_TRACE_CHANNELEXPR_IS_ENABLED(SteamVRTrackingChannel))
+	{
+		return;
+	}
+
+	TRACE_COUNTER_SET(SteamVRTracking_PosePolls, Values[(int32)ESteamVRTrackingCounter::PosePolls].exchange(0, std::memory_order_relaxed));
+	TRACE_COUNTER_SET(SteamVRTracking_SourceQueries, Values[(int32)ESteamVRTrackingCounter::SourceQueries].exchange(0, std::memory_order_relaxed));
+	TRACE_COUNTER_SET(SteamVRTracking_IdCacheMisses, Values[(int32)ESteamVRTrackingCounter::IdCacheMisses].exchange(0, std::memory_order_relaxed));
+	TRACE_COUNTER_SET(SteamVRTracking_SerialLookups, Values[(int32)ESteamVRTrackingCounter::SerialLookups].exchange(0, std::memory_order_relaxed));
+	TRACE_COUNTER_SET(SteamVRTracking_LockRetries, Values[(int32)ESteamVRTrackingCounter::LockRetries].exchange(0, std::memory_order_relaxed));
+}
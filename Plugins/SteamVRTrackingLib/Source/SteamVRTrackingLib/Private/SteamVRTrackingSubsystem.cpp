@@ -0,0 +1,104 @@
+// (c) YuriNK (ykasczc@gmail.com), 2020. You're free to use it whatever way you want.
+
+#include "SteamVRTrackingSubsystem.h"
+#include "Components/SceneComponent.h"
+#include "Engine/Level.h"
+#include "Engine/World.h"
+#include "GameFramework/WorldSettings.h"
+#include "Modules/ModuleManager.h"
+#include "SteamVRTrackingLib.h"
+#include "SteamVRTrackingStats.h"
+
+void FSteamVRTrackingSubsystemTickFunction::ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
+{
+	if (Subsystem)
+	{
+		Subsystem->Tick(DeltaTime);
+	}
+}
+
+FString FSteamVRTrackingSubsystemTickFunction::DiagnosticMessage()
+{
+	return TEXT("FSteamVRTrackingSubsystemTickFunction");
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void USteamVRTrackingSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	// display components shouldn't wait for models mid-session
+	if (InWorld.IsGameWorld())
+	{
+		FSteamVRTrackingLibModule::Get().GetRenderModelCache().PrewarmConnectedDevices(&InWorld);
+	}
+}
+
+void USteamVRTrackingSubsystem::Deinitialize()
+{
+	if (TickFunction.IsTickFunctionRegistered())
+	{
+		TickFunction.UnRegisterTickFunction();
+	}
+	TrackedDevices.Empty();
+
+	Super::Deinitialize();
+}
+
+void USteamVRTrackingSubsystem::RegisterTrackedDevice(USceneComponent* Component, const FSteamVRTrackedDeviceUpdate& UpdateDelegate)
+{
+	check(IsInGameThread());
+
+	UnregisterTrackedDevice(Component);
+	TrackedDevices.Add({ Component, UpdateDelegate });
+
+	// same tick settings as tracked device component had
+	if (!TickFunction.IsTickFunctionRegistered())
+	{
+		UWorld* World = GetWorld();
+		TickFunction.Subsystem = this;
+		TickFunction.bCanEverTick = true;
+		TickFunction.bStartWithTickEnabled = true;
+		TickFunction.bTickEvenWhenPaused = true;
+		TickFunction.TickGroup = TG_PrePhysics;
+		TickFunction.RegisterTickFunction(World->PersistentLevel);
+	}
+}
+
+void USteamVRTrackingSubsystem::UnregisterTrackedDevice(USceneComponent* Component)
+{
+	TrackedDevices.RemoveAllSwap([Component](const FTrackedDevice& Device) { return Device.Component.Get() == Component; });
+}
+
+void USteamVRTrackingSubsystem::Tick(float DeltaTime)
+{
+	STEAMVR_TRACKING_SCOPE(STAT_SteamVRTracking_ComponentsUpdate);
+
+	FSteamVRTrackingLibModule* TrackingLibModule = FModuleManager::GetModulePtr<FSteamVRTrackingLibModule>(TEXT("SteamVRTrackingLib"));
+	if (!TrackingLibModule)
+	{
+		return;
+	}
+
+	// refresh game thread snapshot once, components only read it
+	TrackingLibModule->GetPoseCache().GetConnectedDevicesMask();
+
+	const AWorldSettings* WorldSettings = GetWorld()->GetWorldSettings();
+	const float WorldToMeters = WorldSettings ? WorldSettings->WorldToMeters : 100.0f;
+
+	for (int32 Index = TrackedDevices.Num() - 1; Index >= 0; Index--)
+	{
+		USceneComponent* Component = TrackedDevices[Index].Component.Get();
+		if (!Component)
+		{
+			TrackedDevices.RemoveAtSwap(Index, 1, false);
+			continue;
+		}
+
+		if (Component->IsActive())
+		{
+			TrackedDevices[Index].Update.ExecuteIfBound(WorldToMeters);
+		}
+	}
+}
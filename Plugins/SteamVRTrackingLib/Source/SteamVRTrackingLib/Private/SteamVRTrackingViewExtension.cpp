@@ -0,0 +1,125 @@
+// (c) YuriNK (ykasczc@gmail.com), 2020. You're free to use it whatever way you want.
+
+#include "SteamVRTrackingViewExtension.h"
+#include "LateUpdateManager.h"
+#include "SteamVRTrackingStats.h"
+#include "Components/SceneComponent.h"
+#include "RenderingThread.h"
+#include "SceneView.h"
+#include "Launch/Resources/Version.h"
+
+namespace
+{
+	/** Console variable for specifying whether motion controller late update is used */
+	TAutoConsoleVariable<int32> CVarEnableMotionControllerLateUpdate(
+		TEXT("vr.EnableMotionControllerLateUpdate"),
+		1,
+		TEXT("This command allows you to specify whether the motion controller late update is applied.\n")
+		TEXT(" 0: don't use late update\n")
+		TEXT(" 1: use late update (default)"),
+		ECVF_Cheat);
+} // anonymous namespace
+
+FSteamVRTrackingViewExtension::FSteamVRTrackingViewExtension(const FAutoRegister& AutoRegister)
+	: FSceneViewExtensionBase(AutoRegister)
+	, bRenderEntriesDirty(false)
+{
+}
+
+void FSteamVRTrackingViewExtension::RegisterComponent(USceneComponent* Component, const TSharedPtr<FSteamVRTrackedDeviceRenderState, ESPMode::ThreadSafe>& RenderState)
+{
+	check(IsInGameThread());
+
+	if (!Component || !RenderState.IsValid() || Entries.ContainsByPredicate([&RenderState](const FEntry& Entry) { return Entry.RenderState == RenderState; }))
+	{
+		return;
+	}
+
+	FEntry& Entry = Entries.AddDefaulted_GetRef();
+	Entry.Component = Component;
+	Entry.RenderState = RenderState;
+	Entry.LateUpdate = MakeShared<FLateUpdateManager, ESPMode::ThreadSafe>();
+	bRenderEntriesDirty = true;
+}
+
+void FSteamVRTrackingViewExtension::UnregisterComponent(const TSharedPtr<FSteamVRTrackedDeviceRenderState, ESPMode::ThreadSafe>& RenderState)
+{
+	check(IsInGameThread());
+
+	if (Entries.RemoveAllSwap([&RenderState](const FEntry& Entry) { return Entry.RenderState == RenderState; }) > 0)
+	{
+		bRenderEntriesDirty = true;
+	}
+}
+
+void FSteamVRTrackingViewExtension::BeginRenderViewFamily(FSceneViewFamily& InViewFamily)
+{
+	// drop destroyed components
+	if (Entries.RemoveAllSwap([](const FEntry& Entry) { return !Entry.Component.IsValid() || !Entry.RenderState->IsComponentAlive(); }) > 0)
+	{
+		bRenderEntriesDirty = true;
+	}
+
+	for (FEntry& Entry : Entries)
+	{
+		USceneComponent* Component = Entry.Component.Get();
+		if (Entry.RenderState->bLateUpdateEnabled)
+		{
+			// Set up the late update state for the controller component
+			Entry.LateUpdate->Setup(Component->CalcNewComponentToWorld(FTransform()), Component, false);
+			Entry.RenderState->Publish(InViewFamily.FrameNumber, Component);
+		}
+	}
+
+	// render thread list is only updated when set of components changes
+	if (bRenderEntriesDirty)
+	{
+		bRenderEntriesDirty = false;
+
+		TArray<FRenderEntry> NewRenderEntries;
+		NewRenderEntries.Reserve(Entries.Num());
+		for (const FEntry& Entry : Entries)
+		{
+			NewRenderEntries.Add(Entry);
+		}
+
+		ENQUEUE_RENDER_COMMAND(UpdateSteamVRTrackingLateUpdateList)(
+			[this, NewRenderEntries = MoveTemp(NewRenderEntries)](FRHICommandListImmediate& RHICmdList) mutable
+		{
+			RenderEntries = MoveTemp(NewRenderEntries);
+			RenderTransforms.SetNum(RenderEntries.Num());
+		});
+	}
+}
+
+void FSteamVRTrackingViewExtension::PreRenderViewFamily_RenderThread(FRHICommandListImmediate& RHICmdList, FSceneViewFamily& InViewFamily)
+{
+	STEAMVR_TRACKING_SCOPE(STAT_SteamVRTracking_LateUpdate);
+
+	// single pass over all devices: poses are taken from the same late update snapshot
+	for (int32 Index = 0; Index < RenderEntries.Num(); Index++)
+	{
+		FLateUpdateTransforms& Transforms = RenderTransforms[Index];
+		Transforms.bValid = RenderEntries[Index].RenderState->GetLateUpdateTransforms_RenderThread(InViewFamily, Transforms.OldTransform, Transforms.NewTransform);
+	}
+
+	// Tell the late update managers to apply the offsets to the scene components
+	for (int32 Index = 0; Index < RenderEntries.Num(); Index++)
+	{
+		const FLateUpdateTransforms& Transforms = RenderTransforms[Index];
+		if (Transforms.bValid)
+		{
+#if ENGINE_MAJOR_VERSION < 5 && ENGINE_MINOR_VERSION > 26
+			RenderEntries[Index].LateUpdate->Apply_RenderThread(InViewFamily.Scene, InViewFamily.bLateLatchingEnabled ? InViewFamily.FrameNumber : -1, Transforms.OldTransform, Transforms.NewTransform);
+#else
+			RenderEntries[Index].LateUpdate->Apply_RenderThread(InViewFamily.Scene, Transforms.OldTransform, Transforms.NewTransform);
+#endif
+		}
+	}
+}
+
+bool FSteamVRTrackingViewExtension::IsActiveThisFrame_Internal(const FSceneViewExtensionContext& Context) const
+{
+	check(IsInGameThread());
+	return Entries.Num() > 0 && CVarEnableMotionControllerLateUpdate.GetValueOnGameThread();
+}
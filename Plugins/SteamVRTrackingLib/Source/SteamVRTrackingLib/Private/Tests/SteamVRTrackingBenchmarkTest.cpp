@@ -0,0 +1,62 @@
+// (c) YuriNK (ykasczc@gmail.com), 2020. You're free to use it whatever way you want.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "SteamVRTrackingBenchmark.h"
+#include "Dom/JsonObject.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSteamVRTrackingBenchmarkTest, "SteamVRTracking.Benchmark",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::PerfFilter)
+
+bool FSteamVRTrackingBenchmarkTest::RunTest(const FString& Parameters)
+{
+	FSteamVRTrackingBenchmark Benchmark(2000);
+	const TSharedRef<FJsonObject> Report = Benchmark.Run();
+
+	// every scenario should be measured, otherwise the report can't be compared with previous ones
+	for (const FString& Skipped : Benchmark.GetSkippedScenarios())
+	{
+		AddError(FString::Printf(TEXT("Skipped %s"), *Skipped));
+	}
+
+	const FString FileName = FSteamVRTrackingBenchmark::GetDefaultReportFileName();
+	if (FSteamVRTrackingBenchmark::SaveReport(Report, FileName))
+	{
+		AddInfo(FString::Printf(TEXT("Report saved to %s"), *FileName));
+	}
+	else
+	{
+		AddWarning(FString::Printf(TEXT("Can't write report to %s"), *FileName));
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSteamVRTrackingSteadyStateAllocationsTest, "SteamVRTracking.SteadyStateAllocations",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter)
+
+bool FSteamVRTrackingSteadyStateAllocationsTest::RunTest(const FString& Parameters)
+{
+	if (!FSteamVRTrackingBenchmark::IsAllocationCountingSupported())
+	{
+		AddWarning(TEXT("Engine allocator doesn't count calls in this build, allocations can't be checked"));
+		return true;
+	}
+
+	// poses are polled, filtered and late updated every frame, so after warm-up these paths shouldn't touch the heap
+	FSteamVRTrackingBenchmark Benchmark(400);
+	Benchmark.Run();
+
+	for (const FString& Failure : Benchmark.GetAllocationFailures())
+	{
+		AddError(Failure);
+	}
+	for (const FString& Skipped : Benchmark.GetSkippedScenarios())
+	{
+		AddError(FString::Printf(TEXT("Skipped %s"), *Skipped));
+	}
+	return true;
+}
+
+#endif
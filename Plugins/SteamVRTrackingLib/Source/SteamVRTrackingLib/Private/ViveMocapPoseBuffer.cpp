@@ -0,0 +1,71 @@
+// (c) YuriNK (ykasczc@gmail.com), 2020. You're free to use it whatever way you want.
+
+#include "ViveMocapPoseBuffer.h"
+
+FViveMocapPoseBuffer::FViveMocapPoseBuffer()
+	: ReadIndex(0)
+	, LayoutVersion(0)
+	, bValid(false)
+{
+}
+
+void FViveMocapPoseBuffer::Submit(FPoseSnapshot& Snapshot)
+{
+	if (!Snapshot.bIsValid || Snapshot.BoneNames.Num() != Snapshot.LocalTransforms.Num())
+	{
+		return;
+	}
+
+	// solver writes the same names every frame, they're only compared when layout is set
+	if (BoneNames.Num() != Snapshot.BoneNames.Num())
+	{
+		BoneNames = Snapshot.BoneNames;
+		LayoutVersion++;
+	}
+
+	const int32 WriteIndex = 1 - ReadIndex;
+	Swap(Buffers[WriteIndex], Snapshot.LocalTransforms);
+	ReadIndex = WriteIndex;
+	bValid = true;
+}
+
+void FViveMocapPoseBuffer::CopyToSnapshot(FPoseSnapshot& Snapshot) const
+{
+	if (!bValid)
+	{
+		Snapshot.bIsValid = false;
+		return;
+	}
+
+	Snapshot.BoneNames = BoneNames;
+	Snapshot.LocalTransforms = GetPose();
+	Snapshot.bIsValid = true;
+}
+
+void FViveMocapPoseBuffer::CopyToSnapshot(FPoseSnapshot& Snapshot, uint32& SnapshotLayoutVersion) const
+{
+	if (!bValid)
+	{
+		Snapshot.bIsValid = false;
+		return;
+	}
+
+	if (SnapshotLayoutVersion != LayoutVersion)
+	{
+		Snapshot.BoneNames = BoneNames;
+		SnapshotLayoutVersion = LayoutVersion;
+	}
+	// same size, so array keeps its allocation
+	Snapshot.LocalTransforms = GetPose();
+	Snapshot.bIsValid = true;
+}
+
+void FViveMocapPoseBuffer::Reset()
+{
+	BoneNames.Empty();
+	Buffers[0].Empty();
+	Buffers[1].Empty();
+	ReadIndex = 0;
+	LayoutVersion++;
+	bValid = false;
+}
@@ -0,0 +1,328 @@
+// (c) YuriNK (ykasczc@gmail.com), 2020. You're free to use it whatever way you want.
+
+#include "ViveMocapRecorder.h"
+#include "HAL/RunnableThread.h"
+#include "HAL/PlatformFilemanager.h"
+#include "HAL/PlatformProcess.h"
+#include "Misc/DateTime.h"
+#include "Misc/Paths.h"
+#include "SteamVRTrackingStats.h"
+
+using namespace ViveMocapRecording;
+
+FViveMocapRecorder::FViveMocapRecorder()
+	: Thread(nullptr)
+	, bStopRequested(false)
+	, bWriteError(false)
+	, NumRecordedFrames(0)
+	, NumDroppedFrames(0)
+	, NumBones(0)
+	, WriteIndex(0)
+	, ReadIndex(0)
+	, ChunkDataSize(0)
+	, CosHalfRotationTolerance(1.f)
+	, TranslationTolerance(0.f)
+{
+	FMemory::Memzero(FileHeader);
+	FMemory::Memzero(ChunkHeader);
+}
+
+FViveMocapRecorder::~FViveMocapRecorder()
+{
+	StopRecording();
+}
+
+bool FViveMocapRecorder::StartRecording(const FString& FileName, const TArray<FName>& InBoneNames, float InRotationTolerance, float InTranslationTolerance)
+{
+	check(IsInGameThread());
+	StopRecording();
+
+	if (InBoneNames.Num() == 0 || InBoneNames.Num() > MaxBones)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("ViveMocapRecorder: can't record pose of %d bones"), InBoneNames.Num());
+		return false;
+	}
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	PlatformFile.CreateDirectoryTree(*FPaths::GetPath(FileName));
+	File.Reset(PlatformFile.OpenWrite(*FileName));
+	if (!File.IsValid())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("ViveMocapRecorder: can't open file %s"), *FileName);
+		return false;
+	}
+	NumBones = InBoneNames.Num();
+
+	FMemory::Memzero(FileHeader);
+	FileHeader.Magic = FileMagic;
+	FileHeader.Version = FormatVersion;
+	FileHeader.HeaderSize = sizeof(FFileHeader);
+	FileHeader.NumBones = NumBones;
+	FileHeader.StartTime = FPlatformTime::Seconds();
+	FileHeader.StartDateTimeTicks = FDateTime::UtcNow().GetTicks();
+	FileHeader.RotationTolerance = InRotationTolerance;
+	FileHeader.TranslationTolerance = InTranslationTolerance;
+	bWriteError.store(false);
+
+	TArray<FBoneEntry> BoneTable;
+	BoneTable.AddZeroed(NumBones);
+	for (int32 Bone = 0; Bone < NumBones; Bone++)
+	{
+		FCStringAnsi::Strncpy(BoneTable[Bone].Name, TCHAR_TO_ANSI(*InBoneNames[Bone].ToString()), MaxBoneNameLength);
+	}
+	if (!WriteToFile(&FileHeader, sizeof(FFileHeader)) || !WriteToFile(BoneTable.GetData(), BoneTable.Num() * sizeof(FBoneEntry)))
+	{
+		return false;
+	}
+
+	// everything is allocated here, recording doesn't allocate until ChunkIndex grows
+	Ring.SetNumUninitialized(RingCapacity * NumBones);
+	RingTimes.SetNumUninitialized(RingCapacity);
+	WriteIndex.store(0);
+	ReadIndex.store(0);
+
+	ChunkBuffer.SetNumUninitialized(sizeof(FChunkHeader) + ChunkCapacity * (sizeof(FFrameHeader) + NumBones * MaxBoneRecordSize));
+	ChunkDataSize = 0;
+	FMemory::Memzero(ChunkHeader);
+	ChunkIndex.Reset();
+	LastWrittenPose.Init(FTransform::Identity, NumBones);
+	CosHalfRotationTolerance = FMath::Cos(FMath::DegreesToRadians(FMath::Max(InRotationTolerance, 0.f)) * 0.5f);
+	TranslationTolerance = FMath::Max(InTranslationTolerance, 0.f);
+	NumRecordedFrames.store(0);
+	NumDroppedFrames.store(0);
+
+	bStopRequested.store(false);
+	Thread = FRunnableThread::Create(this, TEXT("ViveMocapRecorder"), 0, TPri_BelowNormal);
+	if (!Thread)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("ViveMocapRecorder: can't create recorder thread"));
+		File.Reset();
+		return false;
+	}
+	return true;
+}
+
+void FViveMocapRecorder::StopRecording()
+{
+	if (Thread)
+	{
+		Thread->Kill(true);
+		delete Thread;
+		Thread = nullptr;
+
+		if (HasWriteError())
+		{
+			UE_LOG(LogTemp, Warning, TEXT("ViveMocapRecorder: take is incomplete, %llu frames recorded before write error"), GetNumRecordedFrames());
+		}
+		else
+		{
+			UE_LOG(LogTemp, Log, TEXT("ViveMocapRecorder: take finished, %llu frames recorded, %llu dropped"), GetNumRecordedFrames(), GetNumDroppedFrames());
+		}
+	}
+}
+
+bool FViveMocapRecorder::PushPose(TArrayView<const FTransform> Pose, double Time)
+{
+	STEAMVR_TRACKING_SCOPE(STAT_SteamVRTracking_MocapTakePush);
+
+	if (!Thread || Pose.Num() != NumBones || HasWriteError())
+	{
+		return false;
+	}
+
+	const uint64 Index = WriteIndex.load(std::memory_order_relaxed);
+	if (Index - ReadIndex.load(std::memory_order_acquire) >= RingCapacity)
+	{
+		NumDroppedFrames.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	const int32 Slot = (int32)(Index % RingCapacity);
+	FMemory::Memcpy(&Ring[Slot * NumBones], Pose.GetData(), NumBones * sizeof(FTransform));
+	RingTimes[Slot] = Time;
+	WriteIndex.store(Index + 1, std::memory_order_release);
+	return true;
+}
+
+uint32 FViveMocapRecorder::Run()
+{
+	// ring is read much faster than filled, a quarter of its duration at 90 FPS is enough
+	const float PollInterval = 0.25f * RingCapacity / 90.f;
+
+	while (!bStopRequested.load(std::memory_order_relaxed) && !HasWriteError())
+	{
+		ReadNewPoses();
+		FPlatformProcess::SleepNoStats(FMath::Min(PollInterval, 0.05f));
+	}
+	ReadNewPoses();
+	FinalizeFile();
+
+	return 0;
+}
+
+void FViveMocapRecorder::ReadNewPoses()
+{
+	const uint64 Available = WriteIndex.load(std::memory_order_acquire);
+	uint64 Index = ReadIndex.load(std::memory_order_relaxed);
+
+	for (; Index < Available && !HasWriteError(); Index++)
+	{
+		const int32 Slot = (int32)(Index % RingCapacity);
+		WriteFrame(&Ring[Slot * NumBones], RingTimes[Slot]);
+		NumRecordedFrames.fetch_add(1, std::memory_order_relaxed);
+
+		// release slot
+		ReadIndex.store(Index + 1, std::memory_order_release);
+	}
+}
+
+void FViveMocapRecorder::WriteFrame(const FTransform* Pose, double Time)
+{
+	if (ChunkHeader.NumFrames > 0 && (ChunkHeader.NumFrames >= ChunkCapacity || Time - ChunkHeader.ChunkTime > 3600.0))
+	{
+		FlushChunk();
+	}
+	const bool bKeyframe = ChunkHeader.NumFrames == 0;
+	if (bKeyframe)
+	{
+		ChunkHeader.FirstFrame = FileHeader.NumFrames;
+		ChunkHeader.ChunkTime = Time;
+	}
+
+	uint8* const ChunkData = ChunkBuffer.GetData() + sizeof(FChunkHeader);
+	uint8* Ptr = ChunkData + ChunkDataSize;
+	auto Write = [&Ptr](const void* Source, int32 Size)
+	{
+		FMemory::Memcpy(Ptr, Source, Size);
+		Ptr += Size;
+	};
+
+	FFrameHeader FrameHeader;
+	FrameHeader.TimeOffset = (uint32)FMath::Max((Time - ChunkHeader.ChunkTime) * 1e6, 0.0);
+	FrameHeader.NumBoneRecords = 0;
+	FrameHeader.Reserved = 0;
+	uint8* const FrameHeaderPtr = Ptr;
+	Ptr += sizeof(FFrameHeader);
+
+	for (int32 Bone = 0; Bone < NumBones; Bone++)
+	{
+		const FTransform& BoneTransform = Pose[Bone];
+		FTransform& LastWritten = LastWrittenPose[Bone];
+
+		// first frame of chunk has all values, others only changed ones
+		const FQuat Rotation = BoneTransform.GetRotation();
+		const bool bWriteRotation = bKeyframe || FMath::Abs(Rotation | LastWritten.GetRotation()) < CosHalfRotationTolerance;
+		const bool bWriteTranslation = bKeyframe || !BoneTransform.GetTranslation().Equals(LastWritten.GetTranslation(), TranslationTolerance);
+		const bool bWriteScale = bKeyframe || !BoneTransform.GetScale3D().Equals(LastWritten.GetScale3D(), KINDA_SMALL_NUMBER);
+		if (!bWriteRotation && !bWriteTranslation && !bWriteScale)
+		{
+			continue;
+		}
+
+		const uint16 Flags = (uint16)(Bone
+			| (bWriteRotation ? Record_Rotation : 0)
+			| (bWriteTranslation ? Record_Translation : 0)
+			| (bWriteScale ? Record_Scale : 0));
+		Write(&Flags, sizeof(uint16));
+
+		if (bWriteRotation)
+		{
+			uint16 Packed[3];
+			QuantizeRotation(Rotation, Packed);
+			Write(Packed, sizeof(Packed));
+			// compare with decoded value, so error doesn't accumulate
+			LastWritten.SetRotation(DequantizeRotation(Packed));
+		}
+		if (bWriteTranslation)
+		{
+			const FVector Translation = BoneTransform.GetTranslation();
+			const float Values[3] = { (float)Translation.X, (float)Translation.Y, (float)Translation.Z };
+			Write(Values, sizeof(Values));
+			LastWritten.SetTranslation(FVector(Values[0], Values[1], Values[2]));
+		}
+		if (bWriteScale)
+		{
+			const FVector Scale = BoneTransform.GetScale3D();
+			const float Values[3] = { (float)Scale.X, (float)Scale.Y, (float)Scale.Z };
+			Write(Values, sizeof(Values));
+			LastWritten.SetScale3D(FVector(Values[0], Values[1], Values[2]));
+		}
+		FrameHeader.NumBoneRecords++;
+	}
+
+	FMemory::Memcpy(FrameHeaderPtr, &FrameHeader, sizeof(FFrameHeader));
+	ChunkDataSize = (int32)(Ptr - ChunkData);
+	ChunkHeader.NumFrames++;
+	FileHeader.NumFrames++;
+}
+
+void FViveMocapRecorder::FlushChunk()
+{
+	if (ChunkHeader.NumFrames == 0 || !File.IsValid())
+	{
+		return;
+	}
+
+	ChunkHeader.Magic = ChunkMagic;
+	ChunkHeader.DataSize = ChunkDataSize;
+	FMemory::Memcpy(ChunkBuffer.GetData(), &ChunkHeader, sizeof(FChunkHeader));
+
+	const uint64 Offset = (uint64)File->Tell();
+	if (WriteToFile(ChunkBuffer.GetData(), sizeof(FChunkHeader) + ChunkDataSize))
+	{
+		ChunkIndex.Add(FChunkIndexEntry{ Offset, ChunkHeader.ChunkTime });
+	}
+
+	ChunkHeader.NumFrames = 0;
+	ChunkDataSize = 0;
+}
+
+void FViveMocapRecorder::FinalizeFile()
+{
+	if (!File.IsValid())
+	{
+		return;
+	}
+	FlushChunk();
+	// after write error the file is already closed, reader scans its complete chunks
+	if (!File.IsValid())
+	{
+		return;
+	}
+
+	FileHeader.ChunkIndexOffset = (uint64)File->Tell();
+	FileHeader.NumChunks = ChunkIndex.Num();
+	if (!WriteToFile(ChunkIndex.GetData(), ChunkIndex.Num() * sizeof(FChunkIndexEntry)))
+	{
+		return;
+	}
+
+	if (!File->Seek(0))
+	{
+		UE_LOG(LogTemp, Error, TEXT("ViveMocapRecorder: can't finalize take file, chunk index isn't saved"));
+		bWriteError.store(true);
+		File.Reset();
+		return;
+	}
+	if (WriteToFile(&FileHeader, sizeof(FFileHeader)))
+	{
+		File->Flush();
+		File.Reset();
+	}
+}
+
+bool FViveMocapRecorder::WriteToFile(const void* Source, int64 Size)
+{
+	if (!File.IsValid())
+	{
+		return false;
+	}
+	if (!File->Write(reinterpret_cast<const uint8*>(Source), Size))
+	{
+		UE_LOG(LogTemp, Error, TEXT("ViveMocapRecorder: can't write take file, recording is stopped"));
+		bWriteError.store(true);
+		File.Reset();
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,282 @@
+// (c) YuriNK (ykasczc@gmail.com), 2020. You're free to use it whatever way you want.
+
+#include "ViveMocapRecording.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Async/MappedFileHandle.h"
+
+using namespace ViveMocapRecording;
+
+namespace ViveMocapRecording
+{
+	/* Smallest three components of unit quaternion are in [-1/sqrt(2), 1/sqrt(2)] */
+	constexpr double Sqrt2 = 1.4142135623730951;
+	constexpr double QuantizationScale = 32767.0;
+
+	void QuantizeRotation(const FQuat& Rotation, uint16 OutPacked[3])
+	{
+		const FQuat Normalized = Rotation.GetNormalized();
+		const double Components[4] = { Normalized.X, Normalized.Y, Normalized.Z, Normalized.W };
+
+		int32 Largest = 0;
+		for (int32 Index = 1; Index < 4; Index++)
+		{
+			if (FMath::Abs(Components[Index]) > FMath::Abs(Components[Largest]))
+			{
+				Largest = Index;
+			}
+		}
+		// q and -q are the same rotation, so the largest component is always positive
+		const double Sign = Components[Largest] < 0.0 ? -1.0 : 1.0;
+
+		uint64 Packed = (uint64)Largest << 45;
+		int32 Shift = 30;
+		for (int32 Index = 0; Index < 4; Index++)
+		{
+			if (Index != Largest)
+			{
+				const double Value = FMath::Clamp((Components[Index] * Sign * Sqrt2 + 1.0) * 0.5, 0.0, 1.0);
+				Packed |= (uint64)FMath::RoundToInt(Value * QuantizationScale) << Shift;
+				Shift -= 15;
+			}
+		}
+
+		OutPacked[0] = (uint16)(Packed >> 32);
+		OutPacked[1] = (uint16)(Packed >> 16);
+		OutPacked[2] = (uint16)Packed;
+	}
+
+	FQuat DequantizeRotation(const uint16 Packed[3])
+	{
+		const uint64 Value = ((uint64)Packed[0] << 32) | ((uint64)Packed[1] << 16) | (uint64)Packed[2];
+		const int32 Largest = (int32)((Value >> 45) & 3);
+
+		double Components[4];
+		double SquaredSum = 0.0;
+		int32 Shift = 30;
+		for (int32 Index = 0; Index < 4; Index++)
+		{
+			if (Index != Largest)
+			{
+				const double Quantized = (double)((Value >> Shift) & 0x7FFF) / QuantizationScale;
+				Components[Index] = (Quantized * 2.0 - 1.0) / Sqrt2;
+				SquaredSum += Components[Index] * Components[Index];
+				Shift -= 15;
+			}
+		}
+		Components[Largest] = FMath::Sqrt(FMath::Max(1.0 - SquaredSum, 0.0));
+
+		return FQuat(Components[0], Components[1], Components[2], Components[3]).GetNormalized();
+	}
+}
+
+FViveMocapTakeReader::FViveMocapTakeReader()
+	: Data(nullptr)
+	, DataSize(0)
+{
+	FMemory::Memzero(Header);
+}
+
+FViveMocapTakeReader::~FViveMocapTakeReader()
+{
+	Close();
+}
+
+bool FViveMocapTakeReader::Open(const FString& FileName)
+{
+	Close();
+
+	MappedFile.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*FileName));
+	if (!MappedFile.IsValid() || MappedFile->GetFileSize() < (int64)sizeof(FFileHeader))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("ViveMocapTakeReader: can't read file %s"), *FileName);
+		Close();
+		return false;
+	}
+
+	MappedRegion.Reset(MappedFile->MapRegion(0, MappedFile->GetFileSize()));
+	if (!MappedRegion.IsValid())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("ViveMocapTakeReader: can't map file %s"), *FileName);
+		Close();
+		return false;
+	}
+	Data = MappedRegion->GetMappedPtr();
+	DataSize = MappedRegion->GetMappedSize();
+
+	FMemory::Memcpy(&Header, Data, sizeof(FFileHeader));
+	const uint64 BoneTableEnd = (uint64)Header.HeaderSize + (uint64)Header.NumBones * sizeof(FBoneEntry);
+	if (Header.Magic != FileMagic || Header.Version > FormatVersion || Header.HeaderSize < sizeof(FFileHeader)
+		|| Header.NumBones == 0 || Header.NumBones > MaxBones || BoneTableEnd > (uint64)DataSize)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("ViveMocapTakeReader: %s isn't a mocap take file"), *FileName);
+		Close();
+		return false;
+	}
+
+	BoneNames.Reserve(Header.NumBones);
+	for (uint32 Bone = 0; Bone < Header.NumBones; Bone++)
+	{
+		FBoneEntry Entry;
+		FMemory::Memcpy(&Entry, Data + Header.HeaderSize + Bone * sizeof(FBoneEntry), sizeof(FBoneEntry));
+		Entry.Name[MaxBoneNameLength - 1] = 0;
+		BoneNames.Add(FName(ANSI_TO_TCHAR(Entry.Name)));
+	}
+
+	// offsets of corrupted file can be anything, so they're checked without overflow
+	if (Header.ChunkIndexOffset >= BoneTableEnd && Header.ChunkIndexOffset <= (uint64)DataSize
+		&& Header.NumChunks <= ((uint64)DataSize - Header.ChunkIndexOffset) / sizeof(FChunkIndexEntry))
+	{
+		ChunkOffsets.SetNumUninitialized(Header.NumChunks);
+		for (uint32 Chunk = 0; Chunk < Header.NumChunks; Chunk++)
+		{
+			FChunkIndexEntry Entry;
+			FMemory::Memcpy(&Entry, Data + Header.ChunkIndexOffset + Chunk * sizeof(FChunkIndexEntry), sizeof(FChunkIndexEntry));
+			if (Entry.Offset < BoneTableEnd || !IsChunkValid(Entry.Offset))
+			{
+				UE_LOG(LogTemp, Warning, TEXT("ViveMocapTakeReader: %s has invalid chunk index, scanning chunks"), *FileName);
+				ScanChunks();
+				break;
+			}
+			ChunkOffsets[Chunk] = Entry.Offset;
+		}
+	}
+	else
+	{
+		// take wasn't stopped properly, keep all complete chunks
+		UE_LOG(LogTemp, Log, TEXT("ViveMocapTakeReader: %s wasn't finalized, scanning chunks"), *FileName);
+		ScanChunks();
+	}
+
+	return true;
+}
+
+void FViveMocapTakeReader::Close()
+{
+	BoneNames.Empty();
+	ChunkOffsets.Empty();
+	FMemory::Memzero(Header);
+	Data = nullptr;
+	DataSize = 0;
+	MappedRegion.Reset();
+	MappedFile.Reset();
+}
+
+bool FViveMocapTakeReader::IsChunkValid(uint64 Offset) const
+{
+	if (Offset > (uint64)DataSize || (uint64)DataSize - Offset < sizeof(FChunkHeader))
+	{
+		return false;
+	}
+	FChunkHeader ChunkHeader;
+	FMemory::Memcpy(&ChunkHeader, Data + Offset, sizeof(FChunkHeader));
+	return ChunkHeader.Magic == ChunkMagic && Offset + sizeof(FChunkHeader) + ChunkHeader.DataSize <= (uint64)DataSize;
+}
+
+void FViveMocapTakeReader::ScanChunks()
+{
+	ChunkOffsets.Reset();
+	uint64 Offset = (uint64)Header.HeaderSize + (uint64)Header.NumBones * sizeof(FBoneEntry);
+	// end of data or chunk was cut by crash
+	while (IsChunkValid(Offset))
+	{
+		ChunkOffsets.Add(Offset);
+		Offset += sizeof(FChunkHeader) + GetChunkHeader(ChunkOffsets.Num() - 1).DataSize;
+	}
+}
+
+FChunkHeader FViveMocapTakeReader::GetChunkHeader(int32 Chunk) const
+{
+	check(ChunkOffsets.IsValidIndex(Chunk));
+	FChunkHeader ChunkHeader;
+	FMemory::Memcpy(&ChunkHeader, Data + ChunkOffsets[Chunk], sizeof(FChunkHeader));
+	return ChunkHeader;
+}
+
+bool FViveMocapTakeReader::ReadFrames(TFunctionRef<void(double Time, TArrayView<const FTransform> Pose)> Visitor) const
+{
+	if (!IsOpen())
+	{
+		return false;
+	}
+
+	TArray<FTransform> Pose;
+	Pose.Init(FTransform::Identity, Header.NumBones);
+	double FirstFrameTime = -1.0;
+
+	for (int32 Chunk = 0; Chunk < ChunkOffsets.Num(); Chunk++)
+	{
+		// chunk offsets are validated in Open
+		const FChunkHeader ChunkHeader = GetChunkHeader(Chunk);
+		const uint8* Ptr = Data + ChunkOffsets[Chunk] + sizeof(FChunkHeader);
+		const uint8* const End = Ptr + ChunkHeader.DataSize;
+		auto Read = [&Ptr, End](void* Dest, int32 Size)
+		{
+			if (Ptr + Size > End)
+			{
+				return false;
+			}
+			FMemory::Memcpy(Dest, Ptr, Size);
+			Ptr += Size;
+			return true;
+		};
+
+		for (uint32 Frame = 0; Frame < ChunkHeader.NumFrames; Frame++)
+		{
+			FFrameHeader FrameHeader;
+			if (!Read(&FrameHeader, sizeof(FFrameHeader)))
+			{
+				return false;
+			}
+
+			for (int32 Record = 0; Record < FrameHeader.NumBoneRecords; Record++)
+			{
+				uint16 Flags;
+				if (!Read(&Flags, sizeof(uint16)))
+				{
+					return false;
+				}
+				const uint32 Bone = Flags & Record_BoneMask;
+				if (Bone >= Header.NumBones)
+				{
+					return false;
+				}
+
+				if (Flags & Record_Rotation)
+				{
+					uint16 Packed[3];
+					if (!Read(Packed, sizeof(Packed)))
+					{
+						return false;
+					}
+					Pose[Bone].SetRotation(DequantizeRotation(Packed));
+				}
+				if (Flags & Record_Translation)
+				{
+					float Translation[3];
+					if (!Read(Translation, sizeof(Translation)))
+					{
+						return false;
+					}
+					Pose[Bone].SetTranslation(FVector(Translation[0], Translation[1], Translation[2]));
+				}
+				if (Flags & Record_Scale)
+				{
+					float Scale[3];
+					if (!Read(Scale, sizeof(Scale)))
+					{
+						return false;
+					}
+					Pose[Bone].SetScale3D(FVector(Scale[0], Scale[1], Scale[2]));
+				}
+			}
+
+			const double FrameTime = ChunkHeader.ChunkTime + FrameHeader.TimeOffset * 1e-6;
+			if (FirstFrameTime < 0.0)
+			{
+				FirstFrameTime = FrameTime;
+			}
+			Visitor(FrameTime - FirstFrameTime, Pose);
+		}
+	}
+	return true;
+}
@@ -74,4 +74,7 @@ public:
 protected:
 	UPROPERTY(BlueprintReadOnly, Category = "EditorSVRC")
 	TArray<FSteamVRTrackingBinding> ObjectsToUpdate;
+
+	/** Device topology version ObjectsToUpdate were resolved for */
+	uint32 ObjectsTopologyVersion;
 };
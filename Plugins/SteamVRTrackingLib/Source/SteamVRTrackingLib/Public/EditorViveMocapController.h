@@ -7,8 +7,14 @@
 #include "GameFramework/Actor.h"
 #include "EditorSteamVRController.h"
 #include "Animation/PoseSnapshot.h"
+#include "ViveMocapPoseBuffer.h"
+#include "ViveMocapRecorder.h"
+#include "Engine/EngineBaseTypes.h"
+#include "Async/TaskGraphInterfaces.h"
 #include "EditorViveMocapController.generated.h"
 
+class AEditorViveMocapController;
+
 /** Real-time filters for captured animation */
 UENUM(BlueprintType)
 enum class EEditorCaptureType : uint8
@@ -18,6 +24,27 @@ enum class EEditorCaptureType : uint8
 	CCT_PoseSnapshot			UMETA(DisplayName = "Pose Snapshot Variable")
 };
 
+/** Waits for async mocap solve and applies pose before capture meshes are animated */
+USTRUCT()
+struct FEditorViveMocapJoinTickFunction : public FTickFunction
+{
+	GENERATED_USTRUCT_BODY()
+
+	AEditorViveMocapController* Target = nullptr;
+
+	virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent) override;
+	virtual FString DiagnosticMessage() override;
+};
+
+template<>
+struct TStructOpsTypeTraits<FEditorViveMocapJoinTickFunction> : public TStructOpsTypeTraitsBase2<FEditorViveMocapJoinTickFunction>
+{
+	enum
+	{
+		WithCopy = false
+	};
+};
+
 UCLASS()
 class STEAMVRTRACKINGLIB_API AEditorViveMocapController : public AActor
 {
@@ -27,6 +54,9 @@ public:
 	AEditorViveMocapController();
 	virtual void BeginPlay() override;
 	virtual void Tick(float DeltaTime) override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void BeginDestroy() override;
+	virtual void RegisterActorTickFunctions(bool bRegister) override;
 
 	// Actor root component
 	UPROPERTY(VisibleDefaultsOnly, Category = "Components")
@@ -67,12 +97,25 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Setup")
 	bool bScaledCapture;
 
-	UPROPERTY(BlueprintReadWrite, Category = "Setup")
-	FPoseSnapshot MeshPoseSnapshot;
+	/**
+	* Solve body pose in task graph in parallel with the rest of the game tick. Tracker transforms are copied to proxy input components
+	* when the actor ticks, and the pose is applied after physics, before capture meshes are animated. Several controllers are solved in parallel.
+	* CaptureDevice shouldn't have blueprint tick or debug drawing in this mode.
+	*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Setup")
+	bool bAsyncCapture;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Setup")
 	bool bDebug;
 
+	/** Take keyframe reduction: smaller rotation changes of a bone aren't saved (degrees) */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Recording", meta = (ClampMin = "0"))
+	float TakeRotationTolerance;
+
+	/** Take keyframe reduction: smaller translation changes of a bone aren't saved (cm) */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Recording", meta = (ClampMin = "0"))
+	float TakeTranslationTolerance;
+
 	UFUNCTION(BlueprintCallable, CallInEditor, Category = "Setup")
 	void InitializeDevice();
 
@@ -88,6 +131,36 @@ public:
 	UFUNCTION()
 	void GetBodyCalibration(FBodyCalibrationData& OutCalibration);
 
+	/** Copy last captured pose */
+	UFUNCTION(BlueprintCallable, Category = "Capture")
+	void GetCapturedPose(FPoseSnapshot& OutPose) const;
+
+	/** Last captured pose, or pose set from blueprint if nothing was captured. Pose is only copied when it's requested. */
+	UFUNCTION(BlueprintGetter)
+	FPoseSnapshot GetMeshPoseSnapshot() const;
+
+	UFUNCTION(BlueprintSetter)
+	void SetMeshPoseSnapshot(const FPoseSnapshot& Pose);
+
+	/** Last captured pose, read it by reference */
+	const FViveMocapPoseBuffer& GetPoseBuffer() const { return PoseBuffer; }
+
+	/**
+	* Record captured poses to take file (.vmrec), which can be imported as animation sequence in editor.
+	* Relative file names are saved to Saved/MocapTakes, empty name is made of actor name and time and never overwrites existing take. Recording starts with the next captured pose.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Recording")
+	void StartTakeRecording(const FString& FileName);
+
+	UFUNCTION(BlueprintCallable, CallInEditor, Category = "Recording")
+	void StopTakeRecording();
+
+	UFUNCTION(BlueprintPure, Category = "Recording")
+	bool IsRecordingTake() const;
+
+	/** Index of humanoid bone in BodyMesh skeleton or INDEX_NONE if it isn't mapped in CaptureDevice */
+	int32 GetHumanoidBoneIndex(EHumanoidBone Bone);
+
 	virtual bool ShouldTickIfViewportsOnly() const override
 	{
 		return true;
@@ -104,12 +177,81 @@ protected:
 	UPROPERTY()
 	int32 InputCompsNum;
 
+	/** Captured pose is read through GetMeshPoseSnapshot, this is only the value set from blueprint */
+	UPROPERTY(BlueprintGetter = GetMeshPoseSnapshot, BlueprintSetter = SetMeshPoseSnapshot, Category = "Setup")
+	FPoseSnapshot MeshPoseSnapshot;
+
 	FVMK_BoneRotatorSetup ComponentSpaceSetup;
 
+	/** Humanoid bone (as index) to bone index in skeletal mesh of BodyMesh, built by UpdateBoneIndices */
+	TArray<int32> HumanoidBoneIndices;
+	/** Mesh HumanoidBoneIndices were built for */
+	TWeakObjectPtr<class USkeletalMesh> BoneIndicesMesh;
+
+	/** Rebuild HumanoidBoneIndices if skeletal mesh was changed. Returns false if there is no mesh. */
+	bool UpdateBoneIndices();
+	void InvalidateBoneIndices();
+
+	/** Set component space rotation of a bone in BodyMesh and update component space pose of its children in PoseCS */
+	void SetBoneRotationCS(TArray<FTransform>& PoseCS, int32 BoneIndex, const FRotator& Rotation);
+
+	/** Input components of InputController passed to capture device (directly, or through InputProxies in async mode) */
+	UPROPERTY(Transient)
+	TArray<USceneComponent*> TrackerComponents;
+	/** Unattached copies of tracker transforms read by async solve, so trackers can be moved while it runs */
+	UPROPERTY(Transient)
+	TArray<USceneComponent*> InputProxies;
+	uint8 RightInputId;
+	uint8 LeftInputId;
+	/** Capture device reads InputProxies */
+	bool bProxyInput;
+
+	/** Pass trackers to capture device, or their proxies if bAsyncCapture is set */
+	void InitializeCaptureInput(const TArray<USceneComponent*>& Trackers, uint8 RightId, uint8 LeftId);
+	void CopyTrackersToProxies();
+
+	friend struct FEditorViveMocapJoinTickFunction;
+	FEditorViveMocapJoinTickFunction JoinTickFunction;
+
+	/** Solve running in task graph */
+	FGraphEventRef SolveTask;
+	bool bAsyncSolveSkeletalMesh;
+	/** Bone index in BodyMesh for every bone of PoseBuffer */
+	TArray<int32> PoseBufferBoneIndices;
+	uint32 PoseBufferLayoutVersion;
+
+	/** Game thread. Trackers are already copied to proxies, so body is solved in task graph until FinishAsyncCapture. */
+	void StartAsyncCapture(float DeltaTime);
+	/** Game thread. Wait for solve task and apply its pose to capture mesh. */
+	void FinishAsyncCapture();
+	/** Game thread. Wait for solve task without applying the pose. Returns false if there was none. */
+	bool WaitForAsyncCapture();
+
+	/** Pose written by capture device, its transforms are swapped to PoseBuffer */
+	FPoseSnapshot SolvedPose;
+	FViveMocapPoseBuffer PoseBuffer;
+	/** Anim instance which gets PoseBuffer and layout version of its pose, so bone names are only copied when they change */
+	TWeakObjectPtr<class UAnimInstance> PoseTargetAnimInstance;
+	uint32 PoseTargetLayoutVersion;
+
+	/** Take recorder, created by StartTakeRecording */
+	TUniquePtr<FViveMocapRecorder> TakeRecorder;
+	/** File of take which starts with the next captured pose */
+	FString PendingTakeFileName;
+	/** Bone layout of the take in progress */
+	uint32 TakeLayoutVersion;
+
+	/** Game thread. Pass captured pose to take recorder. */
+	void RecordCapturedPose();
+
+	/** Pass PoseBuffer to skeletal mesh animation */
+	void UpdateSkeletalBodyMesh();
+	/** Apply PoseBuffer to BodyMesh in one write */
+	void UpdatePoseableBodyMesh();
+
 	UFUNCTION()
 	bool BuildTPose();
 
-	FTransform RestoreRefBonePose_WS(const FName& BoneName) const;
 	EAxis::Type FindCoDirection(const FRotator& BoneRotator, const FVector& Direction, float& ResultMultiplier);
 	FRotator MakeRotByTwoAxes(EAxis::Type MainAxis, FVector MainAxisDirection, EAxis::Type SecondaryAxis, FVector SecondaryAxisDirection) const;
 };
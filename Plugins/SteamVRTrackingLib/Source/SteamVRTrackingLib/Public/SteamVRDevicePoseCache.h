@@ -0,0 +1,184 @@
+// (c) YuriNK (ykasczc@gmail.com), 2020. You're free to use it whatever way you want.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SteamVRSeqLock.h"
+#include "SteamVRPoseFilter.h"
+
+class ISteamVRDeviceSource;
+
+/** Which snapshot to read: the one refreshed once per game frame or the one refreshed for render thread late update */
+enum class ESteamVRPoseSnapshot : uint8
+{
+	GameThread,
+	LateUpdate
+};
+
+/** Pose of a single SteamVR device converted to Unreal axes. Position and velocity are in meters. */
+struct STEAMVRTRACKINGLIB_API FSteamVRDevicePose
+{
+	FVector Position;
+	FQuat Orientation;
+	FVector LinearVelocity;
+	/** Radians per second */
+	FVector AngularVelocity;
+
+	/** Device is connected to SteamVR */
+	uint8 bConnected : 1;
+	/** Position and orientation are valid */
+	uint8 bPoseValid : 1;
+	/** Valid pose is only estimated by IMU, optical tracking is lost */
+	uint8 bOutOfRange : 1;
+
+	/** Extrapolate position (meters) and orientation using velocity and angular velocity */
+	void Predict(float Seconds, FVector& OutPosition, FQuat& OutOrientation) const;
+
+	FSteamVRDevicePose()
+		: Position(FVector::ZeroVector)
+		, Orientation(FQuat::Identity)
+		, LinearVelocity(FVector::ZeroVector)
+		, AngularVelocity(FVector::ZeroVector)
+		, bConnected(false)
+		, bPoseValid(false)
+		, bOutOfRange(false)
+	{}
+};
+
+/** Tracking state of a device as seen by game thread snapshots */
+enum class ESteamVRTrackingState : uint8
+{
+	Disconnected,
+	Tracked,
+	/** Pose is only estimated by IMU */
+	InertialOnly,
+	/** Device is connected but has no valid pose */
+	Lost
+};
+
+/** Tracking state machine of a single device and its dropout statistics. Dropout is any time between losing and regaining full tracking while connected. */
+struct FSteamVRDeviceTrackingState
+{
+	ESteamVRTrackingState State = ESteamVRTrackingState::Disconnected;
+	/** FPlatformTime::Seconds() when State was entered */
+	double StateStartTime = 0.0;
+	/** Last pose with full tracking since device connected (bPoseValid is false if there was none) and time when it was received */
+	FSteamVRDevicePose LastGoodPose;
+	double LastGoodTime = 0.0;
+	double DropoutStartTime = 0.0;
+
+	uint32 NumDropouts = 0;
+	double TotalDropoutSeconds = 0.0;
+	double LongestDropoutSeconds = 0.0;
+
+	bool IsInDropout() const { return State == ESteamVRTrackingState::InertialOnly || State == ESteamVRTrackingState::Lost; }
+};
+
+/**
+* Poses of all SteamVR devices fetched with a single OpenVR pose array query.
+* Game thread snapshot is refreshed once per GFrameCounter, late update snapshot once per GFrameNumberRenderThread,
+* so every consumer in the frame reads the same data by device index.
+*/
+class STEAMVRTRACKINGLIB_API FSteamVRDevicePoseCache
+{
+public:
+	/** Same as vr::k_unMaxTrackedDeviceCount */
+	static constexpr int32 MaxDevices = 64;
+
+	FSteamVRDevicePoseCache();
+
+	/** Get pose of the device from the snapshot, refreshing the snapshot if it's outdated. Returns nullptr for invalid device index. */
+	const FSteamVRDevicePose* GetDevicePose(int32 DeviceId, ESteamVRPoseSnapshot Snapshot = ESteamVRPoseSnapshot::GameThread);
+
+	/**
+	* Replacement for USteamVRFunctionLibrary::GetTrackedDevicePositionAndOrientation. Returns false if pose isn't valid.
+	* If PredictionSeconds isn't zero, pose is extrapolated from velocities.
+	*/
+	bool GetDevicePositionAndOrientation(int32 DeviceId, FVector& OutPosition, FRotator& OutOrientation, float WorldToMetersScale = 100.f, ESteamVRPoseSnapshot Snapshot = ESteamVRPoseSnapshot::GameThread, float PredictionSeconds = 0.f);
+
+	/**
+	* Estimated time from the moment snapshot was taken until its frame is visible on HMD display.
+	* Game thread snapshot is one frame further from display than late update snapshot.
+	*/
+	float GetSecondsToPhotons(ESteamVRPoseSnapshot Snapshot = ESteamVRPoseSnapshot::GameThread);
+
+	/**
+	* Smooth pose of the device in both snapshots. Game thread only.
+	* Filters run in the snapshot refresh, so every consumer of the cache gets filtered pose.
+	*/
+	void SetDeviceFilter(int32 DeviceId, const FSteamVRPoseFilterSettings& Settings);
+	void ClearDeviceFilters();
+
+	/** Don't extrapolate further than this */
+	static constexpr float MaxPredictionSeconds = 0.1f;
+
+	/** Bit mask of connected devices in the snapshot */
+	uint64 GetConnectedDevicesMask(ESteamVRPoseSnapshot Snapshot = ESteamVRPoseSnapshot::GameThread);
+
+	/**
+	* Game thread. Bit mask of connected devices which doesn't refresh game thread snapshot: it's taken from the snapshot
+	* if it was already refreshed in this frame, otherwise device source is queried directly.
+	*/
+	uint64 QueryConnectedDevicesMask();
+
+	/** Tracking system base transform as of the last game thread refresh. Any thread. */
+	void GetBaseTransform(FQuat& OutBaseOrientation, FVector& OutBaseOffset) const;
+
+	/** Game thread. State machine is advanced with every game thread snapshot refresh. Returns nullptr for invalid device index. */
+	const FSteamVRDeviceTrackingState* GetDeviceTrackingState(int32 DeviceId);
+
+	/** Game thread. Reset dropout statistics of all devices, e.g. when session recording starts. */
+	void ResetDropoutStats();
+
+	/** Game thread. All poses are read from this source. */
+	void SetDeviceSource(const TSharedPtr<ISteamVRDeviceSource, ESPMode::ThreadSafe>& InDeviceSource);
+	ISteamVRDeviceSource* GetDeviceSource() const { return DeviceSource.Get(); }
+	const TSharedPtr<ISteamVRDeviceSource, ESPMode::ThreadSafe>& GetSharedDeviceSource() const { return DeviceSource; }
+
+	/** Transform pose from tracking space to tracking space with base offset and orientation (like HMD does) */
+	static void ApplyBaseTransform(FSteamVRDevicePose& Pose, const FQuat& BaseOrientation, const FVector& BaseOffset);
+
+private:
+	struct FSnapshot
+	{
+		FSteamVRDevicePose Poses[MaxDevices];
+		uint64 ConnectedMask;
+		uint64 FrameNumber;
+		float SecondsToPhotons;
+		/** FPlatformTime::Seconds() of the last refresh */
+		double Timestamp;
+		/** Each snapshot is a separate stream of samples, so it has its own filter state */
+		FSteamVRPoseFilter Filter;
+
+		FSnapshot() : ConnectedMask(0), FrameNumber(MAX_uint64), SecondsToPhotons(0.f), Timestamp(0.0) {}
+	};
+
+	FSnapshot GameThreadSnapshot;
+	FSnapshot LateUpdateSnapshot;
+
+	/** Advanced by game thread snapshot */
+	FSteamVRDeviceTrackingState TrackingStates[MaxDevices];
+
+	/** Poses fetched by QueryConnectedDevicesMask, only the mask is used */
+	FSteamVRDevicePose ConnectedQueryPoses[MaxDevices];
+
+	struct FBaseTransform
+	{
+		FQuat Orientation;
+		FVector Offset;
+	};
+
+	/** Tracking system base transform, updated on game thread and reused by late update and background sampler */
+	TSteamVRSeqLock<FBaseTransform> BaseTransform;
+
+	TSharedPtr<ISteamVRDeviceSource, ESPMode::ThreadSafe> DeviceSource;
+
+	/** HMD display timing, read from device properties when HMD connects */
+	float FrameDuration;
+	float VsyncToPhotons;
+	bool bDisplayTimingValid;
+
+	FSnapshot& GetUpdatedSnapshot(ESteamVRPoseSnapshot Snapshot);
+	void Refresh(FSnapshot& Snapshot, bool bAddFrameLatency);
+	void UpdateTrackingStates(const FSnapshot& Snapshot);
+};
@@ -0,0 +1,43 @@
+// (c) YuriNK (ykasczc@gmail.com), 2020. You're free to use it whatever way you want.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SteamVRTrackingSetup.h"
+#include <atomic>
+
+/** Tracking setup bindings (friendly name -> serial number) with device IDs resolved for one device topology */
+struct FSteamVRDeviceRegistrySnapshot
+{
+	TMap<FName, FSteamVRDeviceBindingSetup> Bindings;
+	uint32 TopologyVersion = 0;
+};
+
+/**
+* Publishes immutable FSteamVRDeviceRegistrySnapshot by atomic pointer swap (read-copy-update).
+* Readers never wait and always see either the old or the new complete snapshot.
+* Replaced snapshots are deleted when both game and render threads passed the frame they were replaced in,
+* so a reader shouldn't keep snapshot pointer longer than the current frame. Other threads aren't fenced:
+* worker tasks should get bindings they need on game thread before they start.
+*/
+class STEAMVRTRACKINGLIB_API FSteamVRDeviceRegistry
+{
+public:
+	FSteamVRDeviceRegistry();
+	~FSteamVRDeviceRegistry();
+
+	/** Game and render threads. Never null. */
+	const FSteamVRDeviceRegistrySnapshot& Read() const { return *Current.load(std::memory_order_acquire); }
+
+	/** Game thread. Replace current snapshot. */
+	void Publish(TUniquePtr<FSteamVRDeviceRegistrySnapshot> NewSnapshot);
+
+	/** Game thread, once per frame. Delete replaced snapshots nobody can read anymore. */
+	void CollectRetired();
+
+private:
+	struct FRetiredSnapshot;
+
+	std::atomic<const FSteamVRDeviceRegistrySnapshot*> Current;
+	TArray<TUniquePtr<FRetiredSnapshot>> Retired;
+};
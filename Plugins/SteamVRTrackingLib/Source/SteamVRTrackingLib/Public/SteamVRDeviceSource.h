@@ -0,0 +1,55 @@
+// (c) YuriNK (ykasczc@gmail.com), 2020. You're free to use it whatever way you want.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SteamVRFunctionLibrary.h"
+
+struct FSteamVRDevicePose;
+
+/** Hand assigned to a controller by SteamVR */
+enum class ESteamVRControllerRole : uint8
+{
+	Invalid,
+	LeftHand,
+	RightHand,
+	/** Connected controller which isn't assigned to any hand */
+	Other
+};
+
+/**
+* Where poses, classes and serial numbers of tracked devices come from.
+* Everything in SteamVRTrackingLib reads devices through this interface, so OpenVR can be replaced by simulation
+* (e.g. on headless Linux machines without HMD). Implementations should be safe to call from any thread.
+*/
+class STEAMVRTRACKINGLIB_API ISteamVRDeviceSource
+{
+public:
+	virtual ~ISteamVRDeviceSource() {}
+
+	virtual FName GetSourceName() const = 0;
+
+	/** False if the source can't provide any data now (e.g. SteamVR isn't running) */
+	virtual bool IsAvailable() const = 0;
+
+	/**
+	* Fill FSteamVRDevicePoseCache::MaxDevices poses converted to Unreal axes (meters), relative to tracking base transform.
+	* Returns mask of connected devices.
+	*/
+	virtual uint64 GetDevicePoses(const FQuat& BaseOrientation, const FVector& BaseOffset, FSteamVRDevicePose* OutPoses) = 0;
+
+	virtual ESteamVRTrackedDeviceType GetDeviceType(int32 DeviceId) = 0;
+
+	/** Can change while device stays connected (e.g. when user swaps controllers in SteamVR) */
+	virtual ESteamVRControllerRole GetControllerRole(int32 DeviceId) = 0;
+
+	/** Copy null-terminated serial number to OutSerialNumber. Returns false if it isn't available. */
+	virtual bool GetSerialNumber(int32 DeviceId, ANSICHAR* OutSerialNumber, int32 BufferSize) = 0;
+
+	/** Copy null-terminated name of SteamVR render model (the same for all devices of a kind, e.g. all Vive trackers). Returns false if device has no model. */
+	virtual bool GetRenderModelName(int32 DeviceId, ANSICHAR* OutModelName, int32 BufferSize) = 0;
+
+	/** HMD display timing used for pose prediction. Returns false if there is no HMD. */
+	virtual bool GetDisplayTiming(float& OutFrameDuration, float& OutVsyncToPhotons) = 0;
+	virtual bool GetTimeSinceLastVsync(float& OutSeconds) = 0;
+};
@@ -0,0 +1,75 @@
+// (c) YuriNK (ykasczc@gmail.com), 2020. You're free to use it whatever way you want.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SteamVRFunctionLibrary.h"
+
+class FSteamVRTrackingLibModule;
+class IMotionController;
+class IModularFeature;
+
+/**
+* Caches MotionSource (Left, Right, Special_N) -> SteamVR device ID mapping.
+* Cached ID is invalidated when set of connected devices or controller roles change. Left and Right are resolved
+* by controller role if SteamVR assigned it; otherwise ID is verified once per frame by comparing position of
+* the device with position of motion source. Verification is skipped for devices in tracking dropout and limited
+* to MaxVerificationsPerFrame, so reacquisition can't spike the frame.
+* Game thread only.
+*/
+class STEAMVRTRACKINGLIB_API FSteamVRMotionSourceResolver
+{
+public:
+	FSteamVRMotionSourceResolver(FSteamVRTrackingLibModule& InTrackingLibModule);
+	~FSteamVRMotionSourceResolver();
+
+	int32 GetDeviceIdByMotionSource(const FName& MotionSource, bool bAnyDeviceType, ESteamVRTrackedDeviceType DeviceType);
+
+	/** Is this name a standard motion source (Left, Right, Special_N) rather than device friendly name? */
+	static bool IsMotionSource(const FName& Name);
+
+	/** Drop all cached IDs */
+	void Invalidate();
+
+	/** Cached IDs verified by position in one frame, others keep cached ID until the next frame */
+	static constexpr int32 MaxVerificationsPerFrame = 8;
+
+private:
+	enum class EMotionSourceKind : uint8
+	{
+		FriendlyName,
+		Left,
+		Right,
+		Special
+	};
+
+	struct FCachedMotionSource
+	{
+		EMotionSourceKind Kind;
+		/* N in Special_N */
+		int32 SpecialIndex;
+		int32 DeviceId;
+		uint32 TopologyVersion;
+		uint64 ResolvedFrame;
+		/* Left and Right resolved by controller role don't need position check */
+		bool bResolvedByRole;
+	};
+
+	FSteamVRTrackingLibModule& TrackingLibModule;
+
+	/* Key is motion source name and device type filter */
+	TMap<TPair<FName, uint8>, FCachedMotionSource> Cache;
+
+	TArray<IMotionController*> MotionControllers;
+	bool bMotionControllersDirty;
+
+	uint64 VerificationFrame;
+	int32 NumVerifications;
+
+	static void ParseMotionSource(const FName& MotionSource, FCachedMotionSource& OutEntry);
+	bool GetMotionSourceLocation(const FName& MotionSource, FVector& OutLocation);
+	int32 FindNearestDevice(const FVector& Location, bool bAnyDeviceType, ESteamVRTrackedDeviceType DeviceType);
+	int32 FindSpecialTracker(int32 SpecialIndex);
+
+	void OnModularFeatureChanged(const FName& Type, IModularFeature* ModularFeature);
+};
@@ -0,0 +1,96 @@
+// (c) YuriNK (ykasczc@gmail.com), 2020. You're free to use it whatever way you want.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SteamVRPoseFilter.generated.h"
+
+struct FSteamVRDevicePose;
+
+/** Smoothing applied to tracked device pose */
+UENUM(BlueprintType)
+enum class ESteamVRPoseFilter : uint8
+{
+	None,
+	/** Adaptive low-pass filter: strong smoothing at low speed, low lag at high speed */
+	OneEuro,
+	/** Critically damped spring following the device */
+	CriticallyDamped
+};
+
+USTRUCT(BlueprintType)
+struct STEAMVRTRACKINGLIB_API FSteamVRPoseFilterSettings
+{
+	GENERATED_USTRUCT_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Pose Filter")
+	ESteamVRPoseFilter Type;
+
+	/** One-Euro: cutoff frequency (Hz) at zero speed. Lower value removes more jitter. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Pose Filter", meta = (EditCondition = "Type == ESteamVRPoseFilter::OneEuro", ClampMin = "0.01"))
+	float MinCutoff;
+
+	/** One-Euro: cutoff frequency increase per unit of speed. Higher value reduces lag on fast motion. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Pose Filter", meta = (EditCondition = "Type == ESteamVRPoseFilter::OneEuro", ClampMin = "0.0"))
+	float Beta;
+
+	/** Critically damped: approximate time (seconds) to reach the device pose */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Pose Filter", meta = (EditCondition = "Type == ESteamVRPoseFilter::CriticallyDamped", ClampMin = "0.001"))
+	float SmoothTime;
+
+	FSteamVRPoseFilterSettings()
+		: Type(ESteamVRPoseFilter::None)
+		, MinCutoff(1.f)
+		, Beta(0.5f)
+		, SmoothTime(0.05f)
+	{}
+
+	/** Parameters of disabled filter don't matter */
+	bool operator==(const FSteamVRPoseFilterSettings& Other) const
+	{
+		return Type == Other.Type
+			&& (Type == ESteamVRPoseFilter::None || (MinCutoff == Other.MinCutoff && Beta == Other.Beta && SmoothTime == Other.SmoothTime));
+	}
+	bool operator!=(const FSteamVRPoseFilterSettings& Other) const { return !(*this == Other); }
+};
+
+/**
+* Filters position and orientation of all devices at once.
+* State is stored as structure of arrays (one array per position/quaternion component), so four devices are processed per SIMD instruction.
+*/
+class STEAMVRTRACKINGLIB_API FSteamVRPoseFilter
+{
+public:
+	static constexpr int32 MaxDevices = 64;
+
+	FSteamVRPoseFilter();
+
+	void SetDeviceFilter(int32 DeviceId, const FSteamVRPoseFilterSettings& Settings);
+	void ClearDeviceFilters();
+	bool HasActiveFilters() const { return ActiveMask != 0; }
+
+	/** Filter array of MaxDevices poses in place. DeltaTime is time since previous call. */
+	void Apply(FSteamVRDevicePose* Poses, float DeltaTime);
+
+private:
+	/** Position XYZ, quaternion XYZW */
+	static constexpr int32 NumChannels = 7;
+
+	/** Filtered value from previous frame */
+	alignas(16) float Value[NumChannels][MaxDevices];
+	/** One-Euro: filtered derivative, critically damped: spring velocity */
+	alignas(16) float Derivative[NumChannels][MaxDevices];
+	/** Raw input of this frame */
+	alignas(16) float Input[NumChannels][MaxDevices];
+
+	alignas(16) float MinCutoff[MaxDevices];
+	alignas(16) float Beta[MaxDevices];
+	alignas(16) float SmoothTime[MaxDevices];
+	/** ESteamVRPoseFilter of the lane in this frame as float, 0 if lane is passed through */
+	alignas(16) float LaneMode[MaxDevices];
+
+	ESteamVRPoseFilter Type[MaxDevices];
+	uint64 ActiveMask;
+	/** Devices with valid filter state */
+	uint64 InitializedMask;
+};
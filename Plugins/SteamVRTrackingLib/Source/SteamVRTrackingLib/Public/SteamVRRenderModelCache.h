@@ -0,0 +1,64 @@
+// (c) YuriNK (ykasczc@gmail.com), 2020. You're free to use it whatever way you want.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/GCObject.h"
+
+class UMaterialInterface;
+class UPrimitiveComponent;
+class UStaticMesh;
+class UWorld;
+
+/** Mesh and materials of SteamVR render model shared by display components of all devices of this model */
+struct FSteamVRRenderModel
+{
+	enum class EState : uint8
+	{
+		Loading,
+		Ready,
+		/** Model can't be shared (e.g. XR system created not a static mesh component), components create their own */
+		Failed
+	};
+
+	EState State = EState::Loading;
+	UStaticMesh* Mesh = nullptr;
+	TArray<UMaterialInterface*> Materials;
+
+	/** Component created by IXRSystemAssets to load the model, destroyed when load is complete */
+	TWeakObjectPtr<UPrimitiveComponent> Loader;
+};
+
+/**
+* Render models of SteamVR devices keyed by model name (Prop_RenderModelName_String).
+* Model is loaded once through SteamVR IXRSystemAssets, and display components instance its mesh instead of loading it again.
+* Loads are always asynchronous; prewarm models of connected devices on level load to have them ready when tracking starts.
+* Game thread only.
+*/
+class STEAMVRTRACKINGLIB_API FSteamVRRenderModelCache : public FGCObject
+{
+public:
+	/** Name of render model of the device or None if it isn't available */
+	FName GetModelName(int32 DeviceId) const;
+
+	/** Start loading model if it isn't cached. Returns nullptr if model can't be loaded at all. */
+	const FSteamVRRenderModel* RequestModel(const FName& ModelName, int32 DeviceId, UWorld* World);
+
+	/** Cached model or nullptr */
+	const FSteamVRRenderModel* FindModel(const FName& ModelName) const { return Models.Find(ModelName); }
+
+	/** Request models of all connected devices */
+	void PrewarmConnectedDevices(UWorld* World);
+
+	/** Release all meshes. Display components keep their own references. */
+	void Empty();
+
+	//~ FGCObject interface
+	virtual void AddReferencedObjects(FReferenceCollector& Collector) override;
+	virtual FString GetReferencerName() const override { return TEXT("FSteamVRRenderModelCache"); }
+
+private:
+	TMap<FName, FSteamVRRenderModel> Models;
+
+	void OnModelLoaded(UPrimitiveComponent* LoadedComponent, FName ModelName);
+};
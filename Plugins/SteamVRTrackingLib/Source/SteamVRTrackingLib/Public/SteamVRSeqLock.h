@@ -0,0 +1,56 @@
+// (c) YuriNK (ykasczc@gmail.com), 2020. You're free to use it whatever way you want.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include <atomic>
+
+/**
+* Sequence lock for one writer and any number of readers.
+* Writer never waits, readers retry if they caught the value in the middle of update.
+* T is copied as raw memory, so it should be a plain data struct.
+*/
+template<typename T>
+class TSteamVRSeqLock
+{
+public:
+	TSteamVRSeqLock()
+		: Sequence(0)
+		, Data()
+	{}
+
+	/** Only one thread is allowed to write at a time */
+	void Write(const T& Value)
+	{
+		const uint32 Seq = Sequence.load(std::memory_order_relaxed);
+		Sequence.store(Seq + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		FMemory::Memcpy(&Data, &Value, sizeof(T));
+		Sequence.store(Seq + 2, std::memory_order_release);
+	}
+
+	/** Returns number of retries */
+	uint32 Read(T& OutValue) const
+	{
+		uint32 Retries = 0;
+		for (;;)
+		{
+			const uint32 SeqBefore = Sequence.load(std::memory_order_acquire);
+			if ((SeqBefore & 1) == 0)
+			{
+				FMemory::Memcpy(&OutValue, &Data, sizeof(T));
+				std::atomic_thread_fence(std::memory_order_acquire);
+				if (Sequence.load(std::memory_order_relaxed) == SeqBefore)
+				{
+					return Retries;
+				}
+			}
+			Retries++;
+			FPlatformProcess::Yield();
+		}
+	}
+
+private:
+	std::atomic<uint32> Sequence;
+	T Data;
+};
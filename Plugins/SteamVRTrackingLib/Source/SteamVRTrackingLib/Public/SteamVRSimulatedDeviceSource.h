@@ -0,0 +1,87 @@
+// (c) YuriNK (ykasczc@gmail.com), 2020. You're free to use it whatever way you want.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SteamVRDeviceSource.h"
+#include "SteamVRTrackingRecording.h"
+
+/**
+* Device source without SteamVR. Plays back recorded tracking session (.svrrec) in a loop or generates procedural poses:
+* HMD (ID 0), tracking references, controllers and trackers moving along deterministic paths.
+* Poses depend only on time since creation, so source can be used from any thread.
+*/
+class STEAMVRTRACKINGLIB_API FSteamVRSimulatedDeviceSource : public ISteamVRDeviceSource
+{
+public:
+	struct FSettings
+	{
+		int32 NumTrackingReferences = 2;
+		int32 NumControllers = 2;
+		int32 NumTrackers = 4;
+		/** Chance (0..1) of a device to lose tracking during every DropoutWindow seconds. Half of dropouts are out-of-range (IMU only). */
+		float DropoutChance = 0.f;
+		float DropoutWindow = 0.1f;
+		/**
+		* If not zero, every ChurnPeriod seconds one of trackers disconnects and tracker device IDs are reassigned,
+		* like SteamVR does when trackers reconnect in different order.
+		*/
+		float ChurnPeriod = 0.f;
+		uint32 Seed = 0;
+	};
+
+	FSteamVRSimulatedDeviceSource(const FSettings& InSettings);
+
+	/** Play back recorded session instead of procedural poses. Recorded poses already include base transform of the recording session. */
+	bool OpenRecording(const FString& FileName);
+	bool IsPlayingRecording() const { return Reader.IsOpen(); }
+
+	/** ISteamVRDeviceSource interface */
+	virtual FName GetSourceName() const override { return TEXT("Simulated"); }
+	virtual bool IsAvailable() const override { return true; }
+	virtual uint64 GetDevicePoses(const FQuat& BaseOrientation, const FVector& BaseOffset, FSteamVRDevicePose* OutPoses) override;
+	virtual ESteamVRTrackedDeviceType GetDeviceType(int32 DeviceId) override;
+	virtual ESteamVRControllerRole GetControllerRole(int32 DeviceId) override;
+	virtual bool GetSerialNumber(int32 DeviceId, ANSICHAR* OutSerialNumber, int32 BufferSize) override;
+	virtual bool GetRenderModelName(int32 DeviceId, ANSICHAR* OutModelName, int32 BufferSize) override;
+	virtual bool GetDisplayTiming(float& OutFrameDuration, float& OutVsyncToPhotons) override;
+	virtual bool GetTimeSinceLastVsync(float& OutSeconds) override;
+
+private:
+	static constexpr float SimulatedFrameDuration = 1.f / 90.f;
+	static constexpr float SimulatedVsyncToPhotons = 0.011f;
+
+	/** Procedural device roles in order of device IDs */
+	enum class ERole : uint8
+	{
+		None,
+		HMD,
+		TrackingReference,
+		Controller,
+		Tracker
+	};
+
+	FSettings Settings;
+	double StartTime;
+	int32 FirstControllerId;
+	int32 FirstTrackerId;
+	/** Number of device IDs trackers rotate through. One more than trackers if churn is enabled. */
+	int32 NumTrackerIds;
+
+	FSteamVRTrackingRecordingReader Reader;
+	double RecordingStartTime;
+	double RecordingDuration;
+
+	double GetTime() const { return FPlatformTime::Seconds() - StartTime; }
+
+	/** Which device has DeviceId at Time. OutIndex is index of the device within its role. */
+	ERole GetDeviceRole(int32 DeviceId, double Time, int32& OutIndex) const;
+	void GetProceduralPose(ERole Role, int32 Index, double Time, FVector& OutPosition, FQuat& OutOrientation) const;
+	/** Random number in 0..1 which only depends on arguments and seed */
+	float GetNoise(uint32 A, uint32 B) const;
+
+	/** Sample of the recording played at Time. Returns false if there is no such sample. */
+	bool FindRecordedSample(double Time, int32& OutChunk, int32& OutLastRecord, uint64& OutSampleIndex) const;
+	double GetPlaybackTime(double Time) const;
+	uint64 GetRecordedPoses(double Time, FSteamVRDevicePose* OutPoses) const;
+};
@@ -6,17 +6,17 @@
 #include "CoreMinimal.h"
 #include "UObject/ObjectMacros.h"
 #include "Components/PrimitiveComponent.h"
-#include "SceneViewExtension.h"
-#include "LateUpdateManager.h"
-#include "IIdentifiableXRDevice.h"
 #include "SteamVRTrackingLib.h"
+#include "SteamVRTrackedDeviceUpdater.h"
 #include "SteamVRTrackedDeviceComponent.generated.h"
 
-class FPrimitiveSceneInfo;
-class FRHICommandListImmediate;
-class FSceneView;
-class FSceneViewFamily;
+class UMaterialInterface;
+class UPrimitiveComponent;
 
+/**
+* Tracked device as primitive component. It doesn't render anything itself,
+* so prefer USteamVRTrackedDeviceSceneComponent if collision and bounds of this component aren't used.
+*/
 UCLASS(Blueprintable, meta = (BlueprintSpawnableComponent), ClassGroup = SteamVR)
 class STEAMVRTRACKINGLIB_API USteamVRTrackedDeviceComponent : public UPrimitiveComponent
 {
@@ -35,7 +35,10 @@ class STEAMVRTRACKINGLIB_API USteamVRTrackedDeviceComponent : public UPrimitiveC
 	UPROPERTY()
 	bool bTrackedDeviceNameIsMotionSource;
 
-	/** Force SteamVR Device ID update each N seconds. Negative value to disable, 0 to update in every tick */
+	/**
+	* Force SteamVR Device ID update each N seconds. Negative value to disable, 0 to update in every tick.
+	* Not required normally: IDs are updated on the next frame after device reconnects.
+	*/
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta=(DisplayName="SteamVR ID Update Interval"), Category = "SteamVR Tracked Device")
 	float SteamVRIdUpdateInterval;
 
@@ -43,6 +46,22 @@ class STEAMVRTRACKINGLIB_API USteamVRTrackedDeviceComponent : public UPrimitiveC
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SteamVR Tracked Device")
 	uint32 bDisableLowLatencyUpdate:1;
 
+	/** Extrapolate pose from device velocity and angular velocity to hide tracking latency. Applied to game thread and late update poses. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SteamVR Tracked Device")
+	ESteamVRPosePrediction PosePrediction;
+
+	/** Look-ahead time (seconds) for Fixed pose prediction */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SteamVR Tracked Device", meta = (EditCondition = "PosePrediction == ESteamVRPosePrediction::Fixed", ClampMin = "0.0", ClampMax = "0.1", UIMin = "0.0", UIMax = "0.1"))
+	float PredictionTime;
+
+	/** Keep last good pose (and IsTracked) for this time (seconds) when device loses tracking, e.g. when tracker is occluded. 0 to disable. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SteamVR Tracked Device", meta = (ClampMin = "0.0", UIMin = "0.0", UIMax = "1.0"))
+	float DropoutHoldTime;
+
+	/** Extrapolate held pose from velocity of the last good pose (at most 0.1 second) instead of freezing it */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SteamVR Tracked Device", meta = (EditCondition = "DropoutHoldTime > 0.0"))
+	bool bExtrapolateDropout;
+
 	/** The tracking status for the device (e.g. full tracking, inertial tracking only, no tracking) */
 	UPROPERTY(BlueprintReadOnly, Category = "SteamVR Tracked Device")
 	ETrackingStatus CurrentTrackingStatus;
@@ -53,7 +72,7 @@ class STEAMVRTRACKINGLIB_API USteamVRTrackedDeviceComponent : public UPrimitiveC
 	UFUNCTION(BlueprintPure, Category = "SteamVR Tracked Device")
 	bool IsTracked() const
 	{
-		return bTracked;
+		return Updater.IsTracked();
 	}
 
 	/** Used to automatically render a model associated with the set hand. */
@@ -91,74 +110,28 @@ public:
 	virtual void OnComponentDestroyed(bool bDestroyingHierarchy) override;
 
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 protected:
-	//~ Begin UActorComponent Interface.
-	virtual void CreateRenderState_Concurrent(FRegisterComponentContext* Context) override;
-	virtual void SendRenderTransform_Concurrent() override;
-	//~ End UActorComponent Interface.
-
-	FSteamVRTrackingLibModule* TrackingLibModule;
-
 	void RefreshDisplayComponent(const bool bForceDestroy = false);
 
 private:
+	/** Device polling, late update and display model */
+	FSteamVRTrackedDeviceUpdater Updater;
 
-	/** Whether or not this component had a valid tracked controller associated with it this frame*/
-	bool bTracked;
-
-	/** Whether or not this component has authority within the frame*/
-	bool bHasAuthority;
+	/** Properties above as the updater takes them, copied in GetTrackingSettings */
+	FSteamVRTrackedDeviceSettings TrackingSettings;
 
-	/** If true, the Position and Orientation args will contain the most recent controller state */
-	bool PollControllerState(FVector& Position, FRotator& Orientation, float WorldToMetersScale);
+	const FSteamVRTrackedDeviceSettings& GetTrackingSettings();
 
-	FTransform RenderThreadRelativeTransform;
-	FVector RenderThreadComponentScale;
-	float NextIdUpdateTime;
+	/** Called from TickComponent or by USteamVRTrackingSubsystem */
+	void UpdateTrackedDevice(float WorldToMetersScale);
 
-	/** View extension object that can persist on the render thread without the motion controller component */
-	class FViewExtension : public FSceneViewExtensionBase
-	{
-	public:
-		FViewExtension(const FAutoRegister& AutoRegister, USteamVRTrackedDeviceComponent* InSteamVRTrackedDeviceComponent);
-		virtual ~FViewExtension() {}
-
-		/** ISceneViewExtension interface */
-		virtual void SetupViewFamily(FSceneViewFamily& InViewFamily) override {}
-		virtual void SetupView(FSceneViewFamily& InViewFamily, FSceneView& InView) override {}
-		virtual void BeginRenderViewFamily(FSceneViewFamily& InViewFamily) override;
-		virtual void PreRenderView_RenderThread(FRHICommandListImmediate& RHICmdList, FSceneView& InView) override {}
-		virtual void PreRenderViewFamily_RenderThread(FRHICommandListImmediate& RHICmdList, FSceneViewFamily& InViewFamily) override;
-		virtual int32 GetPriority() const override { return -10; }
-		virtual bool IsActiveThisFrame_Internal(const FSceneViewExtensionContext& Context) const;
-
-	private:
-		friend class USteamVRTrackedDeviceComponent;
-
-		/** Motion controller component associated with this view extension */
-		USteamVRTrackedDeviceComponent* SteamVRTrackedDeviceComponent;
-		FLateUpdateManager LateUpdate;
-	};
-	TSharedPtr< FViewExtension, ESPMode::ThreadSafe > ViewExtension;	
- 
 	UPROPERTY(Transient, BlueprintReadOnly, Category=Visualization, meta=(AllowPrivateAccess="true"))
 	UPrimitiveComponent* DisplayComponent;
 
 	/** Callback for asynchronous display model loads (to set materials, etc.) */
 	void OnDisplayModelLoaded(UPrimitiveComponent* DisplayComponent);
 
-	enum class EModelLoadStatus : uint8
-	{
-		Unloaded,
-		Pending,
-		InProgress,
-		Complete
-	};
-	EModelLoadStatus DisplayModelLoadState = EModelLoadStatus::Unloaded;
-
-	FXRDeviceId DisplayDeviceId;
-#if WITH_EDITOR
-	int32 PreEditMaterialCount = 0;
-#endif
+	FXRComponentLoadComplete GetLoadCompleteDelegate();
 };
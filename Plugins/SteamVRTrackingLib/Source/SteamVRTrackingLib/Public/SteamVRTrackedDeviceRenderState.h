@@ -0,0 +1,115 @@
+// (c) YuriNK (ykasczc@gmail.com), 2020. You're free to use it whatever way you want.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SteamVRSeqLock.h"
+#include <atomic>
+
+class FSteamVRTrackingLibModule;
+class FSceneViewFamily;
+class USceneComponent;
+
+/**
+* Few seqlock slots addressed by frame number. Game thread can run ahead of render thread,
+* so render thread reads exactly the value published for the view family it renders.
+*/
+template<typename T, uint32 NumSlots = 4>
+class TSteamVRFrameMailbox
+{
+public:
+	void Write(uint32 FrameNumber, const T& Value)
+	{
+		FSlot Slot;
+		Slot.FrameNumber = FrameNumber;
+		Slot.Value = Value;
+		Slots[FrameNumber % NumSlots].Write(Slot);
+	}
+
+	/** Returns false if nothing was published for this frame (or it was already overwritten). OutRetries is optional. */
+	bool Read(uint32 FrameNumber, T& OutValue, uint32* OutRetries = nullptr) const
+	{
+		FSlot Slot;
+		const uint32 Retries = Slots[FrameNumber % NumSlots].Read(Slot);
+		if (OutRetries)
+		{
+			*OutRetries = Retries;
+		}
+		if (Slot.FrameNumber != FrameNumber)
+		{
+			return false;
+		}
+		OutValue = Slot.Value;
+		return true;
+	}
+
+private:
+	struct FSlot
+	{
+		uint32 FrameNumber = MAX_uint32;
+		T Value;
+	};
+	TSteamVRSeqLock<FSlot> Slots[NumSlots];
+};
+
+/** Game thread state of tracked device component required by late update */
+struct FSteamVRTrackedDeviceLateUpdateData
+{
+	FTransform RelativeTransform;
+	FVector ComponentScale;
+	int32 DeviceId;
+	int32 PlayerIndex;
+	/** Fixed look-ahead, used if bPredictFromFrameTiming is false */
+	float PredictionSeconds;
+	bool bPredictFromFrameTiming;
+	bool bHasAuthority;
+
+	FSteamVRTrackedDeviceLateUpdateData()
+		: RelativeTransform(FTransform::Identity)
+		, ComponentScale(FVector::OneVector)
+		, DeviceId(INDEX_NONE)
+		, PlayerIndex(0)
+		, PredictionSeconds(0.f)
+		, bPredictFromFrameTiming(false)
+		, bHasAuthority(false)
+	{}
+};
+
+/**
+* Render thread side of tracked device component. Shared by component and view extension,
+* so render thread never touches UObject and component destruction doesn't need to wait for render thread.
+*/
+class STEAMVRTRACKINGLIB_API FSteamVRTrackedDeviceRenderState
+{
+public:
+	FSteamVRTrackedDeviceRenderState(FSteamVRTrackingLibModule* InTrackingLibModule)
+		: bLateUpdateEnabled(true)
+		, TrackingLibModule(InTrackingLibModule)
+		, bComponentAlive(true)
+	{}
+
+	/** Game thread copy of late update data. Component updates DeviceId, PlayerIndex and authority here. */
+	FSteamVRTrackedDeviceLateUpdateData GameThreadData;
+	/** Game thread only */
+	bool bLateUpdateEnabled;
+
+	/** Written by game thread when view family is set up, read by render thread for the same frame */
+	TSteamVRFrameMailbox<FSteamVRTrackedDeviceLateUpdateData> Mailbox;
+
+	/** Game thread. Copy current component transform and GameThreadData to mailbox. */
+	void Publish(uint32 FrameNumber, const USceneComponent* Component);
+
+	/** Component calls it in BeginDestroy */
+	void MarkComponentDestroyed() { bComponentAlive.store(false, std::memory_order_release); }
+	bool IsComponentAlive() const { return bComponentAlive.load(std::memory_order_acquire); }
+
+	/**
+	* Calculate relative transform before and after late update from the late update pose snapshot.
+	* Returns false if device isn't tracked.
+	*/
+	bool GetLateUpdateTransforms_RenderThread(const FSceneViewFamily& InViewFamily, FTransform& OutOldTransform, FTransform& OutNewTransform) const;
+
+private:
+	FSteamVRTrackingLibModule* TrackingLibModule;
+	std::atomic<bool> bComponentAlive;
+};
@@ -0,0 +1,84 @@
+// (c) YuriNK (ykasczc@gmail.com), 2020. You're free to use it whatever way you want.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/ObjectMacros.h"
+#include "Components/SceneComponent.h"
+#include "SteamVRTrackingLib.h"
+#include "SteamVRTrackedDeviceUpdater.h"
+#include "SteamVRTrackedDeviceSceneComponent.generated.h"
+
+class UPrimitiveComponent;
+
+/**
+* Tracked device as scene component: same tracking, late update and display model as USteamVRTrackedDeviceComponent,
+* but without primitive scene proxy, bounds and collision. Late update is applied to attached primitives.
+*/
+UCLASS(Blueprintable, meta = (BlueprintSpawnableComponent), ClassGroup = SteamVR)
+class STEAMVRTRACKINGLIB_API USteamVRTrackedDeviceSceneComponent : public USceneComponent
+{
+	GENERATED_UCLASS_BODY()
+
+	void BeginDestroy() override;
+
+	/** Tracked device, pose prediction and display model. Use setters below to change device, player and display model at runtime. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "SteamVR Tracked Device", meta = (ShowOnlyInnerProperties))
+	FSteamVRTrackedDeviceSettings TrackingSettings;
+
+	/** The tracking status for the device (e.g. full tracking, inertial tracking only, no tracking) */
+	UPROPERTY(BlueprintReadOnly, Category = "SteamVR Tracked Device")
+	ETrackingStatus CurrentTrackingStatus;
+
+	void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction *ThisTickFunction) override;
+
+	/** Whether or not this component had a valid tracked device this frame */
+	UFUNCTION(BlueprintPure, Category = "SteamVR Tracked Device")
+	bool IsTracked() const
+	{
+		return Updater.IsTracked();
+	}
+
+	UFUNCTION(BlueprintCallable, Category = "Visualization")
+	void SetShowDeviceModel(const bool bShowControllerModel);
+
+	UFUNCTION(BlueprintCallable, Category = "SteamVR Tracked Device")
+	void SetTrackedDeviceName(const FName NewSource);
+
+	UFUNCTION(BlueprintCallable, Category = "SteamVR Tracked Device")
+	void SetAssociatedPlayerIndex(const int32 NewPlayer);
+
+public:
+
+#if WITH_EDITOR
+	virtual void PreEditChange(FProperty* PropertyAboutToChange) override;
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif 
+
+public:
+	//~ UActorComponent interface
+	virtual void OnRegister() override;
+	virtual void InitializeComponent() override;
+	virtual void OnComponentDestroyed(bool bDestroyingHierarchy) override;
+
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+protected:
+	void RefreshDisplayComponent(const bool bForceDestroy = false);
+
+private:
+	/** Device polling, late update and display model */
+	FSteamVRTrackedDeviceUpdater Updater;
+
+	/** Called from TickComponent or by USteamVRTrackingSubsystem */
+	void UpdateTrackedDevice(float WorldToMetersScale);
+
+	UPROPERTY(Transient, BlueprintReadOnly, Category=Visualization, meta=(AllowPrivateAccess="true"))
+	UPrimitiveComponent* DisplayComponent;
+
+	/** Callback for asynchronous display model loads (to set materials, etc.) */
+	void OnDisplayModelLoaded(UPrimitiveComponent* DisplayComponent);
+
+	FXRComponentLoadComplete GetLoadCompleteDelegate();
+};
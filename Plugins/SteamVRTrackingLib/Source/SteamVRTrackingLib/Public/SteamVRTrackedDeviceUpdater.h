@@ -0,0 +1,216 @@
+// (c) YuriNK (ykasczc@gmail.com), 2020. You're free to use it whatever way you want.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/ObjectMacros.h"
+#include "IIdentifiableXRDevice.h"
+#include "IXRSystemAssets.h"
+#include "HeadMountedDisplayTypes.h"
+#include "SteamVRTrackedDeviceRenderState.h"
+#include "SteamVRTrackedDeviceUpdater.generated.h"
+
+class FSteamVRTrackingLibModule;
+class UActorComponent;
+class UMaterialInterface;
+class UPrimitiveComponent;
+class USceneComponent;
+struct FPropertyChangedEvent;
+
+/** How tracked device component extrapolates pose */
+UENUM(BlueprintType)
+enum class ESteamVRPosePrediction : uint8
+{
+	/** Use pose as it was sampled */
+	None,
+	/** Extrapolate by fixed PredictionTime */
+	Fixed,
+	/** Extrapolate to the moment frame is displayed on HMD, estimated from display timing */
+	FrameTiming
+};
+
+/** Tracked device properties of USteamVRTrackedDeviceSceneComponent. USteamVRTrackedDeviceComponent keeps them as its own properties and copies them here. */
+USTRUCT(BlueprintType)
+struct STEAMVRTRACKINGLIB_API FSteamVRTrackedDeviceSettings
+{
+	GENERATED_USTRUCT_BODY()
+
+	/** Which player index this motion controller should automatically follow. Use SetAssociatedPlayerIndex of component at runtime. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "SteamVR Tracked Device")
+	int32 PlayerIndex;
+
+	/**
+	* It can me an user-friendly name associated with serial number or standard MotionSource like Left, Right, Special_X.
+	* Use SetTrackedDeviceName of component at runtime.
+	*/
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "SteamVR Tracked Device")
+	FName TrackedDeviceName;
+
+	/**
+	* Force SteamVR Device ID update each N seconds. Negative value to disable, 0 to update in every tick.
+	* Not required normally: IDs are updated on the next frame after device reconnects.
+	*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta=(DisplayName="SteamVR ID Update Interval"), Category = "SteamVR Tracked Device")
+	float SteamVRIdUpdateInterval;
+
+	/** If false, render transforms within the motion controller hierarchy will be updated a second time immediately before rendering. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SteamVR Tracked Device")
+	bool bDisableLowLatencyUpdate;
+
+	/** Extrapolate pose from device velocity and angular velocity to hide tracking latency. Applied to game thread and late update poses. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SteamVR Tracked Device")
+	ESteamVRPosePrediction PosePrediction;
+
+	/** Look-ahead time (seconds) for Fixed pose prediction */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SteamVR Tracked Device", meta = (EditCondition = "PosePrediction == ESteamVRPosePrediction::Fixed", ClampMin = "0.0", ClampMax = "0.1", UIMin = "0.0", UIMax = "0.1"))
+	float PredictionTime;
+
+	/** Keep last good pose (and IsTracked) for this time (seconds) when device loses tracking, e.g. when tracker is occluded. 0 to disable. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SteamVR Tracked Device", meta = (ClampMin = "0.0", UIMin = "0.0", UIMax = "1.0"))
+	float DropoutHoldTime;
+
+	/** Extrapolate held pose from velocity of the last good pose (at most 0.1 second) instead of freezing it */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SteamVR Tracked Device", meta = (EditCondition = "DropoutHoldTime > 0.0"))
+	bool bExtrapolateDropout;
+
+	/** Used to automatically render a model associated with the set hand. Use SetShowDeviceModel of component at runtime. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Visualization")
+	bool bDisplayDeviceModel;
+
+	/** Determines the source of the desired model. Only SteamVR is supported. */
+	UPROPERTY(BlueprintReadOnly, Category = "Visualization")
+	FName DisplayModelSource;
+
+	/** Material overrides for the specified display mesh. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Visualization", meta = (EditCondition = "bDisplayDeviceModel"))
+	TArray<UMaterialInterface*> DisplayMeshMaterialOverrides;
+
+	FSteamVRTrackedDeviceSettings()
+		: PlayerIndex(0)
+		, TrackedDeviceName(TEXT("Right"))
+		, SteamVRIdUpdateInterval(-1.f)
+		, bDisableLowLatencyUpdate(false)
+		, PosePrediction(ESteamVRPosePrediction::None)
+		, PredictionTime(0.011f)
+		, DropoutHoldTime(0.2f)
+		, bExtrapolateDropout(false)
+		, bDisplayDeviceModel(false)
+		, DisplayModelSource(TEXT("SteamVR"))
+	{}
+};
+
+/** Called by USteamVRTrackingSubsystem to poll and move tracked device component. Arg is WorldToMeters. */
+DECLARE_DELEGATE_OneParam(FSteamVRTrackedDeviceUpdate, float);
+
+/**
+* Everything tracked device components do besides being a component: device ID resolution, pose polling,
+* late update registration and display model. Shared by USteamVRTrackedDeviceComponent (primitive)
+* and USteamVRTrackedDeviceSceneComponent (scene component without render state), which only forward their events here.
+* DisplayComponent args should be a UPROPERTY of the component. Game thread only.
+*/
+class STEAMVRTRACKINGLIB_API FSteamVRTrackedDeviceUpdater
+{
+public:
+	/** Tracking module is loaded on the first poll if it isn't specified */
+	explicit FSteamVRTrackedDeviceUpdater(FSteamVRTrackingLibModule* InTrackingLibModule = nullptr);
+
+	/** BeginPlay: all tracked components of the world are updated by USteamVRTrackingSubsystem, so component tick is disabled */
+	void BeginPlay(UActorComponent* Component, const FSteamVRTrackedDeviceUpdate& UpdateDelegate);
+	void EndPlay(UActorComponent* Component);
+
+	/** Poll pose, move component, refresh display model if tracking kicked in and pass device ID to late update */
+	void Update(USceneComponent* Component, const FSteamVRTrackedDeviceSettings& Settings, float WorldToMetersScale,
+		UPrimitiveComponent*& DisplayComponent, const FXRComponentLoadComplete& LoadCompleteDelegate);
+
+	/** If true, the Position and Orientation args will contain the most recent controller state */
+	bool PollControllerState(const USceneComponent* Component, const FSteamVRTrackedDeviceSettings& Settings, FVector& Position, FRotator& Orientation, float WorldToMetersScale);
+
+	/** Poll pose and move Component if it changed more than tolerance below. Returns false if device isn't tracked. */
+	bool UpdateComponentPose(USceneComponent* Component, const FSteamVRTrackedDeviceSettings& Settings, float WorldToMetersScale);
+
+	/** Smaller pose changes don't move component (cm and degrees) */
+	static constexpr float PoseLocationTolerance = 0.01f;
+	static constexpr float PoseRotationTolerance = 0.01f;
+
+	/** Register component for late update and pass it device ID resolved in the last PollControllerState */
+	void UpdateRenderState(USceneComponent* Component, const FSteamVRTrackedDeviceSettings& Settings);
+
+	/** Stop late update. Component calls it in BeginDestroy. */
+	void Release();
+
+	/** Register component in motion delay service for its player and device (if it's already initialized in game world) */
+	void RegisterDelayTarget(USceneComponent* Component, const FSteamVRTrackedDeviceSettings& Settings);
+
+	/** Create, update or hide display model attached to Component */
+	void RefreshDisplayComponent(USceneComponent* Component, const FSteamVRTrackedDeviceSettings& Settings, bool bForceDestroy,
+		UPrimitiveComponent*& DisplayComponent, const FXRComponentLoadComplete& LoadCompleteDelegate);
+
+	/** Setter of bDisplayDeviceModel */
+	void SetShowDeviceModel(USceneComponent* Component, FSteamVRTrackedDeviceSettings& Settings, bool bShowDeviceModel,
+		UPrimitiveComponent*& DisplayComponent, const FXRComponentLoadComplete& LoadCompleteDelegate);
+
+	/** Component's display model load callback should forward here */
+	void OnDisplayModelLoaded(UPrimitiveComponent* InDisplayComponent, const UPrimitiveComponent* DisplayComponent, const FSteamVRTrackedDeviceSettings& Settings);
+
+#if WITH_EDITOR
+	void PreEditChange(const FSteamVRTrackedDeviceSettings& Settings);
+	void PostEditChangeProperty(USceneComponent* Component, const FSteamVRTrackedDeviceSettings& Settings, const FPropertyChangedEvent& PropertyChangedEvent,
+		UPrimitiveComponent*& DisplayComponent, const FXRComponentLoadComplete& LoadCompleteDelegate);
+#endif
+
+	FSteamVRTrackingLibModule* GetTrackingLibModule() const { return TrackingLibModule; }
+
+	/** Device ID resolved in the last PollControllerState */
+	int32 GetCurrentDeviceId() const { return CurrentDeviceId; }
+
+	/** Whether the device was tracked in the last Update */
+	bool IsTracked() const { return bTracked; }
+
+	/** Tracking status of the device in the last PollControllerState */
+	ETrackingStatus GetTrackingStatus() const { return TrackingStatus; }
+
+private:
+	FSteamVRTrackingLibModule* TrackingLibModule;
+
+	/** Whether or not this component has authority within the frame*/
+	bool bHasAuthority;
+	/** Whether or not this component had a valid tracked controller associated with it this frame*/
+	bool bTracked;
+
+	float NextIdUpdateTime;
+	int32 CurrentDeviceId;
+	ETrackingStatus TrackingStatus;
+
+	/** TrackedDeviceName is only checked when it changes */
+	FName CheckedDeviceName;
+	bool bDeviceNameIsMotionSource;
+
+	/** Last good pose of the device if it lost tracking not longer than DropoutHoldTime ago */
+	bool GetDropoutPose(const FSteamVRTrackedDeviceSettings& Settings, FVector& Position, FRotator& Orientation, float WorldToMetersScale, float PredictionSeconds);
+
+	/** Cached render model requested by RefreshDisplayComponent finished loading, so it should be called again */
+	bool IsPendingDisplayModelLoaded() const;
+
+	/** Data shared with render thread for late update */
+	TSharedPtr<FSteamVRTrackedDeviceRenderState, ESPMode::ThreadSafe> RenderState;
+
+	enum class EModelLoadStatus : uint8
+	{
+		Unloaded,
+		Pending,
+		InProgress,
+		Complete
+	};
+	EModelLoadStatus DisplayModelLoadState;
+
+	FXRDeviceId DisplayDeviceId;
+
+	/** Render model of DisplayComponent instanced from FSteamVRRenderModelCache */
+	FName DisplayModelName;
+	/** Render model which is still loading in FSteamVRRenderModelCache */
+	FName PendingModelName;
+
+#if WITH_EDITOR
+	int32 PreEditMaterialCount = 0;
+#endif
+};
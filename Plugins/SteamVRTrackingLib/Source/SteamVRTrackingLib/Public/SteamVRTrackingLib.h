@@ -4,6 +4,33 @@
 
 #include "Modules/ModuleManager.h"
 #include "SteamVRTrackingSetup.h"
+#include "SteamVRDeviceSource.h"
+#include "SteamVRDevicePoseCache.h"
+#include "SteamVRDeviceRegistry.h"
+#include "SteamVRMotionSourceResolver.h"
+#include "SteamVRTrackingSampler.h"
+#include "SteamVRTrackingRecorder.h"
+#include "SteamVRTrackingSetupWatcher.h"
+#include "SteamVRRenderModelCache.h"
+
+class FSteamVRTrackingViewExtension;
+
+enum class ESteamVRDeviceChange : uint8
+{
+	Activated,
+	Deactivated,
+	/* Controller was assigned to another hand */
+	RoleChanged
+};
+
+struct FSteamVRDeviceTopologyChange
+{
+	int32 DeviceId;
+	ESteamVRDeviceChange Change;
+};
+
+/* Changes are empty if device index was rebuilt for other reason (new tracking setup or device source) */
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnSteamVRDeviceTopologyChanged, const TArray<FSteamVRDeviceTopologyChange>&);
 
 class FSteamVRTrackingLibModule : public IModuleInterface
 {
@@ -13,13 +40,144 @@ public:
 	virtual void StartupModule() override;
 	virtual void ShutdownModule() override;
 
+	static inline FSteamVRTrackingLibModule& Get()
+	{
+		return FModuleManager::LoadModuleChecked<FSteamVRTrackingLibModule>(TEXT("SteamVRTrackingLib"));
+	}
+
+	/* Game and render threads. Device table is only updated on game thread, render thread gets IDs resolved in the last update. */
 	int32 GetTrackedDeviceIdByName(const FName& FriendlyName, bool bForceUpdateId = false);
 	void GetTrackedDeviceSetupByName(const FName& FriendlyName, FSteamVRDeviceBindingSetup& OutData) const;
 
+	/* Game and render threads, lock-free. Bindings of the current tracking setup with resolved device IDs, valid until the end of frame. */
+	const FSteamVRDeviceRegistrySnapshot& GetDeviceRegistry() const { return DeviceRegistry.Read(); }
+
 	/* Initialize SerialNumber-to-FriendlyName bindings from USteamVRTrackingSetup object */
 	void InitializeTrackingNames(const USteamVRTrackingSetup* SteamVRTrackingSetup);
 	void InitializeTrackingNamesFromArray(const TArray<FSteamVRDeviceBindingSetup>& SteamVRTrackingDevices);
 
+	/*
+	* Replace tracking setup without rescanning devices: bindings of unchanged serial numbers keep their IDs.
+	* Topology version only changes if any friendly name now refers to another device.
+	*/
+	void ReloadTrackingNamesFromArray(const TArray<FSteamVRDeviceBindingSetup>& SteamVRTrackingDevices);
+
+	/* Poses of all devices fetched once per frame. Use it instead of USteamVRFunctionLibrary::GetTrackedDevicePositionAndOrientation */
+	FSteamVRDevicePoseCache& GetPoseCache() { return PoseCache; }
+
+	/* Find connected device by serial number. Serial numbers are indexed only when set of connected devices changes. */
+	int32 GetTrackedDeviceIdBySerialNumber(const FName& SerialNumber, ESteamVRTrackedDeviceType DeviceType = ESteamVRTrackedDeviceType::Invalid);
+
+	/* Serial number of connected device or nullptr */
+	const ANSICHAR* GetTrackedDeviceSerialNumber(int32 DeviceId);
+
+	/* Sorted IDs of connected devices of the specified type */
+	const TArray<int32>& GetConnectedDeviceIds(ESteamVRTrackedDeviceType DeviceType);
+
+	/* Connected controller assigned to the hand or INDEX_NONE */
+	int32 GetDeviceIdByControllerRole(ESteamVRControllerRole Role);
+
+	/*
+	* Incremented every time set of connected devices or controller roles change. Device table is checked once per frame,
+	* so cached device IDs only need to be resolved again when the version changes.
+	*/
+	uint32 GetDeviceTopologyVersion();
+
+	/* Broadcast at the end of frame in which devices were connected, disconnected or reassigned */
+	FOnSteamVRDeviceTopologyChanged& OnDeviceTopologyChanged() { return DeviceTopologyChanged; }
+
+	/* Cached MotionSource -> Device ID mapping */
+	FSteamVRMotionSourceResolver& GetMotionSourceResolver() { return *MotionSourceResolver; }
+
+	/* Optional high-rate pose sampling thread. Not running until StartSampling is called. */
+	FSteamVRTrackingSampler& GetTrackingSampler() { return *TrackingSampler; }
+
+	/* Writes samples of tracking sampler to binary session file */
+	FSteamVRTrackingRecorder& GetTrackingRecorder() { return *TrackingRecorder; }
+
+	/* Reloads tracking setup JSON file when it's modified */
+	FSteamVRTrackingSetupWatcher& GetTrackingSetupWatcher() { return *TrackingSetupWatcher; }
+
+	/* Game thread. Shared render models for display components. Created on first request. */
+	FSteamVRRenderModelCache& GetRenderModelCache();
+
+	/*
+	* Replace source of device poses and serial numbers (OpenVR by default, or simulated one with -SteamVRSimulation).
+	* Stops background sampling and recording.
+	*/
+	void SetDeviceSource(const TSharedPtr<ISteamVRDeviceSource, ESPMode::ThreadSafe>& InDeviceSource);
+	const TSharedPtr<ISteamVRDeviceSource, ESPMode::ThreadSafe>& GetDeviceSource() const { return PoseCache.GetSharedDeviceSource(); }
+
+	/* Shared late update view extension for all tracked device components. Created on first request. */
+	const TSharedPtr<FSteamVRTrackingViewExtension, ESPMode::ThreadSafe>& GetTrackingViewExtension();
+
 private:
+	/* Max length of SteamVR serial number we store in index */
+	static constexpr int32 MaxSerialNumberLength = 64;
+
+	struct FIndexedDevice
+	{
+		ANSICHAR SerialNumber[MaxSerialNumberLength];
+		/* Only valid if serial number was already interned, i.e. it's used in tracking setup */
+		FName SerialName;
+		ESteamVRTrackedDeviceType Type;
+		ESteamVRControllerRole Role;
+	};
+
+	/* Game thread copy of tracking setup, published to DeviceRegistry with resolved IDs */
 	TMap<FName, FSteamVRDeviceBindingSetup> DeviceSetup;
+	FSteamVRDeviceRegistry DeviceRegistry;
+	FSteamVRDevicePoseCache PoseCache;
+
+	/* Serial number -> device index */
+	TMap<FName, int32> SerialToDeviceId;
+	/* Device index -> serial number */
+	FIndexedDevice IndexedDevices[FSteamVRDevicePoseCache::MaxDevices];
+	uint64 IndexedDevicesMask;
+	/* Filters applied to PoseCache, only changed ones are reset when bindings are updated */
+	FSteamVRPoseFilterSettings DeviceFilters[FSteamVRDevicePoseCache::MaxDevices];
+	/* Serial number of the device bound to DeviceFilters */
+	FName DeviceFilterSerials[FSteamVRDevicePoseCache::MaxDevices];
+	/* Tracking setup changed, so serial numbers should be indexed again */
+	bool bDeviceIndexDirty;
+	uint32 DeviceTopologyVersion;
+	/* Frame in which connected devices were last checked */
+	uint64 DeviceIndexFrame;
+	/* Accumulated until the end of frame */
+	TArray<FSteamVRDeviceTopologyChange> PendingTopologyChanges;
+	TArray<FSteamVRDeviceTopologyChange> BroadcastTopologyChanges;
+	bool bTopologyChangePending;
+	FOnSteamVRDeviceTopologyChanged DeviceTopologyChanged;
+
+	TArray<int32> ConnectedControllers;
+	TArray<int32> ConnectedTrackers;
+	TArray<int32> ConnectedTrackingReferences;
+	TArray<int32> NoDevices;
+
+	TUniquePtr<FSteamVRMotionSourceResolver> MotionSourceResolver;
+	TSharedPtr<FSteamVRTrackingViewExtension, ESPMode::ThreadSafe> TrackingViewExtension;
+	TUniquePtr<FSteamVRTrackingSampler> TrackingSampler;
+	TUniquePtr<FSteamVRTrackingRecorder> TrackingRecorder;
+	TUniquePtr<FSteamVRTrackingSetupWatcher> TrackingSetupWatcher;
+	TUniquePtr<FSteamVRRenderModelCache> RenderModelCache;
+	FDelegateHandle EndFrameHandle;
+
+	/* Device source requested in command line */
+	TSharedPtr<ISteamVRDeviceSource, ESPMode::ThreadSafe> CreateDefaultDeviceSource() const;
+
+	/*
+	* Once per frame: rebuild serial numbers index if set of connected devices changed, check controller roles.
+	* At the end of frame pose snapshot isn't refreshed, so the first pose read of the next frame takes it.
+	*/
+	void UpdateDeviceIndex(bool bEndOfFrame = false);
+	void RebuildDeviceIndex(uint64 ConnectedMask);
+	bool UpdateControllerRoles();
+
+	/* Publish tracking setup bindings with resolved device IDs and assign their pose filters to connected devices */
+	void UpdateDeviceBindings();
+	int32 FindBindingDeviceId(const FSteamVRDeviceBindingSetup& Binding) const;
+	void CopyTrackingNames(const TArray<FSteamVRDeviceBindingSetup>& SteamVRTrackingDevices);
+
+	/* Processes device table even if nothing requested it during the frame and notifies listeners */
+	void OnEndFrame();
 };
@@ -22,18 +22,57 @@ public:
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "SteamVR Tracking Library Extended")
 	static FString GetTrackedDeviceSerialNumber(int32 DeviceID);
 
+	/** Same as comparing with GetTrackedDeviceSerialNumber, but without string allocation */
+	static bool IsTrackedDeviceSerialNumber(int32 DeviceID, const FName& SerialNumber);
+
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "SteamVR Tracking Library Extended")
 	static FName GetTrackedDeviceSerialNumberByName(const FName& DeviceFriendlyName);
 
 	UFUNCTION(BlueprintCallable, BlueprintPure, meta = (DisplayName = "Get Tracked Device ID by Friendly Name"), Category = "SteamVR Tracking Library Extended")
 	static int32 GetTrackedDeviceIdByName(const FName& FriendlyName, bool bForceUpdateID = false);
 
+	/** Poll all devices in a separate thread at SampleRate (Hz). Samples are available to C++ code through FSteamVRTrackingSampler. */
+	UFUNCTION(BlueprintCallable, Category = "SteamVR Tracking Library Extended")
+	static void SetBackgroundSamplingEnabled(bool bEnabled, float SampleRate = 500.f, int32 BufferSize = 256);
+
+	/** Latest pose of the device sampled by background sampling thread. Position is in Unreal units. */
+	UFUNCTION(BlueprintCallable, Category = "SteamVR Tracking Library Extended")
+	static bool GetLatestSampledDevicePose(int32 DeviceID, FVector& Position, FRotator& Orientation, float WorldToMetersScale = 100.f);
+
+	/** Tracking dropouts of the device since it was connected or since the last ResetTrackingDropoutStats. Durations are in seconds. */
+	UFUNCTION(BlueprintCallable, Category = "SteamVR Tracking Library Extended")
+	static bool GetTrackedDeviceDropoutStats(int32 DeviceID, int32& DropoutCount, float& TotalDropoutTime, float& LongestDropoutTime, bool& bInDropout);
+
+	UFUNCTION(BlueprintCallable, Category = "SteamVR Tracking Library Extended")
+	static void ResetTrackingDropoutStats();
+
+	/** Start loading render models of all connected devices, e.g. on loading screen. Models are loaded asynchronously and shared by display components. */
+	UFUNCTION(BlueprintCallable, Category = "SteamVR Tracking Library Extended", meta = (WorldContext = "WorldContextObject"))
+	static void PrewarmDeviceRenderModels(UObject* WorldContextObject);
+
+	/**
+	* Record all device poses at background sampling rate to binary file. Relative file names are saved to Saved/TrackingSessions.
+	* Starts background sampling if it isn't enabled.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "SteamVR Tracking Library Extended")
+	static bool StartTrackingSessionRecording(const FString& FileName);
+
+	UFUNCTION(BlueprintCallable, Category = "SteamVR Tracking Library Extended")
+	static void StopTrackingSessionRecording();
+
 	UFUNCTION(BlueprintCallable, meta = (DisplayName = "Set SteamVR Tracking Setup"), Category = "SteamVR Tracking Library Extended")
 	static bool SetSteamVRTrackingSetup(class USteamVRTrackingSetup* TrackingSetup);
 
 	UFUNCTION(BlueprintCallable, meta = (DisplayName = "Load SteamVR Tracking Setup from File"), Category = "SteamVR Tracking Library Extended")
 	static bool LoadSteamVRTrackingSetupFromFile(const FString& ImportFileName);
 
+	/**
+	* Load tracking setup from file and reload it every time the file is modified. File is parsed in background,
+	* and devices with unchanged serial numbers keep their IDs. Invalid file doesn't replace the current setup.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "SteamVR Tracking Library Extended")
+	static bool SetTrackingSetupFileWatching(bool bEnabled, const FString& FileName, float PollInterval = 1.f);
+
 	UFUNCTION(BlueprintCallable, Category = "SteamVR Tracking Library Extended")
 	static void ExportTrackingSetupToJSON(const TArray<FSteamVRDeviceBindingSetup>& TrackingSetup, const FString& ExportFileName);
 
@@ -0,0 +1,76 @@
+// (c) YuriNK (ykasczc@gmail.com), 2020. You're free to use it whatever way you want.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include "SteamVRTrackingRecording.h"
+#include "SteamVRTrackingSampler.h"
+#include <atomic>
+
+class FRunnableThread;
+class IFileHandle;
+
+/**
+* Streams every sample of FSteamVRTrackingSampler to a binary session file (see SteamVRTrackingRecording.h).
+* All file IO is done in the recorder thread, and memory use doesn't depend on session length
+* (except chunk index, 16 bytes per chunk).
+*/
+class STEAMVRTRACKINGLIB_API FSteamVRTrackingRecorder : public FRunnable
+{
+public:
+	/** Pose records per chunk */
+	static constexpr int32 ChunkCapacity = 4096;
+
+	FSteamVRTrackingRecorder(FSteamVRTrackingSampler& InSampler);
+	virtual ~FSteamVRTrackingRecorder();
+
+	/** Game thread. Starts background sampler if it isn't running. */
+	bool StartRecording(const FString& FileName);
+	/** Game thread. Flushes remaining samples and finalizes file. */
+	void StopRecording();
+	/** False after file write error, though recorder thread isn't stopped until StopRecording */
+	bool IsRecording() const { return Thread != nullptr && !HasWriteError(); }
+
+	/** File couldn't be written (e.g. disk is full), samples after it aren't recorded */
+	bool HasWriteError() const { return bWriteError.load(std::memory_order_relaxed); }
+
+	uint64 GetNumRecordedSamples() const { return NumRecordedSamples.load(std::memory_order_relaxed); }
+	/** Samples overwritten in sampler ring buffer before recorder thread could read them */
+	uint64 GetNumDroppedSamples() const { return NumDroppedSamples.load(std::memory_order_relaxed); }
+
+	/** FRunnable interface */
+	virtual uint32 Run() override;
+	virtual void Stop() override { bStopRequested.store(true); }
+
+private:
+	FSteamVRTrackingSampler& Sampler;
+	FRunnableThread* Thread;
+	std::atomic<bool> bStopRequested;
+	std::atomic<bool> bWriteError;
+	std::atomic<uint64> NumRecordedSamples;
+	std::atomic<uint64> NumDroppedSamples;
+
+	/** Recorder thread state */
+	TUniquePtr<IFileHandle> File;
+	SteamVRRecording::FFileHeader FileHeader;
+	SteamVRRecording::FChunkHeader ChunkHeader;
+	/** FChunkHeader followed by up to ChunkCapacity records, written with a single call */
+	TArray<uint8> ChunkBuffer;
+	TArray<SteamVRRecording::FDeviceEntry> DeviceTable;
+	TArray<SteamVRRecording::FChunkIndexEntry> ChunkIndex;
+	uint64 KnownDevicesMask;
+	uint64 NextSampleIndex;
+	/** Reused to avoid 7 KB stack copy */
+	FSteamVRPoseSample Sample;
+
+	/** Write to File, closing it on error. Returns false if file isn't written. */
+	bool WriteToFile(const void* Source, int64 Size);
+	void ReadNewSamples();
+	void WriteSample(uint64 SampleIndex);
+	void WriteNewDevices(uint64 SampleIndex, uint64 ConnectedMask);
+	void FlushChunk();
+	void FinalizeFile();
+
+	SteamVRRecording::FPoseRecord* GetRecords() { return reinterpret_cast<SteamVRRecording::FPoseRecord*>(ChunkBuffer.GetData() + sizeof(SteamVRRecording::FChunkHeader)); }
+};
@@ -0,0 +1,153 @@
+// (c) YuriNK (ykasczc@gmail.com), 2020. You're free to use it whatever way you want.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+/**
+* Binary tracking session format (.svrrec), little endian:
+*   FFileHeader
+*   Chunks: FChunkHeader + NumRecords * FPoseRecord, or FChunkHeader + NumRecords * FDeviceEntry for device chunks
+*   Device table: NumDevices * FDeviceEntry (copy of all device chunks, written on stop)
+*   Chunk index: NumChunks * FChunkIndexEntry (written on stop)
+* If the session wasn't closed properly, header offsets are zero and reader finds chunks by scanning the file.
+*/
+namespace SteamVRRecording
+{
+	constexpr uint32 FileMagic = 0x52525653; // "SVRR"
+	constexpr uint32 ChunkMagic = 0x4B4E4843; // "CHNK"
+	constexpr uint32 DeviceChunkMagic = 0x43564544; // "DEVC"
+	constexpr uint16 FormatVersion = 1;
+	constexpr int32 MaxSerialNumberLength = 64;
+
+	struct FFileHeader
+	{
+		uint32 Magic;
+		uint16 Version;
+		uint16 HeaderSize;
+		/** FPlatformTime::Seconds() at start, record timestamps are relative to chunk time */
+		double StartTime;
+		/** FDateTime::UtcNow() ticks at start */
+		int64 StartDateTimeTicks;
+		uint64 DeviceTableOffset;
+		uint64 ChunkIndexOffset;
+		uint32 NumDevices;
+		uint32 NumChunks;
+		uint64 NumSamples;
+	};
+	static_assert(sizeof(FFileHeader) == 56, "FFileHeader layout changed");
+
+	/** Device ID is reused by SteamVR, so the same ID can have several entries with different serial numbers */
+	struct FDeviceEntry
+	{
+		/** First sample where DeviceId belongs to this device */
+		uint64 FirstSampleIndex;
+		uint8 DeviceId;
+		/** ESteamVRTrackedDeviceType */
+		uint8 DeviceType;
+		uint16 Reserved[3];
+		ANSICHAR SerialNumber[MaxSerialNumberLength];
+	};
+	static_assert(sizeof(FDeviceEntry) == 80, "FDeviceEntry layout changed");
+
+	struct FChunkHeader
+	{
+		uint32 Magic;
+		uint32 NumRecords;
+		uint64 FirstSampleIndex;
+		uint64 LastSampleIndex;
+		/** FPlatformTime::Seconds() of the first sample in chunk */
+		double ChunkTime;
+	};
+	static_assert(sizeof(FChunkHeader) == 32, "FChunkHeader layout changed");
+
+	enum class ETrackingState : uint8
+	{
+		NotTracked,
+		InertialOnly,
+		Tracked
+	};
+
+	/** Pose of one device in one sample. Position in meters in tracking space. */
+	struct FPoseRecord
+	{
+		/** Microseconds since FChunkHeader::ChunkTime */
+		uint32 TimeOffset;
+		/** Sample index minus FChunkHeader::FirstSampleIndex */
+		uint16 SampleOffset;
+		uint8 DeviceId;
+		/** ETrackingState */
+		uint8 TrackingState;
+		float Position[3];
+		float Orientation[4];
+	};
+	static_assert(sizeof(FPoseRecord) == 36, "FPoseRecord layout changed");
+
+	struct FChunkIndexEntry
+	{
+		uint64 Offset;
+		double ChunkTime;
+	};
+	static_assert(sizeof(FChunkIndexEntry) == 16, "FChunkIndexEntry layout changed");
+}
+
+/**
+* Memory mapped reader of recorded tracking session. Records are accessed directly in the mapped file without copying.
+*/
+class STEAMVRTRACKINGLIB_API FSteamVRTrackingRecordingReader
+{
+public:
+	FSteamVRTrackingRecordingReader();
+	~FSteamVRTrackingRecordingReader();
+
+	bool Open(const FString& FileName);
+	void Close();
+	bool IsOpen() const { return Header != nullptr; }
+
+	const SteamVRRecording::FFileHeader& GetHeader() const { return *Header; }
+	TArrayView<const SteamVRRecording::FDeviceEntry> GetDevices() const { return Devices; }
+
+	int32 GetNumChunks() const { return ChunkIndex.Num(); }
+	const SteamVRRecording::FChunkHeader& GetChunkHeader(int32 Chunk) const;
+	TArrayView<const SteamVRRecording::FPoseRecord> GetChunkRecords(int32 Chunk) const;
+
+	/** Absolute FPlatformTime::Seconds() time of the record */
+	double GetRecordTime(int32 Chunk, const SteamVRRecording::FPoseRecord& Record) const;
+
+	/** Time range of the session */
+	double GetStartTime() const;
+	double GetEndTime() const;
+
+	/** Last chunk which starts not later than Time */
+	int32 FindChunk(double Time) const;
+
+	/** Last record of the device not later than Time. Returns nullptr if there is none. */
+	const SteamVRRecording::FPoseRecord* FindDeviceRecord(int32 DeviceId, double Time) const;
+
+	/** Device which had DeviceId at sample SampleIndex or nullptr */
+	const SteamVRRecording::FDeviceEntry* FindDevice(int32 DeviceId, uint64 SampleIndex) const;
+
+	/** Serial number of device with DeviceId at sample SampleIndex or nullptr */
+	const ANSICHAR* GetDeviceSerialNumber(int32 DeviceId, uint64 SampleIndex) const;
+
+private:
+	TUniquePtr<IMappedFileHandle> MappedFile;
+	TUniquePtr<IMappedFileRegion> MappedRegion;
+	const uint8* Data;
+	int64 DataSize;
+
+	const SteamVRRecording::FFileHeader* Header;
+	TArrayView<const SteamVRRecording::FDeviceEntry> Devices;
+	/** Point to mapped file, or to Scanned* arrays if file wasn't finalized */
+	TArrayView<const SteamVRRecording::FChunkIndexEntry> ChunkIndex;
+	TArray<SteamVRRecording::FChunkIndexEntry> ScannedChunkIndex;
+	TArray<SteamVRRecording::FDeviceEntry> ScannedDevices;
+
+	/** Build chunk index and device table by walking chunks from the beginning of the file */
+	void ScanChunks();
+	/** All chunks of finalized index are inside the file */
+	bool IsChunkIndexValid() const;
+};
@@ -0,0 +1,103 @@
+// (c) YuriNK (ykasczc@gmail.com), 2020. You're free to use it whatever way you want.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include "SteamVRDevicePoseCache.h"
+#include <atomic>
+
+class FRunnableThread;
+
+/** Poses of all devices polled at the same moment */
+struct FSteamVRPoseSample
+{
+	/** FPlatformTime::Seconds() when the sample was taken */
+	double Timestamp;
+	uint64 ConnectedMask;
+	FSteamVRDevicePose Poses[FSteamVRDevicePoseCache::MaxDevices];
+
+	FSteamVRPoseSample() : Timestamp(0.0), ConnectedMask(0) {}
+};
+
+/**
+* Dedicated thread polling all SteamVR device poses at fixed rate, independently of game and render frame rate.
+* Samples are kept in a lock-free ring buffer with single writer (sampler thread) and any number of readers.
+* Readers never block the writer: if the slot was overwritten while reading, the read fails (or retries for the latest sample).
+*/
+class STEAMVRTRACKINGLIB_API FSteamVRTrackingSampler : public FRunnable
+{
+public:
+	static constexpr float DefaultSampleRate = 500.f;
+	static constexpr float MaxSampleRate = 1000.f;
+	static constexpr int32 DefaultCapacity = 256;
+
+	FSteamVRTrackingSampler(FSteamVRDevicePoseCache& InPoseCache);
+	virtual ~FSteamVRTrackingSampler();
+
+	/**
+	* Start sampling thread. Capacity is rounded up to power of two. Restarts thread if it's already running.
+	* Start and stop are game thread only and shouldn't be called while other threads read samples.
+	* Sample rate is clamped to MaxSampleRate. The thread sleeps between samples and never spins, so CPU cost is one pose query per sample,
+	* but sample spacing depends on OS timer resolution (about 1 ms): real rate can be lower than requested near the limit, see sample timestamps.
+	*/
+	void StartSampling(float InSampleRate = DefaultSampleRate, int32 InCapacity = DefaultCapacity);
+	/** Stop sampling thread and wait for it. Collected samples are kept. */
+	void StopSampling();
+	bool IsRunning() const { return Thread != nullptr; }
+	float GetSampleRate() const { return SampleRate; }
+	uint64 GetCapacity() const { return Capacity; }
+	ISteamVRDeviceSource* GetDeviceSource() const { return PoseCache.GetDeviceSource(); }
+
+	/** Total number of samples taken since StartSampling */
+	uint64 GetNumSamples() const { return Head.load(std::memory_order_acquire); }
+
+	/** Copy the most recent sample of all devices. Returns false if nothing was sampled yet. */
+	bool GetLatestSample(FSteamVRPoseSample& OutSample) const;
+
+	/** Copy sample with the specified index. Returns false if it wasn't taken yet or was already overwritten. */
+	bool ReadSample(uint64 SampleIndex, FSteamVRPoseSample& OutSample) const;
+
+	/** Index of the oldest sample which is still safe to read */
+	uint64 GetOldestSampleIndex() const;
+
+	/** Most recent pose of a single device. OutTimestamp is optional. */
+	bool GetLatestPose(int32 DeviceId, FSteamVRDevicePose& OutPose, double* OutTimestamp = nullptr) const;
+
+	/**
+	* Interpolate pose of device at the specified FPlatformTime::Seconds() time.
+	* Returns false if requested time isn't covered by the buffer or device wasn't tracked around this time.
+	*/
+	bool GetPoseAtTime(int32 DeviceId, double Time, FSteamVRDevicePose& OutPose) const;
+
+	/** FRunnable interface */
+	virtual uint32 Run() override;
+	virtual void Stop() override { bStopRequested.store(true); }
+
+private:
+	struct FSlot
+	{
+		/** 2 * SampleIndex + 1 while writing, 2 * SampleIndex + 2 when sample is ready */
+		std::atomic<uint64> Sequence;
+		FSteamVRPoseSample Sample;
+
+		FSlot() : Sequence(0) {}
+	};
+
+	FSteamVRDevicePoseCache& PoseCache;
+	FRunnableThread* Thread;
+	std::atomic<bool> bStopRequested;
+	float SampleRate;
+
+	TUniquePtr<FSlot[]> Slots;
+	uint64 Capacity;
+	/** Number of published samples */
+	std::atomic<uint64> Head;
+
+	/** Sampler thread */
+	void TakeSample();
+
+	/** Copy timestamp and pose of one device from sample with the specified index. Returns false if slot was overwritten. */
+	bool ReadPose(uint64 SampleIndex, int32 DeviceId, double& OutTimestamp, FSteamVRDevicePose& OutPose) const;
+	bool ReadTimestamp(uint64 SampleIndex, double& OutTimestamp) const;
+};
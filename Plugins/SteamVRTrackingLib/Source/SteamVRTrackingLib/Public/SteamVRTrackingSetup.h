@@ -4,6 +4,7 @@
 
 #include "Engine/DataAsset.h"
 #include "SteamVRFunctionLibrary.h"
+#include "SteamVRPoseFilter.h"
 #include "SteamVRTrackingSetup.generated.h"
 
 USTRUCT(BlueprintType)
@@ -23,6 +24,10 @@ struct STEAMVRTRACKINGLIB_API FSteamVRDeviceBindingSetup
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SteamVR Device Setup")
 	FName FriendlyName;
 
+	/** Smoothing applied to the device pose before it's used by components and mocap */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SteamVR Device Setup")
+	FSteamVRPoseFilterSettings Filter;
+
 	FSteamVRDeviceBindingSetup()
 		: Type(ESteamVRTrackedDeviceType::Invalid)
 		, Id(INDEX_NONE)
@@ -0,0 +1,58 @@
+// (c) YuriNK (ykasczc@gmail.com), 2020. You're free to use it whatever way you want.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/Future.h"
+#include "Containers/Ticker.h"
+#include "SteamVRTrackingSetup.h"
+
+class FSteamVRTrackingLibModule;
+
+/** Tracking setup JSON format (see USteamVRTrackingLibBPLibrary::ExportTrackingSetupToJSON). Any thread. */
+struct STEAMVRTRACKINGLIB_API FSteamVRTrackingSetupJson
+{
+	/** Read devices with streaming reader, without building DOM */
+	static bool Parse(const FString& JsonString, TArray<FSteamVRDeviceBindingSetup>& OutBindings, int32& OutFormatVersion, FString& OutError);
+
+	/** Check if setup can replace the current one: friendly names should be unique */
+	static bool Validate(const TArray<FSteamVRDeviceBindingSetup>& Bindings, FString& OutError);
+};
+
+/**
+* Reloads tracking setup every time JSON file is modified (e.g. when tracker was given to another participant).
+* File modification time is checked on game thread every PollInterval seconds, file is read and parsed in thread pool.
+* Valid setup replaces the current one without rescanning devices, so IDs of unchanged serial numbers are kept.
+*/
+class STEAMVRTRACKINGLIB_API FSteamVRTrackingSetupWatcher
+{
+public:
+	FSteamVRTrackingSetupWatcher(FSteamVRTrackingLibModule& InTrackingLibModule);
+	~FSteamVRTrackingSetupWatcher();
+
+	/** Game thread. Load the file and keep watching it. Returns false if the file doesn't exist. */
+	bool StartWatching(const FString& InFileName, float InPollInterval = 1.f);
+	void StopWatching();
+	bool IsWatching() const { return TickerHandle.IsValid(); }
+	const FString& GetFileName() const { return FileName; }
+
+private:
+	struct FParseResult
+	{
+		TArray<FSteamVRDeviceBindingSetup> Bindings;
+		int32 FormatVersion = 0;
+		FString Error;
+		bool bSuccess = false;
+	};
+
+	FSteamVRTrackingLibModule& TrackingLibModule;
+	FString FileName;
+	FDateTime FileTimeStamp;
+	int64 FileSize;
+	FTSTicker::FDelegateHandle TickerHandle;
+	TFuture<FParseResult> PendingParse;
+
+	bool Tick(float DeltaTime);
+	void ApplyParseResult(const FParseResult& Result);
+	static FParseResult ParseFile(const FString& FileName);
+};
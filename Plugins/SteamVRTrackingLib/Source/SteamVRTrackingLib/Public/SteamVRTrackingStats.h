@@ -0,0 +1,71 @@
+// (c) YuriNK (ykasczc@gmail.com), 2020. You're free to use it whatever way you want.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "Trace/Trace.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include <atomic>
+
+/** Live figures: stat SteamVRTracking */
+DECLARE_STATS_GROUP(TEXT("SteamVRTracking"), STATGROUP_SteamVRTracking, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Pose Cache Refresh"), STAT_SteamVRTracking_PoseCacheRefresh, STATGROUP_SteamVRTracking, STEAMVRTRACKINGLIB_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Device Index Rebuild"), STAT_SteamVRTracking_DeviceIndexRebuild, STATGROUP_SteamVRTracking, STEAMVRTRACKINGLIB_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Motion Source Resolve"), STAT_SteamVRTracking_MotionSourceResolve, STATGROUP_SteamVRTracking, STEAMVRTRACKINGLIB_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Late Update (RT)"), STAT_SteamVRTracking_LateUpdate, STATGROUP_SteamVRTracking, STEAMVRTRACKINGLIB_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Late Update Lock Wait (RT)"), STAT_SteamVRTracking_LateUpdateLockWait, STATGROUP_SteamVRTracking, STEAMVRTRACKINGLIB_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Tracked Components Update"), STAT_SteamVRTracking_ComponentsUpdate, STATGROUP_SteamVRTracking, STEAMVRTRACKINGLIB_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Mocap Tick"), STAT_SteamVRTracking_MocapTick, STATGROUP_SteamVRTracking, STEAMVRTRACKINGLIB_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Mocap Solve"), STAT_SteamVRTracking_MocapSolve, STATGROUP_SteamVRTracking, STEAMVRTRACKINGLIB_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Mocap Solve Wait"), STAT_SteamVRTracking_MocapSolveWait, STATGROUP_SteamVRTracking, STEAMVRTRACKINGLIB_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Mocap Take Push"), STAT_SteamVRTracking_MocapTakePush, STATGROUP_SteamVRTracking, STEAMVRTRACKINGLIB_API);
+
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Pose Polls"), STAT_SteamVRTracking_PosePolls, STATGROUP_SteamVRTracking, STEAMVRTRACKINGLIB_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Device Source Queries"), STAT_SteamVRTracking_SourceQueries, STATGROUP_SteamVRTracking, STEAMVRTRACKINGLIB_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("ID Cache Misses"), STAT_SteamVRTracking_IdCacheMisses, STATGROUP_SteamVRTracking, STEAMVRTRACKINGLIB_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Serial Lookups"), STAT_SteamVRTracking_SerialLookups, STATGROUP_SteamVRTracking, STEAMVRTRACKINGLIB_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Late Update Lock Retries (RT)"), STAT_SteamVRTracking_LockRetries, STATGROUP_SteamVRTracking, STEAMVRTRACKINGLIB_API);
+
+/** Insights channel for CPU scopes of the plugin: -trace=cpu,SteamVRTracking */
+UE_TRACE_CHANNEL_EXTERN(SteamVRTrackingChannel, STEAMVRTRACKINGLIB_API);
+
+/** Per-frame counters, also published to Insights as SteamVRTracking/... counters */
+enum class ESteamVRTrackingCounter : uint8
+{
+	PosePolls,
+	SourceQueries,
+	IdCacheMisses,
+	SerialLookups,
+	LockRetries,
+	Num
+};
+
+class STEAMVRTRACKINGLIB_API FSteamVRTrackingCounters
+{
+public:
+	static void Add(ESteamVRTrackingCounter Counter, uint32 Value)
+	{
+		if (UE_TRACE_CHANNELEXPR_IS_ENABLED(SteamVRTrackingChannel))
+		{
+			Values[(int32)Counter].fetch_add(Value, std::memory_order_relaxed);
+		}
+	}
+
+	/** Game thread, end of frame. Sends counters to trace and resets them. */
+	static void PublishFrame();
+
+private:
+	static std::atomic<uint32> Values[(int32)ESteamVRTrackingCounter::Num];
+};
+
+/** Stat cycle counter and Insights CPU scope on SteamVRTracking channel */
+#define STEAMVR_TRACKING_SCOPE(Stat) \
+	SCOPE_CYCLE_COUNTER(Stat); \
+	TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL_STR(#Stat, SteamVRTrackingChannel)
+
+/** Increment stat counter and trace counter */
+#define STEAMVR_TRACKING_COUNT(Counter, Value) \
+	INC_DWORD_STAT_BY(STAT_SteamVRTracking_##Counter, Value); \
+	FSteamVRTrackingCounters::Add(ESteamVRTrackingCounter::Counter, Value)
@@ -0,0 +1,66 @@
+// (c) YuriNK (ykasczc@gmail.com), 2020. You're free to use it whatever way you want.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Engine/EngineBaseTypes.h"
+#include "SteamVRTrackedDeviceUpdater.h"
+#include "SteamVRTrackingSubsystem.generated.h"
+
+class USteamVRTrackingSubsystem;
+
+/** Single pre-physics tick of all tracked device components */
+USTRUCT()
+struct FSteamVRTrackingSubsystemTickFunction : public FTickFunction
+{
+	GENERATED_USTRUCT_BODY()
+
+	USteamVRTrackingSubsystem* Subsystem = nullptr;
+
+	virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent) override;
+	virtual FString DiagnosticMessage() override;
+};
+
+template<>
+struct TStructOpsTypeTraits<FSteamVRTrackingSubsystemTickFunction> : public TStructOpsTypeTraitsBase2<FSteamVRTrackingSubsystemTickFunction>
+{
+	enum
+	{
+		WithCopy = false
+	};
+};
+
+/**
+* Updates all tracked device components of the world in one tick instead of a tick per component.
+* Game thread pose snapshot and WorldToMeters are fetched once, and components which didn't move
+* don't update transforms of their children.
+* Render models of connected devices are prewarmed when world begins play.
+*/
+UCLASS()
+class STEAMVRTRACKINGLIB_API USteamVRTrackingSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+
+	/** Component should disable its own tick. Registered in BeginPlay. */
+	void RegisterTrackedDevice(USceneComponent* Component, const FSteamVRTrackedDeviceUpdate& UpdateDelegate);
+	void UnregisterTrackedDevice(USceneComponent* Component);
+
+	int32 GetNumTrackedDevices() const { return TrackedDevices.Num(); }
+
+	void Tick(float DeltaTime);
+
+private:
+	struct FTrackedDevice
+	{
+		TWeakObjectPtr<USceneComponent> Component;
+		FSteamVRTrackedDeviceUpdate Update;
+	};
+	TArray<FTrackedDevice> TrackedDevices;
+
+	FSteamVRTrackingSubsystemTickFunction TickFunction;
+};
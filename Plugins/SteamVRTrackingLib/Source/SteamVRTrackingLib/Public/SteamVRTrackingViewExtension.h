@@ -0,0 +1,67 @@
+// (c) YuriNK (ykasczc@gmail.com), 2020. You're free to use it whatever way you want.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SceneViewExtension.h"
+#include "SteamVRTrackedDeviceRenderState.h"
+
+class FLateUpdateManager;
+class USceneComponent;
+
+/**
+* One view extension for all tracked device components.
+* Late update for every registered component is done in a single render thread pass.
+*/
+class STEAMVRTRACKINGLIB_API FSteamVRTrackingViewExtension : public FSceneViewExtensionBase
+{
+public:
+	FSteamVRTrackingViewExtension(const FAutoRegister& AutoRegister);
+	virtual ~FSteamVRTrackingViewExtension() {}
+
+	/** Game thread. Start late update for the component. */
+	void RegisterComponent(USceneComponent* Component, const TSharedPtr<FSteamVRTrackedDeviceRenderState, ESPMode::ThreadSafe>& RenderState);
+
+	/** Game thread. Stop late update for the component. */
+	void UnregisterComponent(const TSharedPtr<FSteamVRTrackedDeviceRenderState, ESPMode::ThreadSafe>& RenderState);
+
+	int32 GetNumComponents() const { return Entries.Num(); }
+
+	/** ISceneViewExtension interface */
+	virtual void SetupViewFamily(FSceneViewFamily& InViewFamily) override {}
+	virtual void SetupView(FSceneViewFamily& InViewFamily, FSceneView& InView) override {}
+	virtual void BeginRenderViewFamily(FSceneViewFamily& InViewFamily) override;
+	virtual void PreRenderView_RenderThread(FRHICommandListImmediate& RHICmdList, FSceneView& InView) override {}
+	virtual void PreRenderViewFamily_RenderThread(FRHICommandListImmediate& RHICmdList, FSceneViewFamily& InViewFamily) override;
+	virtual int32 GetPriority() const override { return -10; }
+	virtual bool IsActiveThisFrame_Internal(const FSceneViewExtensionContext& Context) const override;
+
+private:
+	struct FRenderEntry
+	{
+		TSharedPtr<FSteamVRTrackedDeviceRenderState, ESPMode::ThreadSafe> RenderState;
+		TSharedPtr<FLateUpdateManager, ESPMode::ThreadSafe> LateUpdate;
+	};
+
+	struct FEntry : public FRenderEntry
+	{
+		/** Game thread only */
+		TWeakObjectPtr<USceneComponent> Component;
+	};
+
+	/** Game thread list */
+	TArray<FEntry> Entries;
+	bool bRenderEntriesDirty;
+
+	/** Render thread copy of Entries */
+	TArray<FRenderEntry> RenderEntries;
+
+	/** Render thread scratch buffers reused every frame */
+	struct FLateUpdateTransforms
+	{
+		FTransform OldTransform;
+		FTransform NewTransform;
+		bool bValid;
+	};
+	TArray<FLateUpdateTransforms> RenderTransforms;
+};
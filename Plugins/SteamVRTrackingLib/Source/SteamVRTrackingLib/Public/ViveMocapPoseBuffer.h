@@ -0,0 +1,47 @@
+// (c) YuriNK (ykasczc@gmail.com), 2020. You're free to use it whatever way you want.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Animation/PoseSnapshot.h"
+
+/**
+* Double-buffered local pose of capture mesh. Bone layout is shared by both buffers and only changes with skeleton,
+* so a new pose costs one transform array swap and readers take the published pose by reference. Game thread.
+*/
+class STEAMVRTRACKINGLIB_API FViveMocapPoseBuffer
+{
+public:
+	FViveMocapPoseBuffer();
+
+	/**
+	* Take local transforms of solved pose without copying them. Snapshot gets back buffer to be filled next time.
+	* Bone names are only taken from the first pose after Reset (or if number of bones changes), so call Reset when skeleton is changed.
+	*/
+	void Submit(FPoseSnapshot& Snapshot);
+
+	/** Copy published pose and bone names to snapshot, for requests from outside */
+	void CopyToSnapshot(FPoseSnapshot& Snapshot) const;
+
+	/**
+	* Copy published pose to snapshot which is updated from this buffer every frame. Bone names are only copied
+	* if SnapshotLayoutVersion differs from layout version, then it's updated. Use MAX_uint32 for a new snapshot.
+	*/
+	void CopyToSnapshot(FPoseSnapshot& Snapshot, uint32& SnapshotLayoutVersion) const;
+
+	bool IsValid() const { return bValid; }
+	const TArray<FName>& GetBoneNames() const { return BoneNames; }
+	const TArray<FTransform>& GetPose() const { return Buffers[ReadIndex]; }
+
+	/** Incremented every time bone layout changes, so cached bone indices can be validated */
+	uint32 GetLayoutVersion() const { return LayoutVersion; }
+
+	void Reset();
+
+private:
+	TArray<FName> BoneNames;
+	TArray<FTransform> Buffers[2];
+	int32 ReadIndex;
+	uint32 LayoutVersion;
+	bool bValid;
+};
@@ -0,0 +1,82 @@
+// (c) YuriNK (ykasczc@gmail.com), 2020. You're free to use it whatever way you want.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include "ViveMocapRecording.h"
+#include <atomic>
+
+class FRunnableThread;
+class IFileHandle;
+
+/**
+* Records captured poses to a mocap take file (see ViveMocapRecording.h).
+* Game thread only copies pose to preallocated ring, recorder thread does keyframe reduction, quantization and file IO.
+* Memory use is fixed when recording starts and doesn't depend on take length (except chunk index, 16 bytes per chunk).
+*/
+class STEAMVRTRACKINGLIB_API FViveMocapRecorder : public FRunnable
+{
+public:
+	/** Poses in ring, about 2.8 seconds at 90 FPS */
+	static constexpr int32 RingCapacity = 256;
+	/** Frames per chunk */
+	static constexpr int32 ChunkCapacity = 128;
+
+	FViveMocapRecorder();
+	virtual ~FViveMocapRecorder();
+
+	/** Game thread. Poses pushed later should have this bone layout. Tolerances are in degrees and cm. */
+	bool StartRecording(const FString& FileName, const TArray<FName>& InBoneNames, float InRotationTolerance = 0.05f, float InTranslationTolerance = 0.01f);
+	/** Game thread. Writes remaining poses and finalizes file. */
+	void StopRecording();
+	/** False after file write error, though recorder thread isn't stopped until StopRecording */
+	bool IsRecording() const { return Thread != nullptr && !HasWriteError(); }
+
+	/** File couldn't be written (e.g. disk is full), poses pushed after it are dropped */
+	bool HasWriteError() const { return bWriteError.load(std::memory_order_relaxed); }
+
+	/** Game thread. Copy local pose to ring. Returns false if pose was dropped because recorder thread is behind. */
+	bool PushPose(TArrayView<const FTransform> Pose, double Time);
+
+	uint64 GetNumRecordedFrames() const { return NumRecordedFrames.load(std::memory_order_relaxed); }
+	uint64 GetNumDroppedFrames() const { return NumDroppedFrames.load(std::memory_order_relaxed); }
+
+	/** FRunnable interface */
+	virtual uint32 Run() override;
+	virtual void Stop() override { bStopRequested.store(true); }
+
+private:
+	FRunnableThread* Thread;
+	std::atomic<bool> bStopRequested;
+	std::atomic<bool> bWriteError;
+	std::atomic<uint64> NumRecordedFrames;
+	std::atomic<uint64> NumDroppedFrames;
+
+	/** RingCapacity poses of NumBones transforms, written by game thread and read by recorder thread */
+	TArray<FTransform> Ring;
+	TArray<double> RingTimes;
+	int32 NumBones;
+	std::atomic<uint64> WriteIndex;
+	std::atomic<uint64> ReadIndex;
+
+	/** Recorder thread state */
+	TUniquePtr<IFileHandle> File;
+	ViveMocapRecording::FFileHeader FileHeader;
+	ViveMocapRecording::FChunkHeader ChunkHeader;
+	/** FChunkHeader followed by frames of up to ChunkCapacity poses, written with a single call */
+	TArray<uint8> ChunkBuffer;
+	int32 ChunkDataSize;
+	TArray<ViveMocapRecording::FChunkIndexEntry> ChunkIndex;
+	/** Values written last for every bone, as they're decoded */
+	TArray<FTransform> LastWrittenPose;
+	float CosHalfRotationTolerance;
+	float TranslationTolerance;
+
+	/** Write to File, closing it on error. Returns false if file isn't written. */
+	bool WriteToFile(const void* Source, int64 Size);
+	void ReadNewPoses();
+	void WriteFrame(const FTransform* Pose, double Time);
+	void FlushChunk();
+	void FinalizeFile();
+};
@@ -0,0 +1,133 @@
+// (c) YuriNK (ykasczc@gmail.com), 2020. You're free to use it whatever way you want.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+/**
+* Binary mocap take format (.vmrec), little endian:
+*   FFileHeader
+*   Bone table: NumBones * FBoneEntry
+*   Chunks: FChunkHeader + DataSize bytes of frames
+*   Chunk index: NumChunks * FChunkIndexEntry (written on stop)
+* Frame is FFrameHeader followed by NumBoneRecords bone records: uint16 bone index and ERecordFlags, then
+* quantized rotation (3 * uint16), translation (3 * float) and scale (3 * float) if flagged.
+* First frame of every chunk has all bones, other frames only have values changed more than tolerance since last written value,
+* so chunks are decoded independently. Local space transforms of the capture mesh bones.
+*/
+namespace ViveMocapRecording
+{
+	constexpr uint32 FileMagic = 0x43524D56; // "VMRC"
+	constexpr uint32 ChunkMagic = 0x4B4E4843; // "CHNK"
+	constexpr uint16 FormatVersion = 1;
+	constexpr int32 MaxBoneNameLength = 64;
+	constexpr int32 MaxBones = 0x1FFF;
+
+	struct FFileHeader
+	{
+		uint32 Magic;
+		uint16 Version;
+		uint16 HeaderSize;
+		uint32 NumBones;
+		uint32 NumChunks;
+		uint64 NumFrames;
+		uint64 ChunkIndexOffset;
+		/** FPlatformTime::Seconds() at start, frame times are relative to chunk time */
+		double StartTime;
+		/** FDateTime::UtcNow() ticks at start */
+		int64 StartDateTimeTicks;
+		/** Keyframe reduction tolerances, degrees and cm */
+		float RotationTolerance;
+		float TranslationTolerance;
+	};
+	static_assert(sizeof(FFileHeader) == 56, "FFileHeader layout changed");
+
+	struct FBoneEntry
+	{
+		ANSICHAR Name[MaxBoneNameLength];
+	};
+
+	struct FChunkHeader
+	{
+		uint32 Magic;
+		uint32 NumFrames;
+		uint64 FirstFrame;
+		/** FPlatformTime::Seconds() of the first frame in chunk */
+		double ChunkTime;
+		uint32 DataSize;
+		uint32 Reserved;
+	};
+	static_assert(sizeof(FChunkHeader) == 32, "FChunkHeader layout changed");
+
+	struct FFrameHeader
+	{
+		/** Microseconds since FChunkHeader::ChunkTime */
+		uint32 TimeOffset;
+		uint16 NumBoneRecords;
+		uint16 Reserved;
+	};
+	static_assert(sizeof(FFrameHeader) == 8, "FFrameHeader layout changed");
+
+	enum ERecordFlags : uint16
+	{
+		Record_Rotation = 1 << 15,
+		Record_Translation = 1 << 14,
+		Record_Scale = 1 << 13,
+		Record_BoneMask = MaxBones
+	};
+
+	/** Largest bone record: flags, rotation, translation and scale */
+	constexpr int32 MaxBoneRecordSize = sizeof(uint16) * 4 + sizeof(float) * 6;
+
+	struct FChunkIndexEntry
+	{
+		uint64 Offset;
+		double ChunkTime;
+	};
+	static_assert(sizeof(FChunkIndexEntry) == 16, "FChunkIndexEntry layout changed");
+
+	/** Smallest three components, 15 bits each, and index of the largest one in 48 bits */
+	STEAMVRTRACKINGLIB_API void QuantizeRotation(const FQuat& Rotation, uint16 OutPacked[3]);
+	STEAMVRTRACKINGLIB_API FQuat DequantizeRotation(const uint16 Packed[3]);
+}
+
+/**
+* Memory mapped reader of recorded mocap take. Frames are decoded one by one, so takes of any length can be read.
+*/
+class STEAMVRTRACKINGLIB_API FViveMocapTakeReader
+{
+public:
+	FViveMocapTakeReader();
+	~FViveMocapTakeReader();
+
+	bool Open(const FString& FileName);
+	void Close();
+	bool IsOpen() const { return Data != nullptr; }
+
+	const ViveMocapRecording::FFileHeader& GetHeader() const { return Header; }
+	const TArray<FName>& GetBoneNames() const { return BoneNames; }
+
+	/** Decode all frames in order. Visitor gets time since the first frame and local transforms of all bones. */
+	bool ReadFrames(TFunctionRef<void(double Time, TArrayView<const FTransform> Pose)> Visitor) const;
+
+private:
+	TUniquePtr<IMappedFileHandle> MappedFile;
+	TUniquePtr<IMappedFileRegion> MappedRegion;
+	const uint8* Data;
+	int64 DataSize;
+
+	ViveMocapRecording::FFileHeader Header;
+	TArray<FName> BoneNames;
+	/** Offsets of chunk headers, from chunk index or by scanning if file wasn't finalized */
+	TArray<uint64> ChunkOffsets;
+
+	/** Chunks aren't aligned in file */
+	ViveMocapRecording::FChunkHeader GetChunkHeader(int32 Chunk) const;
+	/** Whole chunk is inside the file */
+	bool IsChunkValid(uint64 Offset) const;
+	/** Build chunk offsets by walking chunks after bone table */
+	void ScanChunks();
+};